@@ -0,0 +1,62 @@
+#include <ByteBuffer.h>
+
+ByteBuffer::ByteBuffer(uint16_t max_size){
+  slots = max_size + 1;
+  arr = new uint8_t[slots];
+  insertIdx = 0;
+  removeIdx = 0;
+}
+
+ByteBuffer::~ByteBuffer(){
+  delete[] arr;
+}
+
+boolean ByteBuffer::insert(uint8_t val){
+  uint16_t next = insertIdx + 1;
+  if(next == slots){
+    next = 0;
+  }
+  if(next == removeIdx){
+    return false;
+  }
+  arr[insertIdx] = val;
+  insertIdx = next;
+  return true;
+}
+
+uint8_t ByteBuffer::remove(){
+  if(isEmpty()){
+    return 0xFF;
+  }
+  uint8_t val = arr[removeIdx];
+  uint16_t next = removeIdx + 1;
+  if(next == slots){
+    next = 0;
+  }
+  noInterrupts();
+  removeIdx = next;
+  interrupts();
+  return val;
+}
+
+boolean ByteBuffer::isEmpty(){
+  noInterrupts();
+  uint16_t insertAt = insertIdx;
+  interrupts();
+  return insertAt == removeIdx;
+}
+
+uint16_t ByteBuffer::getNumElements(){
+  noInterrupts();
+  uint16_t insertAt = insertIdx;
+  interrupts();
+  return count(insertAt, removeIdx);
+}
+
+uint16_t ByteBuffer::getMaxSize(){
+  return slots - 1;
+}
+
+uint16_t ByteBuffer::count(uint16_t insertAt, uint16_t removeAt){
+  return insertAt >= removeAt ? insertAt - removeAt : insertAt + slots - removeAt;
+}
@@ -0,0 +1,47 @@
+// File: ByteBuffer.h
+// Description: Defines a ring buffer of bytes that an interrupt fills
+// while the main loop empties it.
+
+/**
+ * The Byte Buffer holds up to 65535 bytes, unlike the Word Buffer
+ * whose size is limited to 255. Only the interrupt inserts and only
+ * the main loop removes, so each index is written on one side alone
+ * and no count is shared between them. The indices are two bytes wide,
+ * which the AVR cannot read or write in one instruction, so the main
+ * loop touches the insert index and writes the remove index with
+ * interrupts disabled. One slot more than the size is allocated, which
+ * keeps a full buffer apart from an empty one.
+ * @file ByteBuffer.h */
+
+#ifndef BYTE_BUFFER_H
+#define BYTE_BUFFER_H
+
+#include <Arduino.h>
+#include <new.h>
+
+class ByteBuffer{
+public:
+  /** The constructor.
+   * @param max_size The number of bytes the buffer holds. */
+  ByteBuffer(uint16_t max_size);
+  ~ByteBuffer();
+  /** Inserts a byte; called from the interrupt.
+   * @return False if the buffer was full and the byte was dropped. */
+  boolean insert(uint8_t val);
+  /** Removes the oldest byte; called from the main loop.
+   * @return The byte, or 0xFF if the buffer is empty. */
+  uint8_t remove();
+  boolean isEmpty();
+  uint16_t getNumElements();
+  uint16_t getMaxSize();
+private:
+  /** Gets the number of bytes held from the two indices. */
+  uint16_t count(uint16_t insertAt, uint16_t removeAt);
+
+  uint16_t slots;
+  volatile uint16_t insertIdx;
+  volatile uint16_t removeIdx;
+  volatile uint8_t *arr;
+};
+
+#endif //BYTE_BUFFER_H
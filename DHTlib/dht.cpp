@@ -1,11 +1,13 @@
 //
 //    FILE: dht.cpp
 //  AUTHOR: Rob Tillaart
-// VERSION: 0.1.13
+// VERSION: 0.1.14
 // PURPOSE: DHT Temperature & Humidity Sensor library for Arduino
 //     URL: http://arduino.cc/playground/Main/DHTLib
 //
 // HISTORY:
+// 0.1.14 added interrupt driven asynchronous read with fixed point results,
+//        the sketch owns the pin change vector and calls _edgeISR from it
 // 0.1.13 fix negative temperature
 // 0.1.12 support DHT33 and DHT44 initial version
 // 0.1.11 renamed DHTLIB_TIMEOUT
@@ -93,11 +95,148 @@ int dht::read(uint8_t pin)
     return DHTLIB_OK;
 }
 
+// return values:
+// DHTLIB_OK
+// DHTLIB_BUSY  another sensor is being read
+int dht::startRead(uint8_t pin, uint8_t retries)
+{
+    if (_active != NULL && _active != this) return DHTLIB_BUSY;
+    _active = this;
+    _pin = pin;
+    _retries = retries;
+    _pinReg = portInputRegister(digitalPinToPort(pin));
+    _pinMask = digitalPinToBitMask(pin);
+    _startWakeup();
+    return DHTLIB_OK;
+}
+
+// return values:
+// DHTLIB_OK
+// DHTLIB_BUSY
+// DHTLIB_IDLE
+// DHTLIB_ERROR_CHECKSUM
+// DHTLIB_ERROR_TIMEOUT
+int dht::update()
+{
+    uint32_t now = millis();
+    switch (_state)
+    {
+    case _WAKEUP:
+        // strictly greater so a full wakeup period has passed
+        if (now - _stateStart > DHTLIB_DHT_WAKEUP)
+        {
+            // RELEASE THE LINE AND CAPTURE THE EDGES IN THE BACKGROUND
+            for (uint8_t i = 0; i < 5; i++) bits[i] = 0;
+            _edges = 0;
+            _state = _CAPTURE;
+            _stateStart = now;
+            digitalWrite(_pin, HIGH);
+            pinMode(_pin, INPUT);
+            *digitalPinToPCMSK(_pin) |= _BV(digitalPinToPCMSKbit(_pin));
+            PCIFR = _BV(digitalPinToPCICRbit(_pin));
+            *digitalPinToPCICR(_pin) |= _BV(digitalPinToPCICRbit(_pin));
+        }
+        return DHTLIB_BUSY;
+
+    case _CAPTURE:
+        if (_edges >= DHTLIB_EDGES)
+        {
+            _stopCapture();
+            // TEST CHECKSUM
+            uint8_t sum = bits[0] + bits[1] + bits[2] + bits[3];
+            if (bits[4] != sum) return _finishRead(DHTLIB_ERROR_CHECKSUM);
+
+            // CONVERT AND STORE
+            humidityTenths = word(bits[0], bits[1]);
+            temperatureTenths = word(bits[2] & 0x7F, bits[3]);
+            if (bits[2] & 0x80)  // negative temperature
+            {
+                temperatureTenths = -temperatureTenths;
+            }
+            return _finishRead(DHTLIB_OK);
+        }
+        if (now - _stateStart > DHTLIB_CAPTURE_TIMEOUT)
+        {
+            _stopCapture();
+            return _finishRead(DHTLIB_ERROR_TIMEOUT);
+        }
+        return DHTLIB_BUSY;
+
+    case _WAIT_RETRY:
+        if (now - _stateStart >= DHTLIB_RETRY_INTERVAL)
+        {
+            _startWakeup();
+        }
+        return DHTLIB_BUSY;
+
+    default:
+        return DHTLIB_IDLE;
+    }
+}
+
+void dht::_edgeISR()
+{
+    dht *self = _active;
+    if (self == NULL || (*self->_pinReg & self->_pinMask)) return;
+
+    // FALLING EDGE: the interval since the previous one holds a bit
+    uint32_t now = micros();
+    uint8_t edge = self->_edges;
+    if (edge >= 2 && edge < DHTLIB_EDGES)
+    {
+        uint8_t idx = edge - 2;
+        if ((now - self->_lastFall) > DHTLIB_BIT_THRESHOLD)
+        {
+            self->bits[idx >> 3] |= 0x80 >> (idx & 7);
+        }
+    }
+    self->_lastFall = now;
+    if (edge < DHTLIB_EDGES) self->_edges = edge + 1;
+}
+
 /////////////////////////////////////////////////////
 //
 // PRIVATE
 //
 
+dht* dht::_active = NULL;
+
+// pulls the line low to request a sample
+void dht::_startWakeup()
+{
+    _state = _WAKEUP;
+    _stateStart = millis();
+    pinMode(_pin, OUTPUT);
+    digitalWrite(_pin, LOW);
+}
+
+void dht::_stopCapture()
+{
+    *digitalPinToPCMSK(_pin) &= ~_BV(digitalPinToPCMSKbit(_pin));
+    pinMode(_pin, OUTPUT);
+    digitalWrite(_pin, HIGH);
+}
+
+// retries failed reads until the retries are used up
+int dht::_finishRead(int rv)
+{
+    if (rv != DHTLIB_OK && _retries > 0)
+    {
+        _retries--;
+        _state = _WAIT_RETRY;
+        _stateStart = millis();
+        return DHTLIB_BUSY;
+    }
+    if (rv != DHTLIB_OK)
+    {
+        humidityTenths    = DHTLIB_INVALID_VALUE;
+        temperatureTenths = DHTLIB_INVALID_VALUE;
+    }
+    _state = _IDLE;
+    _active = NULL;
+    return rv;
+}
+
 // return values:
 // DHTLIB_OK
 // DHTLIB_ERROR_TIMEOUT
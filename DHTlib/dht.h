@@ -1,7 +1,7 @@
 //
 //    FILE: dht.h
 //  AUTHOR: Rob Tillaart
-// VERSION: 0.1.13
+// VERSION: 0.1.14
 // PURPOSE: DHT Temperature & Humidity Sensor library for Arduino
 //     URL: http://arduino.cc/playground/Main/DHTLib
 //
@@ -18,11 +18,13 @@
 #include <Arduino.h>
 #endif
 
-#define DHT_LIB_VERSION "0.1.13"
+#define DHT_LIB_VERSION "0.1.14"
 
 #define DHTLIB_OK                0
 #define DHTLIB_ERROR_CHECKSUM   -1
 #define DHTLIB_ERROR_TIMEOUT    -2
+#define DHTLIB_BUSY             -3
+#define DHTLIB_IDLE             -4
 #define DHTLIB_INVALID_VALUE    -999
 
 #define DHTLIB_DHT11_WAKEUP     18
@@ -35,9 +37,32 @@
 // so by dividing F_CPU by 40000 we "fail" as fast as possible
 #define DHTLIB_TIMEOUT (F_CPU/40000)
 
+// asynchronous read timing
+// the time between two falling edges is 50 usec low plus
+// 26-28 usec high for a 0 and 70 usec high for a 1
+#define DHTLIB_BIT_THRESHOLD    100     // usec between falling edges
+#define DHTLIB_EDGES            42      // response edge + ack edge + 40 bits
+#define DHTLIB_CAPTURE_TIMEOUT  10      // msec, a full frame takes ~5 msec
+#define DHTLIB_RETRY_INTERVAL   2000    // msec, the sensor needs 2 sec between reads
+
+// the pin change vector of the port that holds the data pin,
+// the analog pins are on port A of the ATmega1284P and
+// on port C of the ATmega328P. The library does not claim it,
+// so that other pins of the port can share it; the sketch defines
+// ISR(DHTLIB_PCINT_vect) and calls dht::_edgeISR() from it
+#ifndef DHTLIB_PCINT_vect
+#if defined(__AVR_ATmega1284P__) || defined(__AVR_ATmega644P__)
+#define DHTLIB_PCINT_vect PCINT0_vect
+#else
+#define DHTLIB_PCINT_vect PCINT1_vect
+#endif
+#endif
+
 class dht
 {
 public:
+    dht() { _state = _IDLE; };
+
     // return values:
     // DHTLIB_OK
     // DHTLIB_ERROR_CHECKSUM
@@ -50,12 +75,48 @@ public:
     inline int read33(uint8_t pin) { return read(pin); };
     inline int read44(uint8_t pin) { return read(pin); };
 
+    // asynchronous interface for the DHT21/22/33/44
+    // startRead() starts a conversion that is captured by the
+    // pin change interrupt, update() has to be called from loop()
+    // return values of update():
+    // DHTLIB_OK             new values in humidityTenths and temperatureTenths
+    // DHTLIB_BUSY           conversion or retry in progress
+    // DHTLIB_IDLE           no conversion started
+    // DHTLIB_ERROR_CHECKSUM all retries failed
+    // DHTLIB_ERROR_TIMEOUT  all retries failed
+    int startRead(uint8_t pin, uint8_t retries);
+    int update();
+    inline int startRead22(uint8_t pin, uint8_t retries) { return startRead(pin, retries); };
+
     double humidity;
     double temperature;
 
+    // fixed point results of the asynchronous interface in 0.1 units
+    int16_t humidityTenths;
+    int16_t temperatureTenths;
+
+    // to be called from the ISR(DHTLIB_PCINT_vect) of the sketch
+    static void _edgeISR();
+
 private:
-    uint8_t bits[5];  // buffer to receive data
+    volatile uint8_t bits[5];  // buffer to receive data, written by _edgeISR
     int _readSensor(uint8_t pin, uint8_t wakeupDelay);
+
+    void _startWakeup();
+    void _stopCapture();
+    int _finishRead(int rv);
+
+    enum { _IDLE, _WAKEUP, _CAPTURE, _WAIT_RETRY } _state;
+    uint8_t _pin;
+    uint8_t _retries;
+    uint32_t _stateStart;
+
+    // state shared with the interrupt
+    static dht* _active;
+    volatile uint8_t _edges;
+    uint32_t _lastFall;
+    volatile uint8_t *_pinReg;
+    uint8_t _pinMask;
 };
 #endif
 //
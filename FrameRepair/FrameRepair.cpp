@@ -0,0 +1,108 @@
+#include <FrameRepair.h>
+
+FrameRepair::FrameRepair(uint32_t window, uint8_t maxDiffs){
+	if(maxDiffs > FRAME_REPAIR_DIFF_LIMIT){
+		maxDiffs = FRAME_REPAIR_DIFF_LIMIT;
+	}
+	FrameRepair::window = window;
+	FrameRepair::maxDiffs = maxDiffs;
+	for(uint8_t i = 0; i < FRAME_REPAIR_SLOTS; i++){
+		held[i].sensor = NULL;
+	}
+	repaired = 0;
+	refused = 0;
+}
+
+FrameRepair::~FrameRepair(){}
+
+boolean FrameRepair::repair(OregonScientificSensor *sensor, uint8_t *message, uint32_t now){
+	uint8_t size = sensor->getMessageSize();
+	if(size > FRAME_REPAIR_MAX_NIBBLES){
+		return false;
+	}
+	for(uint8_t i = 0; i < FRAME_REPAIR_SLOTS; i++){
+		if(held[i].sensor == sensor && now - held[i].time <= window){
+			// Both copies of the message have been used either way
+			held[i].sensor = NULL;
+			if(combine(message, held[i].nibbles, size)){
+				repaired++;
+				return true;
+			}
+			refused++;
+			return false;
+		}
+	}
+	hold(sensor, message, size, now);
+	return false;
+}
+
+void FrameRepair::clear(){
+	for(uint8_t i = 0; i < FRAME_REPAIR_SLOTS; i++){
+		held[i].sensor = NULL;
+	}
+}
+
+void FrameRepair::hold(OregonScientificSensor *sensor, const uint8_t *message, uint8_t size, uint32_t now){
+	uint8_t slot = 0;
+	for(uint8_t i = 0; i < FRAME_REPAIR_SLOTS; i++){
+		if(held[i].sensor == sensor || held[i].sensor == NULL){
+			slot = i;
+			break;
+		}
+		if(now - held[i].time > now - held[slot].time){
+			slot = i;
+		}
+	}
+	held[slot].sensor = sensor;
+	held[slot].time = now;
+	memcpy(held[slot].nibbles, message, size);
+}
+
+boolean FrameRepair::combine(uint8_t *message, const uint8_t *copy, uint8_t size){
+	uint8_t diffs[FRAME_REPAIR_DIFF_LIMIT];
+	uint8_t count = 0;
+	for(uint8_t i = 0; i < size; i++){
+		if(message[i] != copy[i]){
+			// The header of the message says which sensor sent it, and is never guessed
+			if(i < MESSAGE_BEGIN || count == maxDiffs){
+				return false;
+			}
+			diffs[count++] = i;
+		}
+	}
+	if(count == 0){
+		return false;
+	}
+	uint8_t candidate[FRAME_REPAIR_MAX_NIBBLES];
+	memcpy(candidate, message, size);
+	uint8_t passes = 0;
+	// Every mix of the two copies except the copies themselves, which failed,
+	// so copies that differ in a single nibble have no candidate
+	uint8_t choice = 0;
+	for(uint8_t mask = 1; mask < (1 << count) - 1; mask++){
+		for(uint8_t d = 0; d < count; d++){
+			candidate[diffs[d]] = (mask >> d) & 0x01 ? copy[diffs[d]] : message[diffs[d]];
+		}
+		if(OregonScientific::checksumMatches(candidate, size)){
+			passes++;
+			choice = mask;
+		}
+	}
+	if(passes != 1){
+		return false;
+	}
+	for(uint8_t d = 0; d < count; d++){
+		if((choice >> d) & 0x01){
+			message[diffs[d]] = copy[diffs[d]];
+		}
+	}
+	return true;
+}
+
+uint32_t FrameRepair::getRepaired(){
+	return repaired;
+}
+
+uint32_t FrameRepair::getRefused(){
+	return refused;
+}
@@ -0,0 +1,81 @@
+// File: FrameRepair.h
+// Description: Defines a stage that recovers messages which failed their
+// checksum by combining them with the repeat the sensor sends.
+
+/**
+ * The Frame Repair holds the last message of each sensor that
+ * failed its checksum for a short window. Version 2.1 sensors send
+ * every message twice, so when the repeat fails as well the two
+ * copies are compared nibble by nibble. The nibbles on which they
+ * agree are trusted. Every way of taking the other nibbles from one
+ * copy or the other is checked against the checksum, and the
+ * repair is accepted only when exactly one of them passes.
+ * No nibble is ever given a value that neither copy holds. The
+ * checksum is a sum of the nibbles, so it can be made to pass by
+ * changing almost any nibble, and such a guess, on a lone message
+ * or on a nibble both copies got wrong, would too often be wrong.
+ * The copies may differ in at most two nibbles, which leaves two
+ * candidates, and only in the reading and the checksum: a copy
+ * that differs in the device id, channel, rolling code, or flags
+ * would be handed to the wrong sensor or report a wrong battery,
+ * and is never repaired.
+ * @file FrameRepair.h */
+
+#ifndef FRAME_REPAIR_H
+#define FRAME_REPAIR_H
+
+#include <Arduino.h>
+#include <OregonScientific.h>
+#include <OregonScientificSensor.h>
+
+#define FRAME_REPAIR_SLOTS 2 ///< Defines the number of sensors whose failed messages are held at once.
+#define FRAME_REPAIR_MAX_NIBBLES 18 ///< Defines the longest message that can be held.
+#define FRAME_REPAIR_DIFF_LIMIT 2 ///< Defines the most differing nibbles that can be allowed, which bounds the candidates to 2.
+
+/** FrameRepair recovers messages that failed their checksum from their repeats.
+ * @class FrameRepair */
+class FrameRepair
+{
+public:
+	/** The constructor.
+	 * @param window The longest time in milliseconds between a message and its repeat.
+	 * @param maxDiffs The most nibbles in which the two copies may differ (at most FRAME_REPAIR_DIFF_LIMIT). */
+	FrameRepair(uint32_t window, uint8_t maxDiffs);
+	/** The destructor. */
+	~FrameRepair();
+	/** Tries to repair a message that failed its checksum. If the sensor has
+	 * no failed message held, or the repair is refused, the message is held
+	 * in case the repeat also fails.
+	 * @param *sensor The sensor that sent the message.
+	 * @param *message The nibbles of the message, which are corrected in place when the repair succeeds.
+	 * @param now The current time in milliseconds.
+	 * @return True if the message was repaired and now passes its checksum. */
+	boolean repair(OregonScientificSensor *sensor, uint8_t *message, uint32_t now);
+	/** Forgets every held message, as when the sensors they came from are removed. */
+	void clear();
+	/** Gets the number of messages that were repaired. */
+	uint32_t getRepaired();
+	/** Gets the number of repairs that were refused because the copies
+	 * differed in too many nibbles or no single candidate passed. */
+	uint32_t getRefused();
+private:
+	/** A message that failed its checksum. */
+	struct HeldMessage{
+		OregonScientificSensor *sensor; ///< The sensor that sent it, or NULL if the slot is free.
+		uint32_t time; ///< The time it was received in milliseconds.
+		uint8_t nibbles[FRAME_REPAIR_MAX_NIBBLES]; ///< The nibbles of the message.
+	};
+	/** Holds a message, in the slot of its sensor or else the oldest slot. */
+	void hold(OregonScientificSensor *sensor, const uint8_t *message, uint8_t size, uint32_t now);
+	/** Combines a message with the held copy.
+	 * @return True if the copies differ only after MESSAGE_BEGIN and exactly one candidate passed, which is then in message. */
+	boolean combine(uint8_t *message, const uint8_t *copy, uint8_t size);
+
+	HeldMessage held[FRAME_REPAIR_SLOTS];
+	uint32_t window;
+	uint8_t maxDiffs;
+	uint32_t repaired;
+	uint32_t refused;
+};
+
+#endif // FRAME_REPAIR_H
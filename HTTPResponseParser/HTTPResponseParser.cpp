@@ -0,0 +1,193 @@
+#include <HTTPResponseParser.h>
+
+// The header whose value is kept, compared in lower case
+static const char CONTENT_LENGTH_HEADER[] = "content-length:";
+
+HTTPResponseParser::HTTPResponseParser(){
+	bodySize = HTTP_DEFAULT_BODY_SIZE;
+	body = new char[bodySize + 1];
+	reset();
+}
+
+HTTPResponseParser::HTTPResponseParser(uint16_t bodySize){
+	HTTPResponseParser::bodySize = bodySize;
+	body = new char[bodySize + 1];
+	reset();
+}
+
+HTTPResponseParser::~HTTPResponseParser(){
+	delete[] body;
+}
+
+void HTTPResponseParser::reset(){
+	state = STATUS_LINE;
+	statusCode = 0;
+	contentLength = HTTP_NO_LENGTH;
+	contentRead = 0;
+	lineLength = 0;
+	headerMatch = 0;
+	markerMatch = 0;
+	bodyLength = 0;
+	body[0] = '\0';
+	overflowed = false;
+}
+
+boolean HTTPResponseParser::parse(char c){
+	switch(state){
+		case STATUS_LINE:
+			parseStatusLine(c);
+			break;
+		case HEADERS:
+			parseHeader(c);
+			break;
+		case SEEK_START:
+		case BODY:
+			contentRead++;
+			parseBody(c);
+			// Stops once all of the content has been read
+			if(contentLength != HTTP_NO_LENGTH && contentRead >= contentLength){
+				finish();
+			}
+			break;
+		case COMPLETE:
+			break;
+	}
+	return state == COMPLETE;
+}
+
+void HTTPResponseParser::finish(){
+	// Keeps a partially matched end marker as part of the body
+	if(state == BODY){
+		for(uint8_t i = 0; i < markerMatch; i++){
+			append(HTTP_BODY_END[i]);
+		}
+	}
+	markerMatch = 0;
+	state = COMPLETE;
+}
+
+boolean HTTPResponseParser::isComplete(){
+	return state == COMPLETE;
+}
+
+uint16_t HTTPResponseParser::getStatusCode(){
+	return statusCode;
+}
+
+int32_t HTTPResponseParser::getContentLength(){
+	return contentLength;
+}
+
+char* HTTPResponseParser::getBody(){
+	return body;
+}
+
+uint16_t HTTPResponseParser::getBodyLength(){
+	return bodyLength;
+}
+
+boolean HTTPResponseParser::hasOverflowed(){
+	return overflowed;
+}
+
+void HTTPResponseParser::parseStatusLine(char c){
+	if(c == '\n'){
+		state = HEADERS;
+		lineLength = 0;
+		headerMatch = 0;
+		return;
+	}
+	// The status code is the second field of the line: "HTTP/1.1 200 OK"
+	if(c == ' '){
+		if(lineLength < 2){
+			lineLength++;
+		}
+	}else if(lineLength == 1 && c >= '0' && c <= '9'){
+		statusCode = statusCode * 10 + (c - '0');
+	}
+}
+
+void HTTPResponseParser::parseHeader(char c){
+	if(c == '\r'){
+		return;
+	}
+	if(c == '\n'){
+		// An empty line ends the headers
+		if(lineLength == 0){
+			state = SEEK_START;
+			markerMatch = 0;
+			if(contentLength == 0){
+				finish();
+			}
+		}
+		lineLength = 0;
+		headerMatch = 0;
+		return;
+	}
+	if(lineLength < 0xFF){
+		lineLength++;
+	}
+	if(headerMatch == sizeof(CONTENT_LENGTH_HEADER) - 1){
+		if(c >= '0' && c <= '9'){
+			if(contentLength == HTTP_NO_LENGTH){
+				contentLength = 0;
+			}
+			contentLength = contentLength * 10 + (c - '0');
+		}
+	}else if(headerMatch != 0xFF){
+		// Compares the header name without regard to case
+		char lower = (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+		if(lower == CONTENT_LENGTH_HEADER[headerMatch]){
+			headerMatch++;
+		}else{
+			headerMatch = 0xFF;
+		}
+	}
+}
+
+void HTTPResponseParser::parseBody(char c){
+	if(state == SEEK_START){
+		if(matchMarker(c, HTTP_BODY_START)){
+			state = BODY;
+		}
+		return;
+	}
+	// Skips the whitespace between the start marker and the body
+	if(bodyLength == 0 && markerMatch == 0 && (c == ' ' || c == '\n' || c == '\r')){
+		return;
+	}
+	uint8_t matched = markerMatch;
+	if(matchMarker(c, HTTP_BODY_END)){
+		state = COMPLETE;
+		return;
+	}
+	// Characters held back as a possible end marker belong to the body after all
+	if(markerMatch <= matched){
+		for(uint8_t i = 0; i < matched + 1 - markerMatch; i++){
+			append(i < matched ? HTTP_BODY_END[i] : c);
+		}
+	}
+}
+
+boolean HTTPResponseParser::matchMarker(char c, const char *marker){
+	if(c == marker[markerMatch]){
+		markerMatch++;
+	}else{
+		// The markers do not overlap themselves so a mismatch can only restart the match
+		markerMatch = (c == marker[0]) ? 1 : 0;
+	}
+	if(marker[markerMatch] == '\0'){
+		markerMatch = 0;
+		return true;
+	}
+	return false;
+}
+
+void HTTPResponseParser::append(char c){
+	if(bodyLength < bodySize){
+		body[bodyLength++] = c;
+		body[bodyLength] = '\0';
+	}else{
+		overflowed = true;
+	}
+}
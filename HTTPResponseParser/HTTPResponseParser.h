@@ -0,0 +1,124 @@
+// File: HTTPResponseParser.h
+// Description: Defines a resumable parser for the responses sent by the
+// server. Bytes are handed to the parser as they become available so the
+// response can be consumed without blocking the main loop.
+
+/**
+ * The HTTP Response Parser is a byte at a time state machine
+ * which parses the status line, the headers (keeping only the
+ * Content-Length), and the body of a response from the server.
+ * The server wraps the interesting part of its reply in the
+ * markers "start" and "end"; only the text between the markers
+ * is kept. The parser never waits for input, so the caller
+ * can feed it whatever bytes the client has available and
+ * return to other work in between.
+ * @file HTTPResponseParser.h */
+
+#ifndef HTTP_RESPONSE_PARSER_H
+#define HTTP_RESPONSE_PARSER_H
+
+#include <Arduino.h>
+
+#define HTTP_DEFAULT_BODY_SIZE 64 ///< Defines the size of the body buffer if none is provided.
+#define HTTP_BODY_START "start" ///< Defines the marker that precedes the body.
+#define HTTP_BODY_END "end" ///< Defines the marker that follows the body.
+#define HTTP_NO_LENGTH -1 ///< Defines the content length when no Content-Length header was received.
+
+/** @enum HTTPResponseParser_State The states that the parser
+ * can be in while parsing the response. */
+enum HTTPResponseParser_State{
+								 STATUS_LINE, ///< The parser is in this state while reading the status line.
+								 HEADERS, ///< The parser is in this state while reading the headers.
+								 SEEK_START, ///< The parser is in this state while looking for the start marker in the content.
+								 BODY, ///< The parser is in this state while copying the body into the buffer.
+								 COMPLETE ///< The parser is in this state once the response has been parsed.
+								};
+
+/** HTTPResponseParser parses the response to a request made
+ * to the server one byte at a time.
+ * @class HTTPResponseParser
+ * @details The response is complete when the end marker is found,
+ * when the number of bytes given by the Content-Length header have
+ * been consumed, or when the caller calls finish() because the
+ * connection was closed. Leading spaces and newlines of the body
+ * are skipped and bytes that do not fit in the body buffer are
+ * dropped, which hasOverflowed reports so that a reply that was cut
+ * short can be discarded. */
+class HTTPResponseParser
+{
+public:
+	/** The default constructor. */
+	HTTPResponseParser();
+	/** The constructor which takes the size of the body buffer.
+	 * @param bodySize The maximum number of characters kept from the body. */
+	HTTPResponseParser(uint16_t bodySize);
+	/** The destructor. */
+	~HTTPResponseParser();
+	/** Resets the parser so that it can parse a new response. */
+	void reset();
+	/** Parses the next byte of the response.
+	 * @param c The next byte received from the server.
+	 * @return True if the response is complete, false otherwise. */
+	boolean parse(char c);
+	/** Marks the response as complete, generally because the connection was closed. */
+	void finish();
+	/** Checks if the response has been completely parsed.
+	 * @return True if the response is complete, false otherwise. */
+	boolean isComplete();
+	/** Gets the status code from the status line.
+	 * @return The status code or 0 if it has not been received. */
+	uint16_t getStatusCode();
+	/** Gets the value of the Content-Length header.
+	 * @return The content length or HTTP_NO_LENGTH if it was not received. */
+	int32_t getContentLength();
+	/** Gets the body that was found between the start and end markers.
+	 * @return The null terminated body. */
+	char* getBody();
+	/** Gets the length of the body.
+	 * @return The number of characters in the body buffer. */
+	uint16_t getBodyLength();
+	/** Checks whether the body was longer than the buffer.
+	 * @return True if characters of the body were dropped. */
+	boolean hasOverflowed();
+private:
+	/** Appends a character to the body if there is room for it.
+	 * @param c The character to append. */
+	void append(char c);
+	/** Advances the marker match with the given character.
+	 * @param c The character to match.
+	 * @param *marker The marker that is being matched.
+	 * @return True if the whole marker has been matched. */
+	boolean matchMarker(char c, const char *marker);
+	/** Parses a byte of the status line. */
+	void parseStatusLine(char c);
+	/** Parses a byte of the headers. */
+	void parseHeader(char c);
+	/** Parses a byte of the body. */
+	void parseBody(char c);
+	/** The current state of the parser. */
+	HTTPResponseParser_State state;
+	/** The status code from the status line. */
+	uint16_t statusCode;
+	/** The value of the Content-Length header. */
+	int32_t contentLength;
+	/** The number of bytes of content consumed so far. */
+	int32_t contentRead;
+	/** The number of characters on the current header line, or
+	 * the index of the field being read on the status line. */
+	uint8_t lineLength;
+	/** The number of characters of the header name that matched Content-Length,
+	 * or 0xFF once the header is known to be something else. */
+	uint8_t headerMatch;
+	/** The number of characters of the current marker that have been matched. */
+	uint8_t markerMatch;
+	/** The maximum number of characters that the body can hold. */
+	uint16_t bodySize;
+	/** The number of characters in the body. */
+	uint16_t bodyLength;
+	/** The buffer holding the body. */
+	char *body;
+	/** Whether characters of the body were dropped. */
+	boolean overflowed;
+};
+
+#endif // HTTP_RESPONSE_PARSER_H
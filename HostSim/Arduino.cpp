@@ -0,0 +1,216 @@
+#include <Arduino.h>
+#include <HostSim.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+HardwareSerial Serial;
+
+/*
+ * Number formatting
+ */
+static char *formatNumber(unsigned long value, boolean negative, char *buffer, int base){
+	char digits[34];
+	int len = 0;
+	do{
+		int digit = value % base;
+		digits[len++] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+		value /= base;
+	}while(value > 0);
+	char *out = buffer;
+	if(negative){
+		*out++ = '-';
+	}
+	while(len > 0){
+		*out++ = digits[--len];
+	}
+	*out = '\0';
+	return buffer;
+}
+
+char *itoa(int value, char *buffer, int base){
+	return ltoa(value, buffer, base);
+}
+
+char *ltoa(long value, char *buffer, int base){
+	if(base == 10 && value < 0){
+		return formatNumber(-(unsigned long) value, true, buffer, base);
+	}
+	// Other bases print the two's complement like the AVR library
+	return formatNumber(base == 10 ? (unsigned long) value : (unsigned long) (uint32_t) value, false, buffer, base);
+}
+
+char *utoa(unsigned value, char *buffer, int base){
+	return formatNumber(value, false, buffer, base);
+}
+
+/*
+ * Print
+ */
+size_t Print::write(const uint8_t *buffer, size_t size){
+	size_t n = 0;
+	while(size--){
+		n += write(*buffer++);
+	}
+	return n;
+}
+
+size_t Print::printNumber(unsigned long n, int base){
+	char buffer[34];
+	// The Arduino core prints hexadecimal in upper case
+	formatNumber(n, false, buffer, base);
+	for(char *c = buffer; *c; c++){
+		if(*c >= 'a' && *c <= 'z'){
+			*c -= 'a' - 'A';
+		}
+	}
+	return write(buffer);
+}
+
+size_t Print::print(const __FlashStringHelper *str){ return write(reinterpret_cast<const char *>(str)); }
+size_t Print::print(const String &str){ return write(str.c_str()); }
+size_t Print::print(const char *str){ return write(str); }
+size_t Print::print(char c){ return write((uint8_t) c); }
+size_t Print::print(unsigned char n, int base){ return printNumber(n, base); }
+size_t Print::print(int n, int base){ return print((long) n, base); }
+size_t Print::print(unsigned int n, int base){ return printNumber(n, base); }
+size_t Print::print(long n, int base){
+	if(base == 10 && n < 0){
+		return write('-') + printNumber(-(unsigned long) n, 10);
+	}
+	return printNumber(base == 10 ? (unsigned long) n : (uint32_t) n, base);
+}
+size_t Print::print(unsigned long n, int base){ return printNumber(n, base); }
+size_t Print::print(double n, int digits){
+	char buffer[48];
+	snprintf(buffer, sizeof(buffer), "%.*f", digits, n);
+	return write(buffer);
+}
+
+size_t Print::println(){ return write("\r\n"); }
+size_t Print::println(const __FlashStringHelper *str){ return print(str) + println(); }
+size_t Print::println(const String &str){ return print(str) + println(); }
+size_t Print::println(const char *str){ return print(str) + println(); }
+size_t Print::println(char c){ return print(c) + println(); }
+size_t Print::println(unsigned char n, int base){ return print(n, base) + println(); }
+size_t Print::println(int n, int base){ return print(n, base) + println(); }
+size_t Print::println(unsigned int n, int base){ return print(n, base) + println(); }
+size_t Print::println(long n, int base){ return print(n, base) + println(); }
+size_t Print::println(unsigned long n, int base){ return print(n, base) + println(); }
+size_t Print::println(double n, int digits){ return print(n, digits) + println(); }
+
+/*
+ * String
+ */
+String::String(const char *s) : str(s == NULL ? "" : s){}
+String::String(const String &s) : str(s.str){}
+String::String(const __FlashStringHelper *s) : str(reinterpret_cast<const char *>(s)){}
+String::String(char c) : str(1, c){}
+String::String(unsigned char n, unsigned char base){ char b[34]; str = utoa(n, b, base); }
+String::String(int n, unsigned char base){ char b[34]; str = ltoa(n, b, base); }
+String::String(unsigned int n, unsigned char base){ char b[34]; str = utoa(n, b, base); }
+String::String(long n, unsigned char base){ char b[34]; str = ltoa(n, b, base); }
+String::String(unsigned long n, unsigned char base){ char b[34]; str = formatNumber(n, false, b, base); }
+
+String &String::operator=(const String &rhs){ str = rhs.str; return *this; }
+String &String::operator=(const char *rhs){ str = rhs == NULL ? "" : rhs; return *this; }
+
+String &String::operator+=(const String &rhs){ str += rhs.str; return *this; }
+String &String::operator+=(const char *rhs){ if(rhs != NULL) str += rhs; return *this; }
+String &String::operator+=(char c){ str += c; return *this; }
+String &String::operator+=(unsigned char n){ return *this += String(n); }
+String &String::operator+=(int n){ return *this += String(n); }
+String &String::operator+=(unsigned int n){ return *this += String(n); }
+String &String::operator+=(long n){ return *this += String(n); }
+String &String::operator+=(unsigned long n){ return *this += String(n); }
+
+String operator+(const String &lhs, const String &rhs){ String s(lhs); s += rhs; return s; }
+String operator+(const String &lhs, const char *rhs){ String s(lhs); s += rhs; return s; }
+
+void String::toCharArray(char *buffer, unsigned int size, unsigned int index) const{
+	getBytes((unsigned char *) buffer, size, index);
+}
+
+void String::getBytes(unsigned char *buffer, unsigned int size, unsigned int index) const{
+	if(size == 0 || buffer == NULL){
+		return;
+	}
+	if(index >= str.length()){
+		buffer[0] = '\0';
+		return;
+	}
+	unsigned int n = str.length() - index;
+	if(n > size - 1){
+		n = size - 1;
+	}
+	memcpy(buffer, str.c_str() + index, n);
+	buffer[n] = '\0';
+}
+
+int String::indexOf(char c, unsigned int from) const{
+	size_t i = str.find(c, from);
+	return i == std::string::npos ? -1 : (int) i;
+}
+
+int String::indexOf(const String &s, unsigned int from) const{
+	size_t i = str.find(s.str, from);
+	return i == std::string::npos ? -1 : (int) i;
+}
+
+String String::substring(unsigned int from) const{
+	return substring(from, str.length());
+}
+
+String String::substring(unsigned int from, unsigned int to) const{
+	if(from > to){
+		unsigned int t = from;
+		from = to;
+		to = t;
+	}
+	if(from >= str.length()){
+		return String();
+	}
+	return String(str.substr(from, to - from).c_str());
+}
+
+void String::trim(){
+	size_t b = str.find_first_not_of(" \t\r\n");
+	size_t e = str.find_last_not_of(" \t\r\n");
+	str = b == std::string::npos ? "" : str.substr(b, e - b + 1);
+}
+
+/*
+ * Serial
+ */
+int HardwareSerial::available(){
+	int n = 0;
+	if(ioctl(STDIN_FILENO, FIONREAD, &n) != 0){
+		return 0;
+	}
+	return n;
+}
+
+int HardwareSerial::read(){
+	if(available() <= 0){
+		return -1;
+	}
+	unsigned char c;
+	return ::read(STDIN_FILENO, &c, 1) == 1 ? c : -1;
+}
+
+int HardwareSerial::peek(){
+	return -1;
+}
+
+size_t HardwareSerial::write(uint8_t c){
+	if(hostsim_serial_enabled()){
+		fputc(c, stdout);
+	}
+	return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size){
+	if(hostsim_serial_enabled()){
+		fwrite(buffer, 1, size, stdout);
+	}
+	return size;
+}
@@ -0,0 +1,219 @@
+// File: Arduino.h
+// Description: The subset of the Arduino core that the libraries and the
+// sketch use, implemented for Linux so that the firmware can be run
+// against the virtual clock of the host simulation.
+
+/**
+ * The host build of the Arduino core. Time comes from the virtual
+ * clock in HostSim.h, which also fires the interrupts attached with
+ * attachInterrupt when an injected edge becomes due. The Serial port
+ * writes to standard output.
+ * @file Arduino.h */
+
+#ifndef HOSTSIM_ARDUINO_H
+#define HOSTSIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+
+#ifndef ARDUINO
+#define ARDUINO 10600
+#endif
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef uint16_t word; ///< A word is 16 bits wide on the AVR, which the pulse arithmetic relies on.
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define A6 20
+#define A7 21
+
+#define HOSTSIM_NUM_PINS 32 ///< Defines the number of digital pins that are simulated.
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+#define strcat_P strcat
+#define strcpy_P strcpy
+#define strlen_P strlen
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define _BV(bit) (1 << (bit))
+
+/** Combines two bytes into a word. */
+inline word makeWord(uint8_t h, uint8_t l){ return (h << 8) | l; }
+#define word(...) makeWord(__VA_ARGS__)
+
+char *itoa(int value, char *buffer, int base);
+char *ltoa(long value, char *buffer, int base);
+char *utoa(unsigned value, char *buffer, int base);
+
+class __FlashStringHelper;
+class String;
+
+/** The base of every class that can print text. */
+class Print
+{
+public:
+	virtual ~Print(){}
+	/** Writes a single byte. */
+	virtual size_t write(uint8_t c) = 0;
+	/** Writes a buffer, one byte at a time unless overridden. */
+	virtual size_t write(const uint8_t *buffer, size_t size);
+	size_t write(const char *str){ return str == NULL ? 0 : write((const uint8_t *) str, strlen(str)); }
+	size_t write(const char *buffer, size_t size){ return write((const uint8_t *) buffer, size); }
+
+	size_t print(const __FlashStringHelper *str);
+	size_t print(const String &str);
+	size_t print(const char *str);
+	size_t print(char c);
+	size_t print(unsigned char n, int base = DEC);
+	size_t print(int n, int base = DEC);
+	size_t print(unsigned int n, int base = DEC);
+	size_t print(long n, int base = DEC);
+	size_t print(unsigned long n, int base = DEC);
+	size_t print(double n, int digits = 2);
+
+	size_t println(const __FlashStringHelper *str);
+	size_t println(const String &str);
+	size_t println(const char *str);
+	size_t println(char c);
+	size_t println(unsigned char n, int base = DEC);
+	size_t println(int n, int base = DEC);
+	size_t println(unsigned int n, int base = DEC);
+	size_t println(long n, int base = DEC);
+	size_t println(unsigned long n, int base = DEC);
+	size_t println(double n, int digits = 2);
+	size_t println();
+private:
+	size_t printNumber(unsigned long n, int base);
+};
+
+/** The Arduino String, backed by std::string. */
+class String
+{
+public:
+	String(const char *str = "");
+	String(const String &str);
+	String(const __FlashStringHelper *str);
+	explicit String(char c);
+	explicit String(unsigned char n, unsigned char base = DEC);
+	explicit String(int n, unsigned char base = DEC);
+	explicit String(unsigned int n, unsigned char base = DEC);
+	explicit String(long n, unsigned char base = DEC);
+	explicit String(unsigned long n, unsigned char base = DEC);
+	String &operator=(const String &rhs);
+	String &operator=(const char *rhs);
+
+	String &operator+=(const String &rhs);
+	String &operator+=(const char *rhs);
+	String &operator+=(char c);
+	String &operator+=(unsigned char n);
+	String &operator+=(int n);
+	String &operator+=(unsigned int n);
+	String &operator+=(long n);
+	String &operator+=(unsigned long n);
+	friend String operator+(const String &lhs, const String &rhs);
+	friend String operator+(const String &lhs, const char *rhs);
+
+	bool operator==(const String &rhs) const { return str == rhs.str; }
+	bool operator==(const char *rhs) const { return str == rhs; }
+	bool operator!=(const String &rhs) const { return str != rhs.str; }
+	bool operator!=(const char *rhs) const { return str != rhs; }
+	bool equals(const String &rhs) const { return str == rhs.str; }
+	bool equals(const char *rhs) const { return str == rhs; }
+
+	unsigned int length() const { return str.length(); }
+	char charAt(unsigned int index) const { return index < str.length() ? str[index] : 0; }
+	char operator[](unsigned int index) const { return charAt(index); }
+	void toCharArray(char *buffer, unsigned int size, unsigned int index = 0) const;
+	void getBytes(unsigned char *buffer, unsigned int size, unsigned int index = 0) const;
+	const char *c_str() const { return str.c_str(); }
+	int indexOf(char c, unsigned int from = 0) const;
+	int indexOf(const String &s, unsigned int from = 0) const;
+	String substring(unsigned int from) const;
+	String substring(unsigned int from, unsigned int to) const;
+	long toInt() const { return atol(str.c_str()); }
+	void trim();
+private:
+	std::string str;
+};
+
+/** The Serial port, which writes to standard output and reads from standard input. */
+class HardwareSerial : public Print
+{
+public:
+	void begin(unsigned long baud){ (void) baud; }
+	void end(){}
+	int available();
+	int read();
+	int peek();
+	void flush(){ fflush(stdout); }
+	size_t write(uint8_t c);
+	size_t write(const uint8_t *buffer, size_t size);
+	using Print::write;
+	operator bool(){ return true; }
+};
+
+extern HardwareSerial Serial;
+
+unsigned long micros();
+unsigned long millis();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+void attachInterrupt(uint8_t interruptNum, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t interruptNum);
+void interrupts();
+void noInterrupts();
+#define sei() interrupts()
+#define cli() noInterrupts()
+
+// The pin change registers used by the asynchronous DHT reader. The
+// simulation keeps one input register per port of eight pins.
+extern volatile uint8_t hostsim_port_input[HOSTSIM_NUM_PINS / 8];
+extern volatile uint8_t hostsim_pcint_registers[8];
+#define digitalPinToPort(p) ((p) / 8)
+#define digitalPinToBitMask(p) (1 << ((p) % 8))
+#define portInputRegister(port) (&hostsim_port_input[(port)])
+#define digitalPinToPCICR(p) (&hostsim_pcint_registers[0])
+#define digitalPinToPCICRbit(p) ((p) / 8)
+#define digitalPinToPCMSK(p) (&hostsim_pcint_registers[1 + (p) / 8])
+#define digitalPinToPCMSKbit(p) ((p) % 8)
+#define PCIFR hostsim_pcint_registers[7]
+
+#endif // HOSTSIM_ARDUINO_H
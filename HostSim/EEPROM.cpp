@@ -0,0 +1,94 @@
+#include <avr/eeprom.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EEPROM_SIZE (E2END + 1)
+
+static uint8_t memory[EEPROM_SIZE];
+static FILE *backing = NULL;
+static bool loaded = false;
+
+// Loads the file on first use; erased cells read as 0xFF like a new device
+static void load(){
+	if(loaded){
+		return;
+	}
+	loaded = true;
+	memset(memory, 0xFF, sizeof(memory));
+	const char *path = getenv("HOSTSIM_EEPROM");
+	if(path == NULL){
+		path = "hostsim_eeprom.bin";
+	}
+	backing = fopen(path, "r+b");
+	if(backing == NULL){
+		backing = fopen(path, "w+b");
+		if(backing != NULL){
+			fwrite(memory, 1, sizeof(memory), backing);
+			fflush(backing);
+		}
+	}else{
+		size_t n = fread(memory, 1, sizeof(memory), backing);
+		(void) n;
+	}
+}
+
+static size_t address(const void *addr){
+	return (size_t) (uintptr_t) addr % EEPROM_SIZE;
+}
+
+void eeprom_read_block(void *dst, const void *src, size_t n){
+	load();
+	size_t a = address(src);
+	for(size_t i = 0; i < n; i++){
+		((uint8_t *) dst)[i] = memory[(a + i) % EEPROM_SIZE];
+	}
+}
+
+void eeprom_write_block(const void *src, void *dst, size_t n){
+	load();
+	size_t a = address(dst);
+	for(size_t i = 0; i < n; i++){
+		memory[(a + i) % EEPROM_SIZE] = ((const uint8_t *) src)[i];
+	}
+	if(backing != NULL){
+		if(a + n <= EEPROM_SIZE){
+			fseek(backing, a, SEEK_SET);
+			fwrite(memory + a, 1, n, backing);
+		}else{
+			fseek(backing, 0, SEEK_SET);
+			fwrite(memory, 1, sizeof(memory), backing);
+		}
+		fflush(backing);
+	}
+}
+
+uint8_t eeprom_read_byte(const uint8_t *addr){
+	uint8_t value;
+	eeprom_read_block(&value, addr, sizeof(value));
+	return value;
+}
+
+uint16_t eeprom_read_word(const uint16_t *addr){
+	uint16_t value;
+	eeprom_read_block(&value, addr, sizeof(value));
+	return value;
+}
+
+uint32_t eeprom_read_dword(const uint32_t *addr){
+	uint32_t value;
+	eeprom_read_block(&value, addr, sizeof(value));
+	return value;
+}
+
+void eeprom_write_byte(uint8_t *addr, uint8_t value){
+	eeprom_write_block(&value, addr, sizeof(value));
+}
+
+void eeprom_write_word(uint16_t *addr, uint16_t value){
+	eeprom_write_block(&value, addr, sizeof(value));
+}
+
+void eeprom_write_dword(uint32_t *addr, uint32_t value){
+	eeprom_write_block(&value, addr, sizeof(value));
+}
@@ -0,0 +1,129 @@
+#include <FrameDedupe.h>
+
+FrameDedupe::FrameDedupe(uint64_t window_us, DedupeHandler handler, void *context){
+	FrameDedupe::window_us = window_us;
+	FrameDedupe::handler = handler;
+	FrameDedupe::context = context;
+	copies = 0;
+	frames = 0;
+	replaced = 0;
+	outvoted = 0;
+}
+
+void FrameDedupe::add(const ReceivedFrame &frame, uint64_t time_us){
+	copies++;
+	uint32_t receiver = (uint32_t) 1 << (frame.receiver % FRAME_DEDUPE_MAX_RECEIVERS);
+	// Only a few windows are open at once, one for each sensor heard in the last window
+	for(size_t i = 0; i < open.size(); i++){
+		DedupeWindow &window = open[i];
+		DedupedFrame &entry = window.frame;
+		// A receiver that lags the others can still add a copy from before the window
+		if(time_us >= entry.open_us + window_us || time_us + window_us <= entry.open_us || !isSameSensor(frame.frame, entry.best.frame)){
+			continue;
+		}
+		if(frame.decoded_ns < entry.first_ns){
+			entry.first_ns = frame.decoded_ns;
+		}
+		entry.receivers |= receiver;
+		entry.copies++;
+		uint8_t v = 0;
+		while(v < entry.variants && !isSame(frame.frame, window.variants[v].best.frame)){
+			v++;
+		}
+		if(v == entry.variants){
+			// A copy that disagrees with more than the others still counts as heard, but gets no vote
+			if(v < FRAME_DEDUPE_VARIANTS){
+				window.variants[v].best = frame;
+				window.variants[v].votes = 1;
+				entry.variants++;
+			}
+		}else{
+			window.variants[v].votes++;
+			if(isBetter(frame.frame, window.variants[v].best.frame)){
+				window.variants[v].best = frame;
+				replaced++;
+			}
+		}
+		return;
+	}
+	DedupeWindow window;
+	window.frame.best = frame;
+	window.frame.open_us = time_us;
+	window.frame.first_ns = frame.decoded_ns;
+	window.frame.receivers = receiver;
+	window.frame.copies = 1;
+	window.frame.votes = 1;
+	window.frame.variants = 1;
+	window.variants[0].best = frame;
+	window.variants[0].votes = 1;
+	open.push_back(window);
+}
+
+void FrameDedupe::emit(DedupeWindow &window){
+	DedupedFrame &entry = window.frame;
+	uint8_t chosen = 0;
+	for(uint8_t v = 1; v < entry.variants; v++){
+		const DedupeVariant &variant = window.variants[v];
+		if(variant.votes > window.variants[chosen].votes
+			|| (variant.votes == window.variants[chosen].votes && isBetter(variant.best.frame, window.variants[chosen].best.frame))){
+			chosen = v;
+		}
+	}
+	entry.best = window.variants[chosen].best;
+	entry.votes = window.variants[chosen].votes;
+	if(entry.variants > 1){
+		outvoted++;
+	}
+	frames++;
+	handler(entry, context);
+}
+
+void FrameDedupe::close(uint64_t time_us){
+	size_t kept = 0;
+	for(size_t i = 0; i < open.size(); i++){
+		if(open[i].frame.open_us + window_us <= time_us){
+			emit(open[i]);
+		}else{
+			open[kept++] = open[i];
+		}
+	}
+	open.resize(kept);
+}
+
+void FrameDedupe::flush(){
+	for(size_t i = 0; i < open.size(); i++){
+		emit(open[i]);
+	}
+	open.clear();
+}
+
+boolean FrameDedupe::isBetter(const DecodedFrame &a, const DecodedFrame &b){
+	if(a.repaired != b.repaired){
+		return !a.repaired;
+	}
+	return a.jitter < b.jitter;
+}
+
+boolean FrameDedupe::isSameSensor(const DecodedFrame &a, const DecodedFrame &b){
+	return a.sensorId == b.sensorId && a.channel == b.channel && a.protocol == b.protocol;
+}
+
+boolean FrameDedupe::isSame(const DecodedFrame &a, const DecodedFrame &b){
+	return a.size == b.size && memcmp(a.nibbles, b.nibbles, a.size) == 0;
+}
+
+uint64_t FrameDedupe::getCopies(){
+	return copies;
+}
+
+uint64_t FrameDedupe::getFrames(){
+	return frames;
+}
+
+uint64_t FrameDedupe::getReplaced(){
+	return replaced;
+}
+
+uint64_t FrameDedupe::getOutvoted(){
+	return outvoted;
+}
@@ -0,0 +1,113 @@
+// File: FrameDedupe.h
+// Description: Defines the stage that merges the copies of a frame that
+// receivers with overlapping coverage each heard into a single frame.
+
+/**
+ * The Frame Dedupe opens a window when a frame arrives from a sensor
+ * it has no window open for, and counts every copy from the same
+ * protocol, sensor, and channel whose time is within the window of
+ * the first as the same transmission, whichever receiver heard it. A sensor
+ * sends every 40 seconds or more, far longer than the window, so its
+ * next reading starts a window of its own. The copies need not agree:
+ * the checksum is a sum of nibbles, which two errors can keep, so a
+ * receiver now and then passes a copy with the wrong nibbles. The
+ * copies vote for their nibbles, and the nibbles with the most votes
+ * win. Among the copies of those, one that passed its checksum beats
+ * one that was repaired, and then the one with the least timing error,
+ * from the receiver that heard the sensor most clearly, is kept. The
+ * window is closed by the caller with the time up to which every copy
+ * has arrived, and its frame handed to a callback.
+ * @file FrameDedupe.h */
+
+#ifndef FRAME_DEDUPE_H
+#define FRAME_DEDUPE_H
+
+#include <Arduino.h>
+#include <FrameQueue.h>
+#include <vector>
+
+#define FRAME_DEDUPE_MAX_RECEIVERS 32 ///< Defines the most receivers, one bit each in the set of receivers of a frame.
+#define FRAME_DEDUPE_VARIANTS 4 ///< Defines the most different nibbles a window counts the votes of.
+
+/** A transmission and the best copy of it.
+ * @struct DedupedFrame */
+struct DedupedFrame{
+	ReceivedFrame best; ///< The best copy.
+	uint64_t open_us; ///< The time of the first copy, which the window starts at.
+	uint64_t first_ns; ///< The time the first copy was decoded on the monotonic clock of the host.
+	uint32_t receivers; ///< The receivers that heard it, one bit each.
+	uint16_t copies; ///< The number of copies.
+	uint16_t votes; ///< The number of copies with the nibbles of the best one.
+	uint8_t variants; ///< The number of different nibbles the copies had.
+};
+
+/** A copy that differs from the others of a window, and its votes.
+ * @struct DedupeVariant */
+struct DedupeVariant{
+	ReceivedFrame best; ///< The best copy with these nibbles.
+	uint16_t votes; ///< The number of copies with these nibbles.
+};
+
+/** A window and the copies it has counted.
+ * @struct DedupeWindow */
+struct DedupeWindow{
+	DedupedFrame frame; ///< The transmission, whose best copy is chosen when the window closes.
+	DedupeVariant variants[FRAME_DEDUPE_VARIANTS]; ///< The copies by their nibbles.
+};
+
+/** The function that receives the merged frames.
+ * @param &frame The frame.
+ * @param *context The context given to the dedupe. */
+typedef void (*DedupeHandler)(const DedupedFrame &frame, void *context);
+
+/** FrameDedupe keeps the best copy of each transmission within a window.
+ * @class FrameDedupe */
+class FrameDedupe
+{
+public:
+	/** The constructor.
+	 * @param window_us The length of the window in microseconds.
+	 * @param handler The function called with every merged frame.
+	 * @param *context Passed to the handler. */
+	FrameDedupe(uint64_t window_us, DedupeHandler handler, void *context);
+	/** Adds a copy of a frame.
+	 * @param &frame The copy.
+	 * @param time_us Its time on the clock the windows are measured on. */
+	void add(const ReceivedFrame &frame, uint64_t time_us);
+	/** Hands over the frames whose windows have ended.
+	 * @param time_us The time up to which every copy has been added. */
+	void close(uint64_t time_us);
+	/** Hands over every frame, as when the receivers have stopped. */
+	void flush();
+	/** Gets the number of copies added. */
+	uint64_t getCopies();
+	/** Gets the number of frames handed over. */
+	uint64_t getFrames();
+	/** Gets the number of times a later copy was better than an earlier one with the same nibbles. */
+	uint64_t getReplaced();
+	/** Gets the number of frames whose copies disagreed, so that some were outvoted. */
+	uint64_t getOutvoted();
+	/** Checks whether a copy of a frame is better than another.
+	 * @param &a The copy.
+	 * @param &b The other copy.
+	 * @return True if a was not repaired and b was, or they agree on it and a has less timing error. */
+	static boolean isBetter(const DecodedFrame &a, const DecodedFrame &b);
+	/** Checks whether two frames come from the same sensor. */
+	static boolean isSameSensor(const DecodedFrame &a, const DecodedFrame &b);
+	/** Checks whether two frames carry the same nibbles. */
+	static boolean isSame(const DecodedFrame &a, const DecodedFrame &b);
+private:
+	/** Chooses the best copy of a window and hands it over. */
+	void emit(DedupeWindow &window);
+
+	uint64_t window_us;
+	DedupeHandler handler;
+	void *context;
+	std::vector<DedupeWindow> open; ///< The open windows, oldest first.
+	uint64_t copies;
+	uint64_t frames;
+	uint64_t replaced;
+	uint64_t outvoted;
+};
+
+#endif // FRAME_DEDUPE_H
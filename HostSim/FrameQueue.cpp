@@ -0,0 +1,66 @@
+#include <FrameQueue.h>
+
+/** A slot of the ring and the position it is next used at. */
+struct FrameSlot{
+	std::atomic<size_t> sequence;
+	ReceivedFrame frame;
+};
+
+FrameQueue::FrameQueue(size_t capacity){
+	size_t size = 2;
+	while(size < capacity){
+		size <<= 1;
+	}
+	slots = new FrameSlot[size];
+	mask = size - 1;
+	// Slot i is free for the producer that claims position i
+	for(size_t i = 0; i < size; i++){
+		slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	head.store(0, std::memory_order_relaxed);
+	tail.store(0, std::memory_order_relaxed);
+}
+
+FrameQueue::~FrameQueue(){
+	delete[] slots;
+}
+
+boolean FrameQueue::push(const ReceivedFrame &frame){
+	size_t position = tail.load(std::memory_order_relaxed);
+	for(;;){
+		FrameSlot &slot = slots[position & mask];
+		size_t sequence = slot.sequence.load(std::memory_order_acquire);
+		intptr_t lag = (intptr_t) sequence - (intptr_t) position;
+		if(lag == 0){
+			// The slot is free, so the first producer to move the tail past it owns it
+			if(tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+				slot.frame = frame;
+				slot.sequence.store(position + 1, std::memory_order_release);
+				return true;
+			}
+		}else if(lag < 0){
+			// The consumer has not emptied the slot from the last lap
+			return false;
+		}else{
+			// Another producer claimed the slot first
+			position = tail.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+boolean FrameQueue::pop(ReceivedFrame &frame){
+	size_t position = head.load(std::memory_order_relaxed);
+	FrameSlot &slot = slots[position & mask];
+	if(slot.sequence.load(std::memory_order_acquire) != position + 1){
+		// Empty, or claimed by a producer that is still copying
+		return false;
+	}
+	frame = slot.frame;
+	slot.sequence.store(position + mask + 1, std::memory_order_release);
+	head.store(position + 1, std::memory_order_relaxed);
+	return true;
+}
+
+size_t FrameQueue::getCapacity(){
+	return mask + 1;
+}
@@ -0,0 +1,67 @@
+// File: FrameQueue.h
+// Description: Defines the lock-free queue that carries the frames of
+// several decoding threads to the single thread that merges them.
+
+/**
+ * The Frame Queue is a bounded ring that any number of threads put
+ * frames into and one thread takes them out of, without a lock.
+ * Every slot has a sequence number that says whose turn it is: a
+ * producer claims the slot at the tail with a compare and swap,
+ * copies the frame in, and then advances the sequence, which hands
+ * the slot to the consumer. The consumer is alone at the head, so
+ * it only reads the sequence, copies the frame out, and hands the
+ * slot back to the producers one lap ahead. A producer that finds
+ * the ring full gets false and decides itself whether to wait.
+ * @file FrameQueue.h */
+
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+#include <Arduino.h>
+#include <PulseDecoder.h>
+#include <atomic>
+
+#define FRAME_QUEUE_LINE 64 ///< Defines the size of a cache line, which keeps the head and tail apart.
+
+/** A frame as one receiver decoded it.
+ * @struct ReceivedFrame */
+struct ReceivedFrame{
+	DecodedFrame frame; ///< The frame.
+	uint8_t receiver; ///< The number of the receiver that heard it.
+	uint64_t end_us; ///< The time of the last pulse of the frame on the clock of the receiver.
+	uint64_t decoded_ns; ///< The time the frame was decoded on the monotonic clock of the host.
+};
+
+struct FrameSlot;
+
+/** FrameQueue passes frames from many threads to one.
+ * @class FrameQueue */
+class FrameQueue
+{
+public:
+	/** The constructor.
+	 * @param capacity The number of slots, rounded up to a power of two. */
+	FrameQueue(size_t capacity);
+	/** The destructor. */
+	~FrameQueue();
+	/** Puts a frame at the tail, from any thread.
+	 * @param &frame The frame.
+	 * @return False if the queue is full. */
+	boolean push(const ReceivedFrame &frame);
+	/** Takes the frame at the head, from the one consuming thread.
+	 * @param &frame Receives the frame.
+	 * @return False if the queue is empty. */
+	boolean pop(ReceivedFrame &frame);
+	/** Gets the number of slots. */
+	size_t getCapacity();
+private:
+	FrameSlot *slots;
+	size_t mask;
+	char padHead[FRAME_QUEUE_LINE];
+	std::atomic<size_t> head;
+	char padTail[FRAME_QUEUE_LINE];
+	std::atomic<size_t> tail;
+	char padEnd[FRAME_QUEUE_LINE];
+};
+
+#endif // FRAME_QUEUE_H
@@ -0,0 +1,84 @@
+#include <GatewayReader.h>
+#include <errno.h>
+#include <unistd.h>
+
+GatewayReader::GatewayReader(GatewayFrameHandler handler, void *context){
+	GatewayReader::handler = handler;
+	GatewayReader::context = context;
+	buffer = new uint8_t[GATEWAY_READ_SIZE + GATEWAY_MAX_ENCODED];
+	frames = 0;
+	badRecords = 0;
+	skippedBytes = 0;
+	skipping = false;
+}
+
+GatewayReader::~GatewayReader(){
+	delete[] buffer;
+}
+
+size_t GatewayReader::parse(uint8_t *data, size_t length){
+	uint8_t *p = data;
+	uint8_t *end = data + length;
+	while(p < end){
+		uint8_t *zero = (uint8_t *) memchr(p, 0, end - p);
+		if(zero == NULL){
+			if(end - p < GATEWAY_MAX_ENCODED && !skipping){
+				break;
+			}
+			// No record is this long, so it is noise or a record whose end was lost
+			skippedBytes += end - p;
+			skipping = true;
+			p = end;
+			break;
+		}
+		size_t encoded = zero - p;
+		if(skipping){
+			skippedBytes += encoded + 1;
+			skipping = false;
+		}else if(encoded > 0){
+			GatewayFrame frame;
+			size_t decoded = encoded < GATEWAY_MAX_ENCODED ? SerialGateway::cobsDecode(p, encoded) : 0;
+			if(decoded > 0 && SerialGateway::parseRecord(p, decoded, frame)){
+				frames++;
+				handler(frame, context);
+			}else{
+				badRecords++;
+			}
+		}
+		p = zero + 1;
+	}
+	return p - data;
+}
+
+boolean GatewayReader::readAll(int fd){
+	size_t kept = 0;
+	for(;;){
+		ssize_t n = read(fd, buffer + kept, GATEWAY_READ_SIZE);
+		if(n < 0 && errno == EINTR){
+			continue;
+		}
+		if(n <= 0){
+			if(kept > 0){
+				badRecords++;
+			}
+			return n == 0;
+		}
+		size_t length = kept + n;
+		size_t used = parse(buffer, length);
+		// Only the start of a record that the read cut off is kept, which is shorter than any record
+		kept = length - used;
+		memmove(buffer, buffer + used, kept);
+	}
+}
+
+uint64_t GatewayReader::getFrames(){
+	return frames;
+}
+
+uint64_t GatewayReader::getBadRecords(){
+	return badRecords;
+}
+
+uint64_t GatewayReader::getSkippedBytes(){
+	return skippedBytes;
+}
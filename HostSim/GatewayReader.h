@@ -0,0 +1,66 @@
+// File: GatewayReader.h
+// Description: Defines the reader that a computer next to the receiver uses
+// to take the frames out of the record stream of the gateway environment.
+
+/**
+ * The Gateway Reader finds the records in the stream at the zeros
+ * that end them, decodes each in place where it lies, checks its
+ * CRC, and hands the frame to a callback with its nibbles still in
+ * the buffer. Nothing is copied out of the buffer the bytes were
+ * read into except the part of a record that a read cut off, which
+ * is moved to the front to be finished by the next read. Bytes that
+ * run longer than any record without a zero are thrown away until
+ * the next zero, where reading picks up again.
+ * @file GatewayReader.h */
+
+#ifndef GATEWAY_READER_H
+#define GATEWAY_READER_H
+
+#include <Arduino.h>
+#include <SerialGateway.h>
+
+#define GATEWAY_READ_SIZE 65536 ///< Defines the size of the reads from a file or device.
+
+/** The function that receives the frames.
+ * @param &frame The frame, valid only during the call.
+ * @param *context The context given to the reader. */
+typedef void (*GatewayFrameHandler)(const GatewayFrame &frame, void *context);
+
+/** GatewayReader parses the record stream of the gateway environment.
+ * @class GatewayReader */
+class GatewayReader
+{
+public:
+	/** The constructor.
+	 * @param handler The function called with every frame.
+	 * @param *context Passed to the handler. */
+	GatewayReader(GatewayFrameHandler handler, void *context);
+	/** The destructor. */
+	~GatewayReader();
+	/** Parses the records in a buffer, decoding them in place.
+	 * @param *data The bytes of the stream, which are overwritten.
+	 * @param length The number of bytes.
+	 * @return The bytes consumed. Those after it start a record that is not
+	 * finished yet and must be passed again with the bytes that follow. */
+	size_t parse(uint8_t *data, size_t length);
+	/** Reads a file, pipe, or serial device to its end and parses all of it.
+	 * @param fd The open descriptor.
+	 * @return False if reading failed. */
+	boolean readAll(int fd);
+	/** Gets the number of frames handed to the callback. */
+	uint64_t getFrames();
+	/** Gets the number of records thrown away for a bad length, COBS code, or CRC. */
+	uint64_t getBadRecords();
+	/** Gets the number of bytes skipped while looking for the end of a record. */
+	uint64_t getSkippedBytes();
+private:
+	GatewayFrameHandler handler;
+	void *context;
+	uint8_t *buffer;
+	uint64_t frames;
+	uint64_t badRecords;
+	uint64_t skippedBytes;
+	boolean skipping;
+};
+
+#endif // GATEWAY_READER_H
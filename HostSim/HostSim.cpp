@@ -0,0 +1,255 @@
+#include <HostSim.h>
+#include <queue>
+#include <vector>
+
+volatile uint8_t hostsim_port_input[HOSTSIM_NUM_PINS / 8];
+volatile uint8_t hostsim_pcint_registers[8];
+
+/** An edge that is waiting to fire. */
+struct ScheduledEdge{
+	uint64_t at;
+	uint8_t interruptNum;
+	bool operator>(const ScheduledEdge &other) const { return at > other.at; }
+};
+
+static uint64_t now_us = 0;
+static uint64_t end_us = UINT64_MAX;
+static uint64_t last_edge_us = 0;
+static uint64_t edges_fired = 0;
+static uint32_t cycle_us = HOSTSIM_DEFAULT_CYCLE_US;
+static boolean in_isr = false;
+static boolean interrupts_enabled = true;
+static boolean serial_enabled = true;
+static void (*end_hook)() = NULL;
+static void (*pin_write_hook)(uint8_t pin, uint8_t level) = NULL;
+static void (*isrs[HOSTSIM_NUM_INTERRUPTS])() = {NULL, NULL};
+static uint8_t pin_modes[HOSTSIM_NUM_PINS];
+static std::priority_queue<ScheduledEdge, std::vector<ScheduledEdge>, std::greater<ScheduledEdge> > *edges = NULL;
+
+// The queue is created on first use because the sketch attaches its
+// interrupt from a static constructor.
+static std::priority_queue<ScheduledEdge, std::vector<ScheduledEdge>, std::greater<ScheduledEdge> > &edgeQueue(){
+	if(edges == NULL){
+		edges = new std::priority_queue<ScheduledEdge, std::vector<ScheduledEdge>, std::greater<ScheduledEdge> >();
+	}
+	return *edges;
+}
+
+static void writePin(uint8_t pin, uint8_t level){
+	if(pin >= HOSTSIM_NUM_PINS){
+		return;
+	}
+	if(level){
+		hostsim_port_input[pin / 8] |= 1 << (pin % 8);
+	}else{
+		hostsim_port_input[pin / 8] &= ~(1 << (pin % 8));
+	}
+}
+
+// Fires the edges that are due, with the clock set to the time of each edge
+static void fireDueEdges(uint64_t until){
+	if(in_isr || !interrupts_enabled){
+		return;
+	}
+	while(!edgeQueue().empty() && edgeQueue().top().at <= until){
+		ScheduledEdge edge = edgeQueue().top();
+		edgeQueue().pop();
+		if(edge.at > now_us){
+			now_us = edge.at;
+		}
+		uint8_t pin = hostsim_interrupt_pin(edge.interruptNum);
+		writePin(pin, !digitalRead(pin));
+		edges_fired++;
+		if(isrs[edge.interruptNum] != NULL){
+			in_isr = true;
+			isrs[edge.interruptNum]();
+			in_isr = false;
+		}
+	}
+}
+
+uint64_t hostsim_time_us(){
+	return now_us;
+}
+
+void hostsim_advance(uint64_t us){
+	uint64_t target = now_us + us;
+	fireDueEdges(target);
+	if(target > now_us){
+		now_us = target;
+	}
+	if(now_us >= end_us && !in_isr){
+		hostsim_end();
+	}
+}
+
+void hostsim_set_cycle_us(uint32_t us){
+	cycle_us = us;
+}
+
+void hostsim_set_end_us(uint64_t us){
+	end_us = us;
+}
+
+void hostsim_on_end(void (*hook)()){
+	end_hook = hook;
+}
+
+void hostsim_end(){
+	fflush(stdout);
+	if(end_hook != NULL){
+		void (*hook)() = end_hook;
+		end_hook = NULL;
+		hook();
+	}
+	fflush(stdout);
+	exit(0);
+}
+
+uint8_t hostsim_interrupt_pin(uint8_t interruptNum){
+	return interruptNum == 0 ? 2 : 3;
+}
+
+void hostsim_schedule_edge(uint8_t interruptNum, uint64_t at){
+	ScheduledEdge edge = {at, interruptNum};
+	edgeQueue().push(edge);
+	if(at > last_edge_us){
+		last_edge_us = at;
+	}
+}
+
+uint64_t hostsim_schedule_pulses(uint8_t interruptNum, const uint32_t *widths, size_t count, uint64_t start){
+	uint64_t at = start;
+	hostsim_schedule_edge(interruptNum, at);
+	for(size_t i = 0; i < count; i++){
+		at += widths[i];
+		hostsim_schedule_edge(interruptNum, at);
+	}
+	return at;
+}
+
+uint64_t hostsim_schedule_pulse_file(uint8_t interruptNum, const char *path, uint64_t start){
+	FILE *file = fopen(path, "r");
+	if(file == NULL){
+		return 0;
+	}
+	char line[64];
+	uint64_t at = start;
+	hostsim_schedule_edge(interruptNum, at);
+	while(fgets(line, sizeof(line), file) != NULL){
+		if(line[0] == '#'){
+			continue;
+		}
+		char *end;
+		unsigned long width = strtoul(line, &end, 10);
+		if(end == line){
+			continue;
+		}
+		at += width;
+		hostsim_schedule_edge(interruptNum, at);
+	}
+	fclose(file);
+	return at;
+}
+
+uint64_t hostsim_last_edge_us(){
+	return last_edge_us;
+}
+
+uint64_t hostsim_edges_fired(){
+	return edges_fired;
+}
+
+void hostsim_set_pin(uint8_t pin, uint8_t level){
+	writePin(pin, level);
+}
+
+void hostsim_on_pin_write(void (*hook)(uint8_t pin, uint8_t level)){
+	pin_write_hook = hook;
+}
+
+void hostsim_set_serial_enabled(boolean enabled){
+	serial_enabled = enabled;
+}
+
+boolean hostsim_serial_enabled(){
+	return serial_enabled;
+}
+
+/*
+ * The Arduino time, pin, and interrupt functions
+ */
+unsigned long micros(){
+	if(in_isr){
+		return (uint32_t) now_us;
+	}
+	hostsim_advance(cycle_us);
+	return (uint32_t) now_us;
+}
+
+unsigned long millis(){
+	if(in_isr){
+		return (uint32_t) (now_us / 1000);
+	}
+	hostsim_advance(cycle_us);
+	return (uint32_t) (now_us / 1000);
+}
+
+void delay(unsigned long ms){
+	hostsim_advance((uint64_t) ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us){
+	hostsim_advance(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode){
+	if(pin >= HOSTSIM_NUM_PINS){
+		return;
+	}
+	pin_modes[pin] = mode;
+	// Inputs float high through the pull up
+	if(mode == INPUT_PULLUP){
+		writePin(pin, HIGH);
+	}
+}
+
+void digitalWrite(uint8_t pin, uint8_t val){
+	writePin(pin, val);
+	if(pin_write_hook != NULL){
+		pin_write_hook(pin, val);
+	}
+}
+
+int digitalRead(uint8_t pin){
+	if(pin >= HOSTSIM_NUM_PINS){
+		return LOW;
+	}
+	return (hostsim_port_input[pin / 8] >> (pin % 8)) & 0x01;
+}
+
+int analogRead(uint8_t pin){
+	return digitalRead(pin) ? 1023 : 0;
+}
+
+void attachInterrupt(uint8_t interruptNum, void (*isr)(void), int mode){
+	(void) mode;
+	if(interruptNum < HOSTSIM_NUM_INTERRUPTS){
+		isrs[interruptNum] = isr;
+	}
+}
+
+void detachInterrupt(uint8_t interruptNum){
+	if(interruptNum < HOSTSIM_NUM_INTERRUPTS){
+		isrs[interruptNum] = NULL;
+	}
+}
+
+void interrupts(){
+	interrupts_enabled = true;
+	fireDueEdges(now_us);
+}
+
+void noInterrupts(){
+	interrupts_enabled = false;
+}
@@ -0,0 +1,85 @@
+// File: HostSim.h
+// Description: Defines the virtual clock and the interrupt injector that
+// let the firmware run on Linux faster than real time.
+
+/**
+ * The Host Simulation keeps a virtual clock in microseconds. Every
+ * read of micros() or millis() advances the clock by a small cost so
+ * that busy loops make progress, and delay() jumps the clock forward.
+ * Edges scheduled on an external interrupt fire the attached ISR as
+ * soon as the clock passes their time, with micros() reporting the
+ * time of the edge inside the ISR, just as a pin change would
+ * interrupt the main loop on the device. The simulation ends when
+ * the clock reaches the end time.
+ * @file HostSim.h */
+
+#ifndef HOSTSIM_H
+#define HOSTSIM_H
+
+#include <Arduino.h>
+
+#define HOSTSIM_NUM_INTERRUPTS 2 ///< Defines the number of external interrupts.
+#define HOSTSIM_DEFAULT_CYCLE_US 4 ///< Defines how far each read of the clock advances it (in microseconds).
+
+/** Gets the current time of the virtual clock.
+ * @return The time in microseconds since the simulation started. */
+uint64_t hostsim_time_us();
+/** Advances the virtual clock, firing every interrupt that becomes due.
+ * @param us The number of microseconds to advance by. */
+void hostsim_advance(uint64_t us);
+/** Sets how far each read of the clock advances it.
+ * @param us The cost of a read in microseconds. */
+void hostsim_set_cycle_us(uint32_t us);
+/** Sets the time at which the simulation ends.
+ * @param us The end time in microseconds. */
+void hostsim_set_end_us(uint64_t us);
+/** Registers a function that is called when the simulation ends, before the process exits.
+ * @param hook The function to call. */
+void hostsim_on_end(void (*hook)());
+/** Ends the simulation. */
+void hostsim_end();
+
+/** Gets the pin that an external interrupt is attached to.
+ * @param interruptNum The number of the interrupt.
+ * @return The digital pin of the interrupt. */
+uint8_t hostsim_interrupt_pin(uint8_t interruptNum);
+/** Schedules an edge on an external interrupt pin.
+ * @param interruptNum The number of the interrupt.
+ * @param at The time of the edge in microseconds. */
+void hostsim_schedule_edge(uint8_t interruptNum, uint64_t at);
+/** Schedules a train of pulses, each pulse ending with an edge.
+ * @param interruptNum The number of the interrupt.
+ * @param *widths The width of every pulse in microseconds.
+ * @param count The number of pulses.
+ * @param start The time of the edge that begins the first pulse.
+ * @return The time of the last edge. */
+uint64_t hostsim_schedule_pulses(uint8_t interruptNum, const uint32_t *widths, size_t count, uint64_t start);
+/** Schedules the pulses in a pulse timeline file. The file holds one
+ * pulse width in microseconds per line; lines starting with # are ignored.
+ * @param interruptNum The number of the interrupt.
+ * @param *path The path of the file.
+ * @param start The time of the edge that begins the first pulse.
+ * @return The time of the last edge, or 0 if the file could not be read. */
+uint64_t hostsim_schedule_pulse_file(uint8_t interruptNum, const char *path, uint64_t start);
+/** Gets the time of the last edge that is scheduled.
+ * @return The time in microseconds or 0 if no edge is scheduled. */
+uint64_t hostsim_last_edge_us();
+/** Gets the number of edges that have fired. */
+uint64_t hostsim_edges_fired();
+
+/** Sets the level of an input pin as if an external device drove it.
+ * @param pin The digital pin.
+ * @param level HIGH or LOW. */
+void hostsim_set_pin(uint8_t pin, uint8_t level);
+
+/** Registers a function that is called whenever the firmware writes a pin,
+ * such as the chip select of a simulated SPI device.
+ * @param hook The function, given the pin and the level written. */
+void hostsim_on_pin_write(void (*hook)(uint8_t pin, uint8_t level));
+
+/** Enables or disables the output of the Serial port. */
+void hostsim_set_serial_enabled(boolean enabled);
+/** Checks whether the output of the Serial port is enabled. */
+boolean hostsim_serial_enabled();
+
+#endif // HOSTSIM_H
@@ -0,0 +1,73 @@
+// File: LiquidCrystal.h
+// Description: An HD44780 character LCD that keeps its screen in memory
+// and counts the commands and characters sent over its bus.
+
+#ifndef HOSTSIM_LIQUID_CRYSTAL_H
+#define HOSTSIM_LIQUID_CRYSTAL_H
+
+#include <Arduino.h>
+
+#define HOSTSIM_LCD_MAX_COLS 20 ///< Defines the widest screen that is simulated.
+#define HOSTSIM_LCD_MAX_ROWS 4 ///< Defines the tallest screen that is simulated.
+
+/** The character LCD. */
+class LiquidCrystal : public Print
+{
+public:
+	LiquidCrystal(uint8_t rs, uint8_t enable, uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7){
+		(void) rs; (void) enable; (void) d4; (void) d5; (void) d6; (void) d7;
+		cols = HOSTSIM_LCD_MAX_COLS;
+		rows = HOSTSIM_LCD_MAX_ROWS;
+		busWrites = 0;
+		clears = 0;
+		clear();
+		clears = 0;
+		busWrites = 0;
+	}
+	void begin(uint8_t cols, uint8_t rows){
+		LiquidCrystal::cols = cols < HOSTSIM_LCD_MAX_COLS ? cols : HOSTSIM_LCD_MAX_COLS;
+		LiquidCrystal::rows = rows < HOSTSIM_LCD_MAX_ROWS ? rows : HOSTSIM_LCD_MAX_ROWS;
+	}
+	/** Clears the screen, which takes about 1.5 ms on the device. */
+	void clear(){
+		memset(screen, ' ', sizeof(screen));
+		col = 0;
+		row = 0;
+		busWrites++;
+		clears++;
+	}
+	void home(){ setCursor(0, 0); }
+	void setCursor(uint8_t col, uint8_t row){
+		LiquidCrystal::col = col;
+		LiquidCrystal::row = row;
+		busWrites++;
+	}
+	size_t write(uint8_t c){
+		if(row < rows && col < cols){
+			screen[row][col] = c;
+		}
+		col++;
+		busWrites++;
+		return 1;
+	}
+	using Print::write;
+	/** Gets a row of the screen as a null terminated string. */
+	const char *getRow(uint8_t r){
+		static char line[HOSTSIM_LCD_MAX_COLS + 1];
+		memcpy(line, screen[r], cols);
+		line[cols] = '\0';
+		return line;
+	}
+	/** The number of commands and characters sent over the bus. */
+	unsigned long busWrites;
+	/** The number of times the screen was cleared. */
+	unsigned long clears;
+private:
+	char screen[HOSTSIM_LCD_MAX_ROWS][HOSTSIM_LCD_MAX_COLS];
+	uint8_t cols;
+	uint8_t rows;
+	uint8_t col;
+	uint8_t row;
+};
+
+#endif // HOSTSIM_LIQUID_CRYSTAL_H
@@ -0,0 +1,193 @@
+#include <MockServer.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int listen_socket = -1;
+static std::string server_key;
+static int building_id = -1;
+static std::string sensors;
+static boolean verbose = false;
+static uint32_t queries = 0;
+static uint32_t bad_uploads = 0;
+static std::vector<std::string> uploads;
+static std::mutex lock;
+
+// The same Vigenere cipher as encryption.ino
+static std::string encrypt(const std::string &plain){
+	std::string out(plain);
+	for(size_t i = 0; i < plain.size(); i++){
+		char c = plain[i] + server_key[i % server_key.size()] - 32;
+		if((unsigned char) c >= 127){
+			c -= 127 - 32;
+		}
+		out[i] = c;
+	}
+	return out;
+}
+
+static std::string decrypt(const std::string &encrypted){
+	std::string out(encrypted);
+	for(size_t i = 0; i < encrypted.size(); i++){
+		int c = (unsigned char) encrypted[i] - (server_key[i % server_key.size()] - 32);
+		if(c < 32 || c >= 127){
+			c += 127 - 32;
+		}
+		out[i] = (char) c;
+	}
+	return out;
+}
+
+// Reads the request line, the headers, and Content-Length bytes of body
+static boolean readRequest(int sock, std::string &head, std::string &body){
+	std::string data;
+	char buffer[256];
+	size_t headEnd = std::string::npos;
+	size_t bodyStart = 0;
+	while(headEnd == std::string::npos){
+		ssize_t n = recv(sock, buffer, sizeof(buffer), 0);
+		if(n <= 0){
+			return false;
+		}
+		data.append(buffer, n);
+		// The sketch ends its lines with a bare newline
+		if((headEnd = data.find("\n\n")) != std::string::npos){
+			bodyStart = headEnd + 2;
+		}else if((headEnd = data.find("\n\r\n")) != std::string::npos){
+			bodyStart = headEnd + 3;
+		}
+	}
+	head = data.substr(0, headEnd);
+	size_t length = 0;
+	size_t field = head.find("Content-Length:");
+	if(field != std::string::npos){
+		length = strtoul(head.c_str() + field + 15, NULL, 10);
+	}
+	body = data.substr(bodyStart);
+	while(body.size() < length){
+		ssize_t n = recv(sock, buffer, sizeof(buffer), 0);
+		if(n <= 0){
+			break;
+		}
+		body.append(buffer, n);
+	}
+	return true;
+}
+
+static void reply(int sock, const std::string &body){
+	char head[160];
+	snprintf(head, sizeof(head), "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: %u\r\nConnection: close\r\n\r\n", (unsigned) body.size());
+	std::string response = head + body;
+	send(sock, response.data(), response.size(), MSG_NOSIGNAL);
+}
+
+static void handleUpload(const std::string &body){
+	std::string encrypted;
+	size_t begin = body.find("\"encrypted\":\"");
+	size_t end = body.rfind("\"}");
+	if(begin != std::string::npos && end != std::string::npos && end > begin + 13){
+		// The sketch escapes the quotes and backslashes of the cipher text
+		for(size_t i = begin + 13; i < end; i++){
+			if(body[i] == '\\' && i + 1 < end){
+				i++;
+			}
+			encrypted += body[i];
+		}
+	}
+	std::string json = decrypt(encrypted);
+	std::lock_guard<std::mutex> guard(lock);
+	if(json.empty() || json[0] != '{' || json[json.size() - 1] != '}'){
+		bad_uploads++;
+	}
+	uploads.push_back(json);
+	if(verbose){
+		fprintf(stderr, "upload: %s\n", json.c_str());
+	}
+}
+
+static void serve(){
+	while(1){
+		int sock = accept(listen_socket, NULL, NULL);
+		if(sock < 0){
+			continue;
+		}
+		std::string head;
+		std::string body;
+		if(readRequest(sock, head, body)){
+			if(head.compare(0, 4, "POST") == 0){
+				handleUpload(body);
+				reply(sock, "start\nSuccess uploading data\n");
+			}else{
+				char plain[128];
+				{
+					std::lock_guard<std::mutex> guard(lock);
+					snprintf(plain, sizeof(plain), "%ld building %d cutoff 0%s%s", (long) time(NULL), building_id,
+						sensors.empty() ? "" : " sensors ", sensors.c_str());
+					queries++;
+				}
+				reply(sock, "start " + encrypt(plain) + " end");
+			}
+		}
+		close(sock);
+	}
+}
+
+void mock_server_set_sensors(const char *hex){
+	std::lock_guard<std::mutex> guard(lock);
+	sensors = hex;
+}
+
+boolean mock_server_start(uint16_t port, const char *key, int buildingId){
+	server_key = key;
+	building_id = buildingId;
+	listen_socket = socket(AF_INET, SOCK_STREAM, 0);
+	if(listen_socket < 0){
+		return false;
+	}
+	int yes = 1;
+	setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if(bind(listen_socket, (struct sockaddr *) &addr, sizeof(addr)) != 0 || listen(listen_socket, 4) != 0){
+		close(listen_socket);
+		listen_socket = -1;
+		return false;
+	}
+	std::thread(serve).detach();
+	return true;
+}
+
+void mock_server_set_verbose(boolean enabled){
+	verbose = enabled;
+}
+
+uint32_t mock_server_queries(){
+	std::lock_guard<std::mutex> guard(lock);
+	return queries;
+}
+
+uint32_t mock_server_uploads(){
+	std::lock_guard<std::mutex> guard(lock);
+	return uploads.size();
+}
+
+uint32_t mock_server_bad_uploads(){
+	std::lock_guard<std::mutex> guard(lock);
+	return bad_uploads;
+}
+
+String mock_server_upload(uint32_t index){
+	std::lock_guard<std::mutex> guard(lock);
+	if(index >= uploads.size()){
+		return String("");
+	}
+	return String(uploads[index].c_str());
+}
@@ -0,0 +1,43 @@
+// File: MockServer.h
+// Description: Defines a stand-in for the Ruby on Rails server that the
+// host simulation talks to over loopback.
+
+/**
+ * The Mock Server answers the two requests that the sketch makes:
+ * the building query (GET /first_contact/...) with an encrypted
+ * "time building cutoff" reply, followed by the sensors to listen for
+ * when they are set, and the upload of sensor data
+ * (POST /sensor_data/batch_create/...) with the success message.
+ * Uploads are decrypted with the same Vigenere key as the sketch
+ * and kept so the run can be checked. It serves one connection at
+ * a time from its own thread.
+ * @file MockServer.h */
+
+#ifndef MOCK_SERVER_H
+#define MOCK_SERVER_H
+
+#include <Arduino.h>
+
+/** Starts the server.
+ * @param port The port to listen on.
+ * @param *key The encryption key shared with the sketch.
+ * @param buildingId The building id returned by the building query, or -1 to leave the device inactive.
+ * @return Whether the server is listening. */
+boolean mock_server_start(uint16_t port, const char *key, int buildingId);
+/** Sets the sensor configuration pushed in the reply to the building query.
+ * @param *hex The records in hex as SensorConfig::toHex writes them, or "" to push none. */
+void mock_server_set_sensors(const char *hex);
+/** Sets whether every decrypted upload is printed to stderr. */
+void mock_server_set_verbose(boolean verbose);
+/** Gets the number of building queries that were answered. */
+uint32_t mock_server_queries();
+/** Gets the number of uploads that were answered. */
+uint32_t mock_server_uploads();
+/** Gets the number of uploads whose decrypted body was not a JSON object. */
+uint32_t mock_server_bad_uploads();
+/** Gets a decrypted upload.
+ * @param index The index of the upload, starting from the first.
+ * @return The JSON body, or an empty string if there is no such upload. */
+String mock_server_upload(uint32_t index);
+
+#endif // MOCK_SERVER_H
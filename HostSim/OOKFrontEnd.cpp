@@ -0,0 +1,336 @@
+#include <OOKFrontEnd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define OOK_X86
+#endif
+
+/*
+ * The scalar kernels, which also handle the samples left over by the vector kernels
+ */
+template<bool SIGNED_IQ> static void scalarIQ(const uint8_t *in, size_t samples, int32_t on, int32_t off, uint32_t *onMasks, uint32_t *offMasks){
+	for(size_t w = 0; w * 32 < samples; w++){
+		uint32_t onBits = 0;
+		uint32_t offBits = 0;
+		size_t n = samples - w * 32 < 32 ? samples - w * 32 : 32;
+		for(size_t b = 0; b < n; b++){
+			const uint8_t *s = in + (w * 32 + b) * 2;
+			int32_t i = SIGNED_IQ ? (int8_t) s[0] : s[0] - 128;
+			int32_t q = SIGNED_IQ ? (int8_t) s[1] : s[1] - 128;
+			int32_t m = i * i + q * q;
+			onBits |= (uint32_t) (m > on) << b;
+			offBits |= (uint32_t) (m < off) << b;
+		}
+		onMasks[w] = onBits;
+		offMasks[w] = offBits;
+	}
+}
+
+static void scalarMag(const uint8_t *in, size_t samples, int32_t on, int32_t off, uint32_t *onMasks, uint32_t *offMasks){
+	for(size_t w = 0; w * 32 < samples; w++){
+		uint32_t onBits = 0;
+		uint32_t offBits = 0;
+		size_t n = samples - w * 32 < 32 ? samples - w * 32 : 32;
+		for(size_t b = 0; b < n; b++){
+			int32_t m = in[w * 32 + b];
+			onBits |= (uint32_t) (m > on) << b;
+			offBits |= (uint32_t) (m < off) << b;
+		}
+		onMasks[w] = onBits;
+		offMasks[w] = offBits;
+	}
+}
+
+#ifdef OOK_X86
+// Magnitude samples are bytes, so the thresholds are too
+static int clampByte(int32_t level){
+	return level < 0 ? 0 : level > 255 ? 255 : level;
+}
+
+/*
+ * The SSE2 kernels. I and Q are widened to 16 bits and a multiply-add
+ * of the vector with itself gives I*I + Q*Q for four samples at once.
+ * The vector kernels handle whole words of 32 samples.
+ */
+template<bool SIGNED_IQ> static void sse2IQ(const uint8_t *in, size_t samples, int32_t on, int32_t off, uint32_t *onMasks, uint32_t *offMasks){
+	const __m128i bias = _mm_set1_epi8((char) 0x80);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i onV = _mm_set1_epi32(on);
+	const __m128i offV = _mm_set1_epi32(off);
+	for(size_t w = 0; w < samples / 32; w++){
+		uint32_t onBits = 0;
+		uint32_t offBits = 0;
+		for(int k = 0; k < 4; k++){
+			__m128i v = _mm_loadu_si128((const __m128i *) (in + w * 64 + k * 16));
+			if(!SIGNED_IQ){
+				v = _mm_xor_si128(v, bias);
+			}
+			__m128i sign = _mm_cmpgt_epi8(zero, v);
+			__m128i low = _mm_unpacklo_epi8(v, sign);
+			__m128i high = _mm_unpackhi_epi8(v, sign);
+			__m128i m0 = _mm_madd_epi16(low, low);
+			__m128i m1 = _mm_madd_epi16(high, high);
+			uint32_t onNibbles = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(m0, onV)))
+				| (_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(m1, onV))) << 4);
+			uint32_t offNibbles = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(m0, offV)))
+				| (_mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(m1, offV))) << 4);
+			onBits |= onNibbles << (k * 8);
+			offBits |= offNibbles << (k * 8);
+		}
+		onMasks[w] = onBits;
+		offMasks[w] = offBits;
+	}
+}
+
+// Unsigned bytes are compared as signed ones after flipping their top bits
+static void sse2Mag(const uint8_t *in, size_t samples, int32_t on, int32_t off, uint32_t *onMasks, uint32_t *offMasks){
+	const __m128i bias = _mm_set1_epi8((char) 0x80);
+	const __m128i onV = _mm_set1_epi8((char) (clampByte(on) ^ 0x80));
+	const __m128i offV = _mm_set1_epi8((char) (clampByte(off) ^ 0x80));
+	for(size_t w = 0; w < samples / 32; w++){
+		__m128i a = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (in + w * 32)), bias);
+		__m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (in + w * 32 + 16)), bias);
+		onMasks[w] = _mm_movemask_epi8(_mm_cmpgt_epi8(a, onV)) | (_mm_movemask_epi8(_mm_cmpgt_epi8(b, onV)) << 16);
+		offMasks[w] = _mm_movemask_epi8(_mm_cmplt_epi8(a, offV)) | (_mm_movemask_epi8(_mm_cmplt_epi8(b, offV)) << 16);
+	}
+}
+
+/*
+ * The AVX2 kernels, which widen 16 samples of I and Q per instruction.
+ */
+template<bool SIGNED_IQ> __attribute__((target("avx2"))) static void avx2IQ(const uint8_t *in, size_t samples, int32_t on, int32_t off, uint32_t *onMasks, uint32_t *offMasks){
+	const __m256i bias = _mm256_set1_epi8((char) 0x80);
+	const __m256i onV = _mm256_set1_epi32(on);
+	const __m256i offV = _mm256_set1_epi32(off);
+	for(size_t w = 0; w < samples / 32; w++){
+		uint32_t onBits = 0;
+		uint32_t offBits = 0;
+		for(int k = 0; k < 2; k++){
+			__m256i v = _mm256_loadu_si256((const __m256i *) (in + w * 64 + k * 32));
+			if(!SIGNED_IQ){
+				v = _mm256_xor_si256(v, bias);
+			}
+			__m256i low = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(v));
+			__m256i high = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(v, 1));
+			__m256i m0 = _mm256_madd_epi16(low, low);
+			__m256i m1 = _mm256_madd_epi16(high, high);
+			uint32_t onBytes = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(m0, onV)))
+				| (_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(m1, onV))) << 8);
+			uint32_t offBytes = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(offV, m0)))
+				| (_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(offV, m1))) << 8);
+			onBits |= onBytes << (k * 16);
+			offBits |= offBytes << (k * 16);
+		}
+		onMasks[w] = onBits;
+		offMasks[w] = offBits;
+	}
+}
+
+__attribute__((target("avx2"))) static void avx2Mag(const uint8_t *in, size_t samples, int32_t on, int32_t off, uint32_t *onMasks, uint32_t *offMasks){
+	const __m256i bias = _mm256_set1_epi8((char) 0x80);
+	const __m256i onV = _mm256_set1_epi8((char) (clampByte(on) ^ 0x80));
+	const __m256i offV = _mm256_set1_epi8((char) (clampByte(off) ^ 0x80));
+	for(size_t w = 0; w < samples / 32; w++){
+		__m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (in + w * 32)), bias);
+		onMasks[w] = _mm256_movemask_epi8(_mm256_cmpgt_epi8(v, onV));
+		offMasks[w] = _mm256_movemask_epi8(_mm256_cmpgt_epi8(offV, v));
+	}
+}
+#endif // OOK_X86
+
+OOKFrontEnd::OOKFrontEnd(OOKSampleFormat format, uint32_t sampleRate, OOKKernel kernel, PulseSink sink, void *context){
+	OOKFrontEnd::format = format;
+	OOKFrontEnd::sampleRate = sampleRate;
+	OOKFrontEnd::sink = sink;
+	OOKFrontEnd::context = context;
+	sampleBytes = bytesPerSample(format);
+	if(kernel == OOK_KERNEL_AUTO){
+		kernel = kernelAvailable(OOK_KERNEL_AVX2) ? OOK_KERNEL_AVX2 : kernelAvailable(OOK_KERNEL_SSE2) ? OOK_KERNEL_SSE2 : OOK_KERNEL_SCALAR;
+	}else if(!kernelAvailable(kernel)){
+		kernel = OOK_KERNEL_SCALAR;
+	}
+	OOKFrontEnd::kernel = kernel;
+	switch(format){
+	case OOK_IQ8_UNSIGNED: tailKernel = scalarIQ<false>; break;
+	case OOK_IQ8_SIGNED: tailKernel = scalarIQ<true>; break;
+	default: tailKernel = scalarMag; break;
+	}
+	maskKernel = tailKernel;
+#ifdef OOK_X86
+	if(kernel == OOK_KERNEL_SSE2){
+		maskKernel = format == OOK_IQ8_UNSIGNED ? sse2IQ<false> : format == OOK_IQ8_SIGNED ? sse2IQ<true> : sse2Mag;
+	}else if(kernel == OOK_KERNEL_AVX2){
+		maskKernel = format == OOK_IQ8_UNSIGNED ? avx2IQ<false> : format == OOK_IQ8_SIGNED ? avx2IQ<true> : avx2Mag;
+	}
+#endif
+	fixedThreshold = 0;
+	onThreshold = 0;
+	offThreshold = 0;
+	peak = 0;
+	noise = -1;
+	samples = 0;
+	edges = 0;
+	lastEdgeUs = 0;
+	pending = 0;
+	merging = false;
+	on = false;
+}
+
+void OOKFrontEnd::setThreshold(uint32_t level){
+	fixedThreshold = level;
+}
+
+uint8_t OOKFrontEnd::bytesPerSample(OOKSampleFormat format){
+	return format == OOK_MAG8 ? 1 : 2;
+}
+
+boolean OOKFrontEnd::kernelAvailable(OOKKernel kernel){
+	switch(kernel){
+	case OOK_KERNEL_SCALAR:
+	case OOK_KERNEL_AUTO:
+		return true;
+#ifdef OOK_X86
+	case OOK_KERNEL_SSE2:
+		return __builtin_cpu_supports("sse2");
+	case OOK_KERNEL_AVX2:
+		return __builtin_cpu_supports("avx2");
+#endif
+	default:
+		return false;
+	}
+}
+
+const char *OOKFrontEnd::kernelName(OOKKernel kernel){
+	switch(kernel){
+	case OOK_KERNEL_SCALAR: return "scalar";
+	case OOK_KERNEL_SSE2: return "sse2";
+	case OOK_KERNEL_AVX2: return "avx2";
+	default: return "auto";
+	}
+}
+
+int32_t OOKFrontEnd::magnitude(const uint8_t *sample){
+	switch(format){
+	case OOK_IQ8_UNSIGNED:
+		return (sample[0] - 128) * (sample[0] - 128) + (sample[1] - 128) * (sample[1] - 128);
+	case OOK_IQ8_SIGNED:
+		return (int8_t) sample[0] * (int8_t) sample[0] + (int8_t) sample[1] * (int8_t) sample[1];
+	default:
+		return sample[0];
+	}
+}
+
+void OOKFrontEnd::updateThresholds(const uint8_t *data, size_t count){
+	if(fixedThreshold > 0){
+		onThreshold = fixedThreshold;
+		offThreshold = fixedThreshold / 2;
+		return;
+	}
+	int64_t blockMax = 0;
+	int64_t quietSum = 0;
+	size_t quiet = 0;
+	for(size_t i = 0; i < count; i += OOK_STAT_STRIDE){
+		int32_t m = magnitude(data + i * sampleBytes);
+		// Only the samples that are off measure the noise, so transmissions do not raise it
+		if(m < offThreshold || noise < 0){
+			quietSum += m;
+			quiet++;
+		}
+		if(m > blockMax){
+			blockMax = m;
+		}
+	}
+	// The peak decays so that a strong transmission does not hide a weak one for long
+	peak = blockMax > peak - peak / 64 ? blockMax : peak - peak / 64;
+	if(quiet > 0){
+		int64_t blockNoise = quietSum / quiet;
+		noise = noise < 0 ? blockNoise : noise + (blockNoise - noise) / 8;
+	}
+	// Half the peak amplitude, which is a quarter of the peak power
+	int64_t level;
+	int64_t floor;
+	if(format == OOK_MAG8){
+		level = peak / 2;
+		floor = noise * 7 / 2;
+	}else{
+		level = peak / 4;
+		floor = noise * 10;
+	}
+	if(level < floor){
+		level = floor;
+	}
+	if(level < 1){
+		level = 1;
+	}
+	onThreshold = level;
+	offThreshold = level / 2;
+}
+
+void OOKFrontEnd::edge(uint64_t sample){
+	uint64_t us = sample * 1000000 / sampleRate;
+	uint64_t width = us - lastEdgeUs;
+	lastEdgeUs = us;
+	edges++;
+	// A glitch and the pulse after it continue the pending pulse
+	if(merging){
+		pending += width;
+		merging = false;
+	}else if(width < OOK_GLITCH_US && pending > 0){
+		pending += width;
+		merging = true;
+	}else{
+		if(pending > 0){
+			sink(pending > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t) pending, context);
+		}
+		pending = width;
+	}
+}
+
+void OOKFrontEnd::processBlock(const uint8_t *data, size_t count){
+	updateThresholds(data, count);
+	size_t whole = count & ~(size_t) 31;
+	maskKernel(data, whole, onThreshold, offThreshold, onMasks, offMasks);
+	if(whole < count){
+		tailKernel(data + whole * sampleBytes, count - whole, onThreshold, offThreshold, onMasks + whole / 32, offMasks + whole / 32);
+	}
+	// Looks for the next sample on the other side of the threshold
+	for(size_t w = 0; w * 32 < count; w++){
+		uint32_t mask = on ? offMasks[w] : onMasks[w];
+		while(mask != 0){
+			uint32_t bit = __builtin_ctz(mask);
+			edge(samples + w * 32 + bit);
+			on = !on;
+			uint32_t later = ~((2u << bit) - 1);
+			mask = (on ? offMasks[w] : onMasks[w]) & later;
+		}
+	}
+	samples += count;
+}
+
+size_t OOKFrontEnd::process(const uint8_t *data, size_t bytes){
+	size_t count = bytes / sampleBytes;
+	for(size_t done = 0; done < count; done += OOK_BLOCK_SAMPLES){
+		size_t n = count - done < OOK_BLOCK_SAMPLES ? count - done : OOK_BLOCK_SAMPLES;
+		processBlock(data + done * sampleBytes, n);
+	}
+	return count;
+}
+
+void OOKFrontEnd::finish(){
+	edge(samples);
+	if(pending > 0){
+		sink(pending > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t) pending, context);
+		pending = 0;
+	}
+}
+
+uint64_t OOKFrontEnd::getSamples(){
+	return samples;
+}
+
+uint64_t OOKFrontEnd::getEdges(){
+	return edges;
+}
+
+OOKKernel OOKFrontEnd::getKernel(){
+	return kernel;
+}
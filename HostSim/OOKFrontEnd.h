@@ -0,0 +1,132 @@
+// File: OOKFrontEnd.h
+// Description: Defines a demodulator that turns raw 433.92 MHz captures
+// into the pulse widths that the receiver would have produced.
+
+/**
+ * The OOK Front End reads 8 bit I/Q or magnitude samples, such as
+ * the files written by rtl_sdr or hackrf_transfer, and finds the
+ * edges of the on-off keyed signal. Each block of samples goes
+ * through three stages:
+ *  - the magnitude of every sample (I*I + Q*Q, or the sample itself),
+ *  - a comparison with the on and off thresholds, which yields a
+ *    bit mask of the samples above the on threshold and another of
+ *    those below the off threshold,
+ *  - a walk over the masks that finds each edge with a count of
+ *    trailing zeros, so quiet stretches cost one test per 32 samples.
+ * Pulses shorter than OOK_GLITCH_US are noise spikes or dropouts;
+ * they are merged with the pulses on either side so that they do
+ * not reset the Manchester decoder in the middle of a frame.
+ * The first two stages have scalar, SSE2, and AVX2 versions; the
+ * fastest one the CPU supports is used unless another is chosen.
+ * The thresholds follow the signal: the on threshold is half the
+ * recent peak amplitude, but never less than a margin over the
+ * noise floor, and the off threshold is half of it. The noise
+ * floor is the mean of the samples that are off.
+ * @file OOKFrontEnd.h */
+
+#ifndef OOK_FRONT_END_H
+#define OOK_FRONT_END_H
+
+#include <Arduino.h>
+
+#define OOK_BLOCK_SAMPLES 4096 ///< Defines the number of samples that share a threshold.
+#define OOK_STAT_STRIDE 8 ///< Defines the stride of the samples used to estimate the peak and the noise floor.
+#define OOK_GLITCH_US 30 ///< Defines the width below which a pulse is merged with its neighbors (in microseconds).
+
+/** @enum OOKSampleFormat The formats of the samples. */
+enum OOKSampleFormat{
+	OOK_IQ8_UNSIGNED, ///< Interleaved unsigned 8 bit I and Q centered on 128 (rtl_sdr).
+	OOK_IQ8_SIGNED, ///< Interleaved signed 8 bit I and Q (hackrf_transfer).
+	OOK_MAG8 ///< Unsigned 8 bit magnitude.
+};
+
+/** @enum OOKKernel The implementations of the magnitude and threshold stages. */
+enum OOKKernel{
+	OOK_KERNEL_SCALAR, ///< Plain C++.
+	OOK_KERNEL_SSE2, ///< SSE2, 16 bytes at a time.
+	OOK_KERNEL_AVX2, ///< AVX2, 32 bytes at a time.
+	OOK_KERNEL_AUTO ///< The fastest kernel the CPU supports.
+};
+
+/** The function that receives the width of every pulse.
+ * @param width The width in microseconds.
+ * @param *context The context given to the front end. */
+typedef void (*PulseSink)(uint32_t width, void *context);
+
+/** The magnitude and threshold stages of a block.
+ * @param *in The samples.
+ * @param samples The number of samples.
+ * @param on The threshold that a sample must be above to be on.
+ * @param off The threshold that a sample must be below to be off.
+ * @param *onMasks Receives a bit for every sample above on, 32 samples per word.
+ * @param *offMasks Receives a bit for every sample below off. */
+typedef void (*OOKMaskKernel)(const uint8_t *in, size_t samples, int32_t on, int32_t off, uint32_t *onMasks, uint32_t *offMasks);
+
+/** OOKFrontEnd demodulates a stream of samples into pulse widths.
+ * @class OOKFrontEnd */
+class OOKFrontEnd
+{
+public:
+	/** The constructor.
+	 * @param format The format of the samples.
+	 * @param sampleRate The number of samples per second.
+	 * @param kernel The implementation to use; OOK_KERNEL_AUTO picks the fastest.
+	 * @param sink The function that receives the pulses.
+	 * @param *context Passed to the sink. */
+	OOKFrontEnd(OOKSampleFormat format, uint32_t sampleRate, OOKKernel kernel, PulseSink sink, void *context);
+	/** Fixes the on threshold instead of following the signal.
+	 * @param level The threshold in units of the magnitude (I*I + Q*Q for I/Q samples), or 0 to follow the signal. */
+	void setThreshold(uint32_t level);
+	/** Demodulates the next part of the stream.
+	 * @param *data The samples.
+	 * @param bytes The number of bytes, a whole number of samples.
+	 * @return The number of samples demodulated. */
+	size_t process(const uint8_t *data, size_t bytes);
+	/** Ends the stream, emitting the pulse in progress. */
+	void finish();
+	/** Gets the number of samples demodulated. */
+	uint64_t getSamples();
+	/** Gets the number of edges found. */
+	uint64_t getEdges();
+	/** Gets the kernel in use. */
+	OOKKernel getKernel();
+	/** Gets the number of bytes in a sample of a format. */
+	static uint8_t bytesPerSample(OOKSampleFormat format);
+	/** Checks if the CPU supports a kernel. */
+	static boolean kernelAvailable(OOKKernel kernel);
+	/** Gets the name of a kernel. */
+	static const char *kernelName(OOKKernel kernel);
+private:
+	/** Gets the magnitude of a single sample. */
+	int32_t magnitude(const uint8_t *sample);
+	/** Updates the thresholds from the peak and noise floor of a block. */
+	void updateThresholds(const uint8_t *data, size_t samples);
+	/** Thresholds a block and walks its edges. */
+	void processBlock(const uint8_t *data, size_t samples);
+	/** Records the edge at a sample, emitting the pulse before the previous edge once it is known not to be a glitch. */
+	void edge(uint64_t sample);
+
+	OOKSampleFormat format;
+	uint8_t sampleBytes;
+	uint32_t sampleRate;
+	OOKKernel kernel;
+	OOKMaskKernel maskKernel;
+	OOKMaskKernel tailKernel;
+	PulseSink sink;
+	void *context;
+	uint32_t fixedThreshold;
+	int32_t onThreshold;
+	int32_t offThreshold;
+	int64_t peak;
+	int64_t noise;
+	uint64_t samples;
+	uint64_t edges;
+	uint64_t lastEdgeUs;
+	uint64_t pending; ///< The pulse waiting to see whether the next one is a glitch.
+	boolean merging; ///< Whether the next pulse closes a glitch and joins the pending one.
+	boolean on;
+	uint32_t onMasks[OOK_BLOCK_SAMPLES / 32];
+	uint32_t offMasks[OOK_BLOCK_SAMPLES / 32];
+};
+
+#endif // OOK_FRONT_END_H
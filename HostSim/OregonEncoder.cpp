@@ -0,0 +1,112 @@
+#include <OregonEncoder.h>
+#include <OregonScientific.h>
+#include <OregonScientificSensor.h>
+
+void oregon_set_checksum(uint8_t *nibbles, uint8_t messageSize){
+	uint8_t checksum = 0;
+	for(uint8_t i = DEV_ID_BEGIN; i < messageSize - 3; i++){
+		checksum += nibbles[i];
+	}
+	nibbles[messageSize - 3] = checksum & 0x0F;
+	nibbles[messageSize - 2] = checksum >> 4;
+}
+
+/** The state of the pulse train as bits are appended to it. */
+struct PulseTrain{
+	uint32_t *widths;
+	size_t maxWidths;
+	size_t count;
+	uint16_t jitter;
+	int8_t lastBit;
+};
+
+static void appendPulse(PulseTrain *train, uint32_t width){
+	if(train->count >= train->maxWidths){
+		return;
+	}
+	if(train->jitter > 0){
+		width += (rand() % (2 * train->jitter + 1)) - train->jitter;
+	}
+	train->widths[train->count++] = width;
+}
+
+// The decoder toggles its output on a long pulse and repeats it on two short ones
+static void appendBit(PulseTrain *train, uint8_t bit){
+	if(train->lastBit < 0){
+		// The first pulse after a reset always decodes as a one
+		appendPulse(train, OREGON_SHORT_US);
+	}else if(bit == train->lastBit){
+		appendPulse(train, OREGON_SHORT_US);
+		appendPulse(train, OREGON_SHORT_US);
+	}else{
+		appendPulse(train, OREGON_LONG_US);
+	}
+	train->lastBit = bit;
+}
+
+static void appendDataBit(PulseTrain *train, uint8_t protocol, uint8_t bit){
+	appendBit(train, bit);
+	if(protocol == OSCV_2_1){
+		appendBit(train, !bit);
+	}
+}
+
+static void appendNibble(PulseTrain *train, uint8_t protocol, uint8_t nibble){
+	for(uint8_t i = 0; i < 4; i++){
+		appendDataBit(train, protocol, (nibble >> i) & 0x01);
+	}
+}
+
+size_t oregon_encode(uint8_t protocol, const uint8_t *nibbles, uint8_t count, uint32_t *widths, size_t maxWidths, uint16_t jitter){
+	PulseTrain train = {widths, maxWidths, 0, jitter, -1};
+	uint8_t preamble = protocol == OSCV_2_1 ? 16 : 24;
+	for(uint8_t i = 0; i < preamble; i++){
+		appendDataBit(&train, protocol, 1);
+	}
+	appendNibble(&train, protocol, 0x0A);
+	for(uint8_t i = 0; i < count; i++){
+		appendNibble(&train, protocol, nibbles[i]);
+	}
+	// The parser checks the message on the bit after the last nibble
+	appendNibble(&train, protocol, 0x00);
+	return train.count;
+}
+
+void oregon_thgr122nx_message(uint8_t *nibbles, uint8_t channel, int16_t tenths, uint8_t humidity, boolean batteryLow){
+	id_type id;
+	id.value = THGR122NX;
+	memset(nibbles, 0, 18);
+	for(uint8_t i = 0; i < 4; i++){
+		nibbles[DEV_ID_END - i] = id.array[i];
+	}
+	nibbles[CHANNEL_NIBBLE] = channel;
+	nibbles[ROLLING_CODE_BEGIN] = 0x0B;
+	nibbles[ROLLING_CODE_END] = 0x03;
+	nibbles[FLAGS] = batteryLow ? 0x04 : 0x00;
+	uint16_t magnitude = tenths < 0 ? -tenths : tenths;
+	nibbles[8] = magnitude % 10;
+	nibbles[9] = (magnitude / 10) % 10;
+	nibbles[10] = (magnitude / 100) % 10;
+	nibbles[11] = tenths < 0 ? 0x08 : 0x00;
+	nibbles[12] = humidity % 10;
+	nibbles[13] = (humidity / 10) % 10;
+	oregon_set_checksum(nibbles, OregonScientificSensor::THGR122NX_FORMAT[1]);
+}
+
+void oregon_thwr800_message(uint8_t *nibbles, uint8_t channel, int16_t tenths){
+	id_type id;
+	id.value = THWR800;
+	memset(nibbles, 0, 15);
+	for(uint8_t i = 0; i < 4; i++){
+		nibbles[DEV_ID_END - i] = id.array[i];
+	}
+	nibbles[CHANNEL_NIBBLE] = channel;
+	nibbles[ROLLING_CODE_BEGIN] = 0x05;
+	nibbles[ROLLING_CODE_END] = 0x0C;
+	uint16_t magnitude = tenths < 0 ? -tenths : tenths;
+	nibbles[8] = magnitude % 10;
+	nibbles[9] = (magnitude / 10) % 10;
+	nibbles[10] = (magnitude / 100) % 10;
+	nibbles[11] = tenths < 0 ? 0x08 : 0x00;
+	oregon_set_checksum(nibbles, OregonScientificSensor::THWR800_FORMAT[1]);
+}
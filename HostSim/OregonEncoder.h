@@ -0,0 +1,53 @@
+// File: OregonEncoder.h
+// Description: Defines the functions that turn Oregon Scientific messages
+// into the pulse widths the receiver produces so that the host simulation
+// can replay sensors without recorded traces.
+
+/**
+ * The Oregon Encoder builds the Manchester pulse train of a
+ * message the way ManchesterDecoder and OregonScientific expect
+ * it: a preamble of ones, the sync nibble 0xA, the nibbles of the
+ * message least significant bit first, and a postamble. Version
+ * 2.1 messages send every bit followed by its complement.
+ * @file OregonEncoder.h */
+
+#ifndef OREGON_ENCODER_H
+#define OREGON_ENCODER_H
+
+#include <Arduino.h>
+
+#define OREGON_SHORT_US 488 ///< Defines the width of a short pulse, half a bit at 1024 Hz.
+#define OREGON_LONG_US 976 ///< Defines the width of a long pulse, a whole bit at 1024 Hz.
+#define OREGON_MAX_PULSES 512 ///< Defines the most pulses a single message can need.
+
+/** Writes the checksum that OregonScientific::validate expects, the sum
+ * of the nibbles before it, into nibbles messageSize-3 and messageSize-2.
+ * @param *nibbles The message.
+ * @param messageSize The size of the message as given by the sensor format. */
+void oregon_set_checksum(uint8_t *nibbles, uint8_t messageSize);
+
+/** Encodes a message as pulse widths.
+ * @param protocol OSCV_2_1 or OSCV_3.
+ * @param *nibbles The message, including the checksum.
+ * @param count The number of nibbles in the message.
+ * @param *widths The buffer that receives the pulse widths in microseconds.
+ * @param maxWidths The size of the buffer, OREGON_MAX_PULSES is always enough.
+ * @param jitter The largest random error added to each pulse in microseconds.
+ * @return The number of pulses. */
+size_t oregon_encode(uint8_t protocol, const uint8_t *nibbles, uint8_t count, uint32_t *widths, size_t maxWidths, uint16_t jitter);
+
+/** Fills in a THGR122NX message.
+ * @param *nibbles The buffer of at least 18 nibbles that receives the message.
+ * @param channel The channel nibble (V2_CHANNEL_1 etc.).
+ * @param tenths The temperature in tenths of a degree.
+ * @param humidity The humidity in percent.
+ * @param batteryLow Whether the low battery flag is set. */
+void oregon_thgr122nx_message(uint8_t *nibbles, uint8_t channel, int16_t tenths, uint8_t humidity, boolean batteryLow);
+
+/** Fills in a THWR800 message.
+ * @param *nibbles The buffer of at least 15 nibbles that receives the message.
+ * @param channel The channel nibble (V3_CHANNEL_1 etc.).
+ * @param tenths The temperature in tenths of a degree. */
+void oregon_thwr800_message(uint8_t *nibbles, uint8_t channel, int16_t tenths);
+
+#endif // OREGON_ENCODER_H
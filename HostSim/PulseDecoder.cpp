@@ -0,0 +1,170 @@
+#include <PulseDecoder.h>
+#include <OregonEncoder.h>
+
+PulseDecoder::PulseDecoder(FrameHandler handler, void *context) : decoder(false){
+	PulseDecoder::handler = handler;
+	PulseDecoder::context = context;
+	now = 0;
+	burstStart = 0;
+	pulses = 0;
+	frames = 0;
+	timingSum = 0;
+	timingPulses = 0;
+	repair = NULL;
+	// The sensors of the sketch on every channel
+	const uint8_t v2Channels[3] = {V2_CHANNEL_1, V2_CHANNEL_2, V2_CHANNEL_3};
+	const uint8_t v3Channels[3] = {V3_CHANNEL_1, V3_CHANNEL_2, V3_CHANNEL_3};
+	for(uint8_t i = 0; i < 3; i++){
+		sensors[i] = new OregonScientificSensor(THGR122NX, v2Channels[i], 7, OregonScientificSensor::THGR122NX_FORMAT, OregonScientificSensor::THGR122NX_TITLES);
+		v2.addSensor(sensors[i]);
+		sensors[i + 3] = new OregonScientificSensor(THWR800, v3Channels[i], 6, OregonScientificSensor::THWR800_FORMAT, OregonScientificSensor::THWR800_TITLES);
+		v3.addSensor(sensors[i + 3]);
+	}
+}
+
+PulseDecoder::~PulseDecoder(){
+	for(uint8_t i = 0; i < PULSE_DECODER_SENSORS; i++){
+		delete sensors[i];
+	}
+	delete repair;
+}
+
+void PulseDecoder::enableRepair(uint32_t window, uint8_t maxDiffs){
+	delete repair;
+	repair = new FrameRepair(window, maxDiffs);
+}
+
+uint32_t PulseDecoder::getRepaired(){
+	return repair != NULL ? repair->getRepaired() : 0;
+}
+
+uint32_t PulseDecoder::getRefused(){
+	return repair != NULL ? repair->getRefused() : 0;
+}
+
+void PulseDecoder::addPulse(uint32_t width){
+	now += width;
+	pulses++;
+	if(width > 0xFFFF){
+		width = 0xFFFF;
+	}
+	if(!isGap(width)){
+		// A window over the last pulses, which a frame that ends is timed by
+		uint16_t nominal = width < SHORT_PULSE_LIMIT ? OREGON_SHORT_US : OREGON_LONG_US;
+		uint16_t error = width > nominal ? width - nominal : nominal - width;
+		uint8_t slot = timingPulses % PULSE_DECODER_JITTER_PULSES;
+		if(timingPulses >= PULSE_DECODER_JITTER_PULSES){
+			timingSum -= timingErrors[slot];
+		}
+		timingErrors[slot] = error;
+		timingSum += error;
+		timingPulses++;
+	}
+	decoder.decode(width);
+	while(decoder.hasNextPulse()){
+		parse(decoder.getNextPulse());
+	}
+	// A gap resets the decoder, after a repaired frame has taken the time of its burst, and the next edge starts a burst
+	if(isGap(width)){
+		burstStart = now;
+		timingSum = 0;
+		timingPulses = 0;
+	}
+}
+
+// The same order as processMessages in the sketch
+void PulseDecoder::parse(uint8_t data){
+	if(data == RESET){
+		// Only version 2.1 frames have a repeat to be repaired from
+		if(repair != NULL){
+			repairFrame(OSCV_2_1, &v2);
+		}
+	}else if(v3.parseOregonScientificV3(data)){
+		emit(OSCV_3, &v3, false);
+	}else if(v2.parseOregonScientificV2(data)){
+		emit(OSCV_2_1, &v2, false);
+	}else{
+		return;
+	}
+	v3.reset();
+	v2.reset();
+}
+
+void PulseDecoder::repairFrame(uint8_t protocol, OregonScientific *parser){
+	// The repair window is in milliseconds like millis() in the sketch
+	if(parser->hasFailedMessage() && repair->repair(parser->getCurrentSensor(), parser->getMessage(), (uint32_t) (now / 1000))){
+		emit(protocol, parser, true);
+	}
+}
+
+void PulseDecoder::emit(uint8_t protocol, OregonScientific *parser, boolean repaired){
+	OregonScientificSensor *sensor = parser->getCurrentSensor();
+	DecodedFrame frame;
+	frame.time_us = burstStart;
+	frame.protocol = protocol;
+	frame.sensorId = sensor->getSensorID();
+	frame.channel = sensor->getSensorChannel();
+	frame.size = sensor->getMessageSize();
+	if(frame.size > PULSE_DECODER_MAX_NIBBLES){
+		frame.size = PULSE_DECODER_MAX_NIBBLES;
+	}
+	memcpy(frame.nibbles, parser->getMessage(), frame.size);
+	frame.repaired = repaired;
+	uint32_t timed = timingPulses < PULSE_DECODER_JITTER_PULSES ? timingPulses : PULSE_DECODER_JITTER_PULSES;
+	frame.jitter = timed > 0 ? timingSum / timed : 0;
+	frames++;
+	handler(frame, context);
+}
+
+void PulseDecoder::restart(uint64_t us){
+	// A gap resets the decoder, which is not the state it is constructed in
+	decoder.reset();
+	v3.reset();
+	v2.reset();
+	now = us;
+	burstStart = us;
+	timingSum = 0;
+	timingPulses = 0;
+}
+
+boolean PulseDecoder::isGap(uint32_t width){
+	return width < MIN_PULSE_WIDTH || width >= MAX_PULSE_WIDTH;
+}
+
+uint64_t PulseDecoder::getTime(){
+	return now;
+}
+
+void PulseDecoder::setTime(uint64_t us){
+	now = us;
+}
+
+uint32_t PulseDecoder::getFrames(){
+	return frames;
+}
+
+uint64_t PulseDecoder::getPulses(){
+	return pulses;
+}
+
+const uint8_t *PulseDecoder::formatOf(uint32_t sensorId){
+	switch(sensorId){
+	case THGR122NX:
+		return OregonScientificSensor::THGR122NX_FORMAT;
+	case THWR800:
+		return OregonScientificSensor::THWR800_FORMAT;
+	}
+	return NULL;
+}
+
+int PulseDecoder::formatFrame(const DecodedFrame &frame, char *buffer, size_t size){
+	static const char hex[] = "0123456789ABCDEF";
+	char nibbles[PULSE_DECODER_MAX_NIBBLES + 1];
+	for(uint8_t i = 0; i < frame.size; i++){
+		nibbles[i] = hex[frame.nibbles[i] & 0x0F];
+	}
+	nibbles[frame.size] = '\0';
+	return snprintf(buffer, size, "%llu.%06llu %s %08lX %u %s",
+		(unsigned long long) (frame.time_us / 1000000), (unsigned long long) (frame.time_us % 1000000),
+		frame.protocol == OSCV_3 ? "V3" : "V2.1", (unsigned long) frame.sensorId, frame.channel, nibbles);
+}
@@ -0,0 +1,121 @@
+// File: PulseDecoder.h
+// Description: Defines the decoding pipeline of the sketch, a Manchester
+// decoder feeding the version 2.1 and 3.0 parsers, for host tools that
+// decode pulses that were recorded rather than caught by the ISR.
+
+/**
+ * The Pulse Decoder owns its own decoder, parsers, and sensors so
+ * that several can run side by side, one per thread or receiver.
+ * Pulses are fed in order with their widths, and every frame that
+ * passes its checksum is handed to a callback along with the time
+ * of the first edge of its burst and the timing error of its last
+ * pulses, which tells apart the copies of a frame that several
+ * receivers heard.
+ * @file PulseDecoder.h */
+
+#ifndef PULSE_DECODER_H
+#define PULSE_DECODER_H
+
+#include <Arduino.h>
+#include <ManchesterDecoder.h>
+#include <OregonScientific.h>
+#include <OregonScientificSensor.h>
+#include <FrameRepair.h>
+
+#define PULSE_DECODER_MAX_NIBBLES 32 ///< Defines the most nibbles kept from a frame.
+#define PULSE_DECODER_SENSORS 6 ///< Defines the number of sensors that are listened for.
+#define PULSE_DECODER_JITTER_PULSES 64 ///< Defines the number of pulses before the end of a frame whose timing error is averaged, fewer than any frame has.
+
+/** A frame that passed its checksum.
+ * @struct DecodedFrame */
+struct DecodedFrame{
+	uint64_t time_us; ///< The time of the first edge of the burst that carried the frame.
+	uint8_t protocol; ///< OSCV_2_1 or OSCV_3.
+	uint32_t sensorId; ///< The device id of the sensor.
+	uint8_t channel; ///< The channel of the sensor.
+	uint8_t size; ///< The number of nibbles in the frame.
+	uint8_t nibbles[PULSE_DECODER_MAX_NIBBLES]; ///< The nibbles of the frame.
+	boolean repaired; ///< Whether the frame failed its checksum and was repaired from its repeat.
+	uint16_t jitter; ///< The mean distance of the last pulses of the frame from a short or long pulse in microseconds, lower for a cleaner signal.
+};
+
+/** The function that receives decoded frames.
+ * @param &frame The frame.
+ * @param *context The context given to the decoder. */
+typedef void (*FrameHandler)(const DecodedFrame &frame, void *context);
+
+/** PulseDecoder runs pulse widths through the decoder and parsers of the sketch.
+ * @class PulseDecoder */
+class PulseDecoder
+{
+public:
+	/** The constructor.
+	 * @param handler The function called with every frame.
+	 * @param *context Passed to the handler. */
+	PulseDecoder(FrameHandler handler, void *context);
+	/** The destructor. */
+	~PulseDecoder();
+	/** Decodes the next pulse.
+	 * @param width The width of the pulse in microseconds; widths that do not fit in 16 bits are gaps. */
+	void addPulse(uint32_t width);
+	/** Repairs frames that fail their checksum from their repeats, as the sketch does.
+	 * @param window The longest time in milliseconds between a frame and its repeat.
+	 * @param maxDiffs The most nibbles in which the two copies may differ. */
+	void enableRepair(uint32_t window, uint8_t maxDiffs);
+	/** Gets the number of frames that were repaired. */
+	uint32_t getRepaired();
+	/** Gets the number of repairs that were refused. */
+	uint32_t getRefused();
+	/** Puts the decoder and parsers in the state a gap leaves them in, so that
+	 * decoding can start right after a gap that another decoder has seen.
+	 * @param us The time of the edge that ended the gap in microseconds. */
+	void restart(uint64_t us);
+	/** Gets the time of the last edge, the sum of every pulse so far. */
+	uint64_t getTime();
+	/** Sets the time of the last edge, as when a stream starts at a known time.
+	 * @param us The time in microseconds. */
+	void setTime(uint64_t us);
+	/** Gets the number of frames that passed their checksum. */
+	uint32_t getFrames();
+	/** Gets the number of pulses decoded. */
+	uint64_t getPulses();
+	/** Formats a frame as a line of text: the time in seconds, the protocol, the device id, the channel, and the nibbles.
+	 * @param &frame The frame.
+	 * @param *buffer The buffer that receives the line.
+	 * @param size The size of the buffer.
+	 * @return The length of the line. */
+	static int formatFrame(const DecodedFrame &frame, char *buffer, size_t size);
+	/** Checks whether a pulse is a gap, which the decoder answers with RESET.
+	 * No frame spans a gap, so a trace can be split after one.
+	 * @param width The width of the pulse in microseconds.
+	 * @return True if the pulse is a gap. */
+	static boolean isGap(uint32_t width);
+	/** Finds the message format of a sensor.
+	 * @param sensorId The device id.
+	 * @return The format or NULL if the sensor is not known. */
+	static const uint8_t *formatOf(uint32_t sensorId);
+private:
+	/** Passes the output of the decoder to the parsers. */
+	void parse(uint8_t data);
+	/** Hands a parsed frame to the handler. */
+	void emit(uint8_t protocol, OregonScientific *parser, boolean repaired);
+	/** Hands a failed frame to the frame repair, and the frame to the handler if it was repaired. */
+	void repairFrame(uint8_t protocol, OregonScientific *parser);
+
+	ManchesterDecoder decoder;
+	OregonScientific v2;
+	OregonScientific v3;
+	OregonScientificSensor *sensors[PULSE_DECODER_SENSORS];
+	FrameRepair *repair;
+	FrameHandler handler;
+	void *context;
+	uint64_t now;
+	uint64_t burstStart;
+	uint64_t pulses;
+	uint32_t frames;
+	uint16_t timingErrors[PULSE_DECODER_JITTER_PULSES];
+	uint32_t timingSum;
+	uint32_t timingPulses; ///< The pulses since the last gap.
+};
+
+#endif // PULSE_DECODER_H
@@ -0,0 +1,238 @@
+#include <RFM69Mock.h>
+#include <RFM69OOK.h>
+#include <HostSim.h>
+#include <SPI.h>
+#include <algorithm>
+#include <vector>
+
+/** A level of the air that holds from a time on. */
+struct RfLevel{
+	uint64_t at;
+	double dBm;
+};
+
+/** An access to a register. */
+struct RegisterAccess{
+	boolean write;
+	uint8_t address;
+	uint8_t value;
+};
+
+static uint8_t registers[0x80];
+static std::vector<RfLevel> air;
+static std::vector<RegisterAccess> accesses;
+static uint8_t interrupt_num;
+static uint8_t address;
+static boolean writing;
+static boolean receiving = false;
+static uint64_t edges = 0;
+static uint32_t rssi_reads = 0;
+
+// The decrement of the peak threshold and the chips between decrements
+static const double PEAK_STEPS_DB[8] = {0.5, 1.0, 1.5, 2.0, 3.0, 4.0, 5.0, 6.0};
+static const double PEAK_DEC_CHIPS[8] = {1, 2, 4, 8, 0.5, 0.25, 0.125, 0.0625};
+
+static double levelAt(uint64_t at){
+	if(air.empty() || at < air[0].at){
+		return RFM69_MOCK_SENSITIVITY_DBM;
+	}
+	RfLevel key = {at, 0};
+	std::vector<RfLevel>::iterator it = std::upper_bound(air.begin(), air.end(), key,
+		[](const RfLevel &a, const RfLevel &b){ return a.at < b.at; });
+	return (it - 1)->dBm;
+}
+
+static void scheduleEdge(uint64_t at){
+	hostsim_schedule_edge(interrupt_num, at);
+	edges++;
+}
+
+// Slices the air from now on as configured and schedules the edges of DIO2
+static void startReceiving(){
+	receiving = true;
+	if(registers[RFM69_REG_DATAMODUL] != RFM69_CONTINUOUS_OOK){
+		// DIO2 only carries the data in continuous mode
+		return;
+	}
+	uint8_t peak = registers[RFM69_REG_OOKPEAK];
+	boolean peakMode = (peak >> 6) == 0x01;
+	double floor = RFM69_MOCK_SENSITIVITY_DBM + registers[RFM69_REG_OOKFIX];
+	double gate = -registers[RFM69_REG_RSSITHRESH] / 2.0;
+	double chipUs = ((registers[RFM69_REG_BITRATEMSB] << 8) | registers[RFM69_REG_BITRATELSB]) / (RFM69_FXOSC / 1e6);
+	double decayPerUs = PEAK_STEPS_DB[(peak >> 3) & 0x07] / (PEAK_DEC_CHIPS[peak & 0x07] * chipUs);
+	double threshold = floor;
+	boolean out = false;
+	uint64_t now = hostsim_time_us();
+	uint64_t last = now;
+	for(size_t i = 0; i < air.size(); i++){
+		uint64_t start = std::max(air[i].at, now);
+		uint64_t end = i + 1 < air.size() ? air[i + 1].at : UINT64_MAX;
+		if(end <= now){
+			continue;
+		}
+		double level = air[i].dBm;
+		if(peakMode){
+			threshold = std::max(floor, threshold - decayPerUs * (start - last));
+			threshold = std::max(threshold, level - 6.0);
+		}
+		boolean high = level >= gate && level > threshold;
+		if(high != out){
+			scheduleEdge(start);
+			out = high;
+		}
+		if(!peakMode || end == UINT64_MAX){
+			last = start;
+			continue;
+		}
+		// The threshold may decay below a level that holds for long enough
+		if(!out && level >= gate && level > floor){
+			double crossing = start + (threshold - level) / decayPerUs;
+			if(crossing < end){
+				scheduleEdge((uint64_t) crossing + 1);
+				out = true;
+			}
+		}
+		threshold = std::max(floor, threshold - decayPerUs * (end - start));
+		if(out){
+			threshold = std::max(threshold, level - 6.0);
+		}
+		last = end;
+	}
+}
+
+static uint8_t readRegister(uint8_t addr){
+	uint8_t value = registers[addr];
+	if(addr == RFM69_REG_RSSIVALUE){
+		double rssi = levelAt(hostsim_time_us());
+		value = rssi >= 0 ? 0 : (rssi <= -127.5 ? 0xFF : (uint8_t) (-2 * rssi));
+		rssi_reads++;
+	}
+	RegisterAccess access = {false, addr, value};
+	accesses.push_back(access);
+	return value;
+}
+
+static void writeRegister(uint8_t addr, uint8_t value){
+	RegisterAccess access = {true, addr, value};
+	accesses.push_back(access);
+	if(addr == RFM69_REG_VERSION || addr == RFM69_REG_RSSIVALUE || addr == RFM69_REG_IRQFLAGS1){
+		return;
+	}
+	registers[addr] = value;
+	if(addr == RFM69_REG_OPMODE && (value & RFM69_MODE_MASK) == RFM69_MODE_RX && !receiving){
+		startReceiving();
+	}
+}
+
+static uint8_t transfer(uint8_t data, boolean first){
+	if(first){
+		address = data & 0x7F;
+		writing = (data & 0x80) != 0;
+		return 0;
+	}
+	uint8_t value = 0;
+	if(writing){
+		writeRegister(address, data);
+	}else{
+		value = readRegister(address);
+	}
+	address = (address + 1) & 0x7F;
+	return value;
+}
+
+void rfm69_mock_attach(uint8_t csPin, uint8_t interruptNum){
+	memset(registers, 0, sizeof(registers));
+	registers[RFM69_REG_OPMODE] = RFM69_MODE_STANDBY;
+	registers[RFM69_REG_BITRATEMSB] = 0x1A;
+	registers[RFM69_REG_BITRATELSB] = 0x0B;
+	registers[RFM69_REG_FRFMSB] = 0xE4;
+	registers[RFM69_REG_FRFMID] = 0xC0;
+	registers[RFM69_REG_VERSION] = RFM69_VERSION;
+	registers[RFM69_REG_LNA] = 0x08;
+	registers[RFM69_REG_RXBW] = 0x86;
+	registers[RFM69_REG_OOKPEAK] = 0x40;
+	registers[RFM69_REG_OOKFIX] = 0x06;
+	registers[RFM69_REG_RSSIVALUE] = 0xFF;
+	registers[RFM69_REG_IRQFLAGS1] = RFM69_IRQ_MODEREADY;
+	registers[RFM69_REG_RSSITHRESH] = 0xE4;
+	interrupt_num = interruptNum;
+	hostsim_spi_attach(csPin, transfer);
+}
+
+void rfm69_mock_rf(uint64_t at, double dBm){
+	RfLevel level = {at, dBm};
+	air.push_back(level);
+}
+
+const char *rfm69_mock_check_config(){
+	if(accesses.empty()){
+		return "the RFM69 was never accessed";
+	}
+	if(accesses[0].write || accesses[0].address != RFM69_REG_VERSION){
+		return "the version was not read first";
+	}
+	boolean standby = false;
+	boolean written[0x80] = {false};
+	uint8_t values[0x80];
+	memcpy(values, registers, sizeof(values));
+	size_t i;
+	for(i = 0; i < accesses.size(); i++){
+		const RegisterAccess &access = accesses[i];
+		if(!access.write){
+			continue;
+		}
+		if(access.address == RFM69_REG_OPMODE){
+			uint8_t mode = access.value & RFM69_MODE_MASK;
+			if(mode == RFM69_MODE_STANDBY){
+				standby = true;
+				continue;
+			}
+			if(mode == RFM69_MODE_RX){
+				break;
+			}
+			return "the RFM69 was put in a mode other than standby or receive";
+		}
+		if(!standby){
+			return "a register was configured before entering standby";
+		}
+		written[access.address] = true;
+		values[access.address] = access.value;
+	}
+	if(i == accesses.size()){
+		return "receive was never entered";
+	}
+	for(i++; i < accesses.size(); i++){
+		if(accesses[i].write){
+			return "a register was written after entering receive";
+		}
+	}
+	if(!written[RFM69_REG_DATAMODUL] || values[RFM69_REG_DATAMODUL] != RFM69_CONTINUOUS_OOK){
+		return "the data mode is not continuous OOK without bit synchronizer";
+	}
+	if(!written[RFM69_REG_FRFMSB] || !written[RFM69_REG_FRFMID] || !written[RFM69_REG_FRFLSB]){
+		return "the carrier frequency was not set";
+	}
+	uint32_t frf = ((uint32_t) values[RFM69_REG_FRFMSB] << 16) | (values[RFM69_REG_FRFMID] << 8) | values[RFM69_REG_FRFLSB];
+	double hz = frf * (RFM69_FXOSC / 524288.0);
+	if(hz < 433920000 - 61.1 || hz > 433920000 + 61.1){
+		return "the carrier frequency is not 433.92 MHz";
+	}
+	if(!written[RFM69_REG_OOKPEAK] || (values[RFM69_REG_OOKPEAK] >> 6) > 0x01){
+		return "the OOK threshold is not set to peak or fixed";
+	}
+	if(!written[RFM69_REG_OOKFIX]){
+		return "the OOK floor was not set";
+	}
+	if(!written[RFM69_REG_RSSITHRESH]){
+		return "the RSSI threshold was not set";
+	}
+	return NULL;
+}
+
+uint64_t rfm69_mock_edges(){
+	return edges;
+}
+
+uint32_t rfm69_mock_rssi_reads(){
+	return rssi_reads;
+}
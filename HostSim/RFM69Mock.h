@@ -0,0 +1,51 @@
+// File: RFM69Mock.h
+// Description: Defines a register-level model of the RFM69 on the host SPI
+// bus that checks how it is configured and turns a scheduled RF level into
+// the edges of its DIO2 data output.
+
+/**
+ * The RFM69 Mock answers SPI transfers the way the module does: the
+ * first byte holds the address, with the top bit set for a write, and
+ * the address advances with every byte that follows. It starts with
+ * the reset values of the registers that the driver touches and logs
+ * every access, so the configuration sequence can be checked once
+ * setup has run.
+ *
+ * The air is scheduled as a level in dBm that holds from one time to
+ * the next: the carrier of a sensor while it is on, the noise of the
+ * band otherwise. When the mock enters continuous OOK receive it
+ * slices that level the way the module is configured and schedules
+ * an edge on the interrupt pin for every change of DIO2. The slicer
+ * is modelled as follows, which is close to but not exactly the
+ * module: in peak mode the threshold jumps to 6 dB below any stronger
+ * level and decays by OokPeakTheshStep every OokPeakThreshDec chips,
+ * never below a floor OokFixedThresh dB above the sensitivity of the
+ * receiver; in fixed mode it stays at the floor. The output is also
+ * held low while the level is below the RSSI threshold. RegRssiValue
+ * reads the level at the current time of the virtual clock.
+ * @file RFM69Mock.h */
+
+#ifndef RFM69_MOCK_H
+#define RFM69_MOCK_H
+
+#include <Arduino.h>
+
+#define RFM69_MOCK_SENSITIVITY_DBM -114.0 ///< Defines the level the floor of the slicer is measured from (in dBm).
+
+/** Attaches the mock to the SPI bus.
+ * @param csPin The pin of its chip select.
+ * @param interruptNum The interrupt whose pin DIO2 drives. */
+void rfm69_mock_attach(uint8_t csPin, uint8_t interruptNum);
+/** Sets the level of the air from a time on. Levels must be given in order of time.
+ * @param at The time in microseconds.
+ * @param dBm The level. */
+void rfm69_mock_rf(uint64_t at, double dBm);
+/** Checks the configuration sequence that the driver wrote.
+ * @return NULL if it was right, or what was wrong. */
+const char *rfm69_mock_check_config();
+/** Gets the number of edges that DIO2 put out. */
+uint64_t rfm69_mock_edges();
+/** Gets the number of RSSI readings. */
+uint32_t rfm69_mock_rssi_reads();
+
+#endif // RFM69_MOCK_H
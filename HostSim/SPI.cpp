@@ -0,0 +1,30 @@
+#include <SPI.h>
+#include <HostSim.h>
+
+SPIClass SPI;
+
+static uint8_t cs_pin;
+static uint8_t (*device)(uint8_t data, boolean first) = NULL;
+static boolean first = false;
+
+// Notes each time the device is selected so its next byte is the first
+static void pinWritten(uint8_t pin, uint8_t level){
+	if(pin == cs_pin && level == LOW){
+		first = true;
+	}
+}
+
+void hostsim_spi_attach(uint8_t csPin, uint8_t (*transfer)(uint8_t data, boolean first)){
+	cs_pin = csPin;
+	device = transfer;
+	hostsim_on_pin_write(pinWritten);
+}
+
+uint8_t SPIClass::transfer(uint8_t data){
+	if(device == NULL || digitalRead(cs_pin) != LOW){
+		return 0xFF;
+	}
+	boolean isFirst = first;
+	first = false;
+	return device(data, isFirst);
+}
@@ -0,0 +1,51 @@
+// File: SPI.h
+// Description: The SPI bus of the host simulation, which passes every byte
+// to the simulated device whose chip select is low.
+
+/**
+ * The host SPI bus. A simulated device attaches to the pin of its
+ * chip select and is told when it is selected, so it can tell the
+ * first byte of a transfer, usually an address, from those that
+ * follow. With no device selected every byte reads back as 0xFF,
+ * as it would from a bus with nothing on it.
+ * @file SPI.h */
+
+#ifndef HOSTSIM_SPI_H
+#define HOSTSIM_SPI_H
+
+#include <Arduino.h>
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+/** The speed, bit order and mode of a transaction, which the host ignores. */
+class SPISettings
+{
+public:
+	SPISettings(){}
+	SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode){ (void) clock; (void) bitOrder; (void) dataMode; }
+};
+
+/** The SPI bus. */
+class SPIClass
+{
+public:
+	void begin(){}
+	void end(){}
+	void usingInterrupt(uint8_t interruptNumber){ (void) interruptNumber; }
+	void beginTransaction(SPISettings settings){ (void) settings; }
+	void endTransaction(){}
+	/** Exchanges a byte with the selected device. */
+	uint8_t transfer(uint8_t data);
+};
+
+extern SPIClass SPI;
+
+/** Attaches a simulated device to the bus.
+ * @param csPin The pin of its chip select, which selects it when low.
+ * @param transfer Exchanges a byte; first is true for the first byte since it was selected. */
+void hostsim_spi_attach(uint8_t csPin, uint8_t (*transfer)(uint8_t data, boolean first));
+
+#endif // HOSTSIM_SPI_H
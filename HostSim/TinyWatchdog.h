@@ -0,0 +1,43 @@
+// File: TinyWatchdog.h
+// Description: The external watchdog of the WildFire, which counts pets in
+// the host simulation and ends it when a reset is forced.
+
+#ifndef HOSTSIM_TINY_WATCHDOG_H
+#define HOSTSIM_TINY_WATCHDOG_H
+
+#include <Arduino.h>
+#include <HostSim.h>
+
+/** The watchdog timer. */
+class TinyWatchdog
+{
+public:
+	TinyWatchdog(){ pets = 0; lastPet = 0; longestGap = 0; maxInterval = 0; }
+	void begin(uint32_t minPetInterval, uint32_t maxPetInterval){ (void) minPetInterval; maxInterval = maxPetInterval; }
+	void pet(){
+		pets++;
+		noteGap();
+		lastPet = hostsim_time_us() / 1000;
+	}
+	/** Records the time since the last pet, which is also done when the simulation ends. */
+	void noteGap(){
+		uint64_t gap = hostsim_time_us() / 1000 - lastPet;
+		if(gap > longestGap){
+			longestGap = gap;
+		}
+	}
+	/** Checks whether the device would have been reset because a pet came too late. */
+	boolean wouldHaveBitten(){ return maxInterval > 0 && longestGap > maxInterval; }
+	/** A forced reset ends the simulation. */
+	void force_reset(){ hostsim_end(); }
+	/** The number of times the watchdog was petted. */
+	unsigned long pets;
+	/** The time of the last pet in milliseconds. */
+	uint64_t lastPet;
+	/** The longest time between two pets in milliseconds. */
+	uint64_t longestGap;
+	/** The longest time allowed between two pets in milliseconds. */
+	uint32_t maxInterval;
+};
+
+#endif // HOSTSIM_TINY_WATCHDOG_H
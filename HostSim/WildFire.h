@@ -0,0 +1,18 @@
+// File: WildFire.h
+// Description: The board support of the WildFire, which has nothing to
+// initialize in the host simulation.
+
+#ifndef HOSTSIM_WILDFIRE_H
+#define HOSTSIM_WILDFIRE_H
+
+#include <Arduino.h>
+
+/** The WildFire board. */
+class WildFire
+{
+public:
+	/** Initializes the board. */
+	void begin(){}
+};
+
+#endif // HOSTSIM_WILDFIRE_H
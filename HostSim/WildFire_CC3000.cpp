@@ -0,0 +1,181 @@
+#include <WildFire_CC3000.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <errno.h>
+
+WildFire_CC3000_Client::WildFire_CC3000_Client(){
+	socket = -1;
+}
+
+WildFire_CC3000_Client::WildFire_CC3000_Client(int socket){
+	WildFire_CC3000_Client::socket = socket;
+}
+
+void WildFire_CC3000_Client::waitForData(){
+	static int wait_ms = -1;
+	if(wait_ms < 0){
+		const char *env = getenv("HOSTSIM_NET_WAIT_MS");
+		wait_ms = env != NULL ? atoi(env) : 1;
+	}
+	struct pollfd pfd = {socket, POLLIN, 0};
+	poll(&pfd, 1, wait_ms);
+}
+
+int WildFire_CC3000_Client::available(){
+	if(socket < 0){
+		return 0;
+	}
+	int n = 0;
+	if(ioctl(socket, FIONREAD, &n) != 0){
+		return 0;
+	}
+	if(n == 0){
+		waitForData();
+		ioctl(socket, FIONREAD, &n);
+	}
+	return n;
+}
+
+boolean WildFire_CC3000_Client::connected(){
+	if(socket < 0){
+		return false;
+	}
+	char c;
+	ssize_t n = recv(socket, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+	// Zero means the server closed the connection and everything was read
+	return n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+}
+
+int WildFire_CC3000_Client::read(){
+	if(available() <= 0){
+		return -1;
+	}
+	unsigned char c;
+	return recv(socket, &c, 1, 0) == 1 ? c : -1;
+}
+
+int8_t WildFire_CC3000_Client::close(){
+	if(socket >= 0){
+		::close(socket);
+		socket = -1;
+	}
+	return 0;
+}
+
+size_t WildFire_CC3000_Client::write(uint8_t c){
+	return write(&c, 1);
+}
+
+size_t WildFire_CC3000_Client::write(const void *buffer, uint16_t len, uint32_t flags){
+	(void) flags;
+	if(socket < 0){
+		return 0;
+	}
+	size_t sent = 0;
+	while(sent < len){
+		ssize_t n = send(socket, (const char *) buffer + sent, len - sent, MSG_NOSIGNAL);
+		if(n <= 0){
+			break;
+		}
+		sent += n;
+	}
+	return sent;
+}
+
+size_t WildFire_CC3000_Client::fastrprint(const char *str){
+	return write(str, strlen(str));
+}
+
+size_t WildFire_CC3000_Client::fastrprint(const __FlashStringHelper *str){
+	return fastrprint(reinterpret_cast<const char *>(str));
+}
+
+size_t WildFire_CC3000_Client::fastrprintln(const char *str){
+	return fastrprint(str) + fastrprint("\r\n");
+}
+
+size_t WildFire_CC3000_Client::fastrprintln(const __FlashStringHelper *str){
+	return fastrprintln(reinterpret_cast<const char *>(str));
+}
+
+boolean WildFire_CC3000::begin(uint8_t patchReq, boolean useSmartConfigData, const char *deviceName){
+	(void) patchReq;
+	(void) useSmartConfigData;
+	(void) deviceName;
+	return true;
+}
+
+boolean WildFire_CC3000::startSmartConfig(const char *deviceName, const char *aesKey){
+	(void) deviceName;
+	(void) aesKey;
+	return true;
+}
+
+boolean WildFire_CC3000::checkDHCP(){
+	return true;
+}
+
+boolean WildFire_CC3000::checkConnected(){
+	return true;
+}
+
+boolean WildFire_CC3000::getHostByName(const char *hostname, uint32_t *ip){
+	(void) hostname;
+	const char *host = getenv("HOSTSIM_HOST");
+	struct in_addr addr;
+	if(inet_aton(host != NULL ? host : "127.0.0.1", &addr) == 0){
+		return false;
+	}
+	*ip = ntohl(addr.s_addr);
+	return true;
+}
+
+boolean WildFire_CC3000::getMacAddress(uint8_t address[6]){
+	static const uint8_t mac[6] = {0x08, 0x00, 0x28, 0x57, 0x5A, 0x0E};
+	memcpy(address, mac, sizeof(mac));
+	return true;
+}
+
+boolean WildFire_CC3000::getIPAddress(uint32_t *retip, uint32_t *netmask, uint32_t *gateway, uint32_t *dhcpserv, uint32_t *dnsserv){
+	*retip = 0x7F000001;
+	*netmask = 0xFF000000;
+	*gateway = 0x7F000001;
+	*dhcpserv = 0x7F000001;
+	*dnsserv = 0x7F000001;
+	return true;
+}
+
+void WildFire_CC3000::printIPdotsRev(uint32_t ip){
+	Serial.print((uint8_t) (ip >> 24));
+	Serial.print('.');
+	Serial.print((uint8_t) (ip >> 16));
+	Serial.print('.');
+	Serial.print((uint8_t) (ip >> 8));
+	Serial.print('.');
+	Serial.print((uint8_t) ip);
+}
+
+WildFire_CC3000_Client WildFire_CC3000::connectTCP(uint32_t destIP, uint16_t destPort){
+	const char *port = getenv("HOSTSIM_PORT");
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port != NULL ? atoi(port) : destPort);
+	addr.sin_addr.s_addr = htonl(destIP);
+	int s = ::socket(AF_INET, SOCK_STREAM, 0);
+	if(s < 0){
+		return WildFire_CC3000_Client();
+	}
+	int one = 1;
+	setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	if(connect(s, (struct sockaddr *) &addr, sizeof(addr)) != 0){
+		::close(s);
+		return WildFire_CC3000_Client();
+	}
+	return WildFire_CC3000_Client(s);
+}
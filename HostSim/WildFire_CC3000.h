@@ -0,0 +1,69 @@
+// File: WildFire_CC3000.h
+// Description: The CC3000 WiFi module of the WildFire implemented with
+// Linux sockets so that the sketch talks to a real server over loopback.
+
+/**
+ * The host CC3000 always joins the network and resolves every host
+ * name to the address in the HOSTSIM_HOST environment variable
+ * (127.0.0.1 by default). Connections go to the requested port
+ * unless HOSTSIM_PORT overrides it, so the sketch can be pointed
+ * at the mock server or at a development server.
+ * @file WildFire_CC3000.h */
+
+#ifndef HOSTSIM_WILDFIRE_CC3000_H
+#define HOSTSIM_WILDFIRE_CC3000_H
+
+#include <Arduino.h>
+
+/** A TCP connection opened by the CC3000. Copies share the socket,
+ * which stays open until close() is called. */
+class WildFire_CC3000_Client : public Print
+{
+public:
+	/** Creates a client that is not connected. */
+	WildFire_CC3000_Client();
+	/** Creates a client for an open socket. */
+	WildFire_CC3000_Client(int socket);
+	/** Checks if the connection is open or still has data to be read. */
+	boolean connected();
+	/** Gets the number of bytes that can be read without waiting. */
+	int available();
+	/** Reads a byte.
+	 * @return The byte or -1 if none is available. */
+	int read();
+	/** Closes the connection. */
+	int8_t close();
+	size_t write(uint8_t c);
+	size_t write(const void *buffer, uint16_t len, uint32_t flags = 0);
+	size_t write(const uint8_t *buffer, size_t size){ return write((const void *) buffer, (uint16_t) size); }
+	size_t fastrprint(const char *str);
+	size_t fastrprint(const __FlashStringHelper *str);
+	size_t fastrprintln(const char *str);
+	size_t fastrprintln(const __FlashStringHelper *str);
+private:
+	/** Waits briefly in real time for the server when nothing is buffered. */
+	void waitForData();
+	/** The socket or -1 if the client is not connected. */
+	int socket;
+};
+
+/** The CC3000 WiFi module. */
+class WildFire_CC3000
+{
+public:
+	boolean begin(uint8_t patchReq = 0, boolean useSmartConfigData = false, const char *deviceName = NULL);
+	boolean startSmartConfig(const char *deviceName = NULL, const char *aesKey = NULL);
+	boolean checkDHCP();
+	boolean checkConnected();
+	boolean getHostByName(const char *hostname, uint32_t *ip);
+	boolean getMacAddress(uint8_t address[6]);
+	boolean getIPAddress(uint32_t *retip, uint32_t *netmask, uint32_t *gateway, uint32_t *dhcpserv, uint32_t *dnsserv);
+	void printIPdotsRev(uint32_t ip);
+	/** Opens a TCP connection.
+	 * @param destIP The address returned by getHostByName.
+	 * @param destPort The port of the server.
+	 * @return The client, which is not connected if the connection failed. */
+	WildFire_CC3000_Client connectTCP(uint32_t destIP, uint16_t destPort);
+};
+
+#endif // HOSTSIM_WILDFIRE_CC3000_H
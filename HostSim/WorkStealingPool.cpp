@@ -0,0 +1,82 @@
+#include <WorkStealingPool.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** The tasks left to one thread, the range first to last-1. */
+struct WorkQueue{
+	std::mutex lock;
+	size_t first;
+	size_t last;
+};
+
+WorkStealingPool::WorkStealingPool(unsigned threads){
+	if(threads == 0){
+		threads = std::thread::hardware_concurrency();
+	}
+	WorkStealingPool::threads = threads > 0 ? threads : 1;
+	queues = new WorkQueue[WorkStealingPool::threads];
+	steals = 0;
+}
+
+WorkStealingPool::~WorkStealingPool(){
+	delete[] queues;
+}
+
+void WorkStealingPool::run(size_t count, PoolTask task, void *context){
+	for(unsigned w = 0; w < threads; w++){
+		queues[w].first = count * w / threads;
+		queues[w].last = count * (w + 1) / threads;
+	}
+	steals = 0;
+	std::vector<std::thread> pool;
+	for(unsigned w = 1; w < threads; w++){
+		pool.push_back(std::thread(&WorkStealingPool::work, this, w, task, context));
+	}
+	// The calling thread is the first worker
+	work(0, task, context);
+	for(size_t i = 0; i < pool.size(); i++){
+		pool[i].join();
+	}
+}
+
+void WorkStealingPool::work(unsigned worker, PoolTask task, void *context){
+	WorkQueue &own = queues[worker];
+	for(;;){
+		size_t index;
+		{
+			std::lock_guard<std::mutex> guard(own.lock);
+			if(own.first == own.last){
+				break;
+			}
+			index = own.first++;
+		}
+		task(index, worker, context);
+	}
+	// No task is ever added, so a thread is done once every queue is empty
+	for(;;){
+		boolean found = false;
+		size_t index = 0;
+		for(unsigned i = 1; i < threads && !found; i++){
+			WorkQueue &victim = queues[(worker + i) % threads];
+			std::lock_guard<std::mutex> guard(victim.lock);
+			if(victim.first < victim.last){
+				index = --victim.last;
+				found = true;
+			}
+		}
+		if(!found){
+			return;
+		}
+		steals++;
+		task(index, worker, context);
+	}
+}
+
+unsigned WorkStealingPool::getThreads(){
+	return threads;
+}
+
+uint64_t WorkStealingPool::getSteals(){
+	return steals;
+}
@@ -0,0 +1,56 @@
+// File: WorkStealingPool.h
+// Description: Defines a pool of threads that runs a batch of numbered
+// tasks, with idle threads taking work from busy ones.
+
+/**
+ * The Work Stealing Pool runs the tasks 0 to count-1 of a batch.
+ * Each thread starts with its own contiguous run of tasks, which it
+ * takes from the front in order. A thread that runs out takes one
+ * task from the back of another thread's run, so a few slow tasks
+ * do not leave the other threads waiting. Tasks are told which
+ * thread runs them so that they can use state kept per thread.
+ * @file WorkStealingPool.h */
+
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <Arduino.h>
+#include <atomic>
+
+/** The function that runs a task.
+ * @param index The number of the task.
+ * @param worker The number of the thread running it, below getThreads().
+ * @param *context The context given to run(). */
+typedef void (*PoolTask)(size_t index, unsigned worker, void *context);
+
+struct WorkQueue;
+
+/** WorkStealingPool runs batches of tasks on several threads.
+ * @class WorkStealingPool */
+class WorkStealingPool
+{
+public:
+	/** The constructor.
+	 * @param threads The number of threads, or 0 for one per core. */
+	WorkStealingPool(unsigned threads);
+	/** The destructor. */
+	~WorkStealingPool();
+	/** Runs the tasks 0 to count-1 and returns once all of them are done.
+	 * @param count The number of tasks.
+	 * @param task The function that runs each task.
+	 * @param *context Passed to the task. */
+	void run(size_t count, PoolTask task, void *context);
+	/** Gets the number of threads. */
+	unsigned getThreads();
+	/** Gets the number of tasks taken from another thread during the last run. */
+	uint64_t getSteals();
+private:
+	/** Runs the tasks of one thread, then those it can steal. */
+	void work(unsigned worker, PoolTask task, void *context);
+
+	unsigned threads;
+	WorkQueue *queues;
+	std::atomic<uint64_t> steals;
+};
+
+#endif // WORK_STEALING_POOL_H
@@ -0,0 +1,33 @@
+// File: eeprom.h
+// Description: The EEPROM functions of avr-libc backed by a file so that
+// the configuration survives between runs of the host simulation.
+
+/**
+ * The EEPROM is loaded from the file named by the HOSTSIM_EEPROM
+ * environment variable (hostsim_eeprom.bin by default) on first
+ * use and every write is written through to the file. Addresses
+ * are the integer values of the pointers, as on the device.
+ * @file eeprom.h */
+
+#ifndef HOSTSIM_EEPROM_H
+#define HOSTSIM_EEPROM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define E2END 0x0FFF ///< Defines the last address of the EEPROM of the ATmega1284P.
+
+uint8_t eeprom_read_byte(const uint8_t *addr);
+uint16_t eeprom_read_word(const uint16_t *addr);
+uint32_t eeprom_read_dword(const uint32_t *addr);
+void eeprom_read_block(void *dst, const void *src, size_t n);
+void eeprom_write_byte(uint8_t *addr, uint8_t value);
+void eeprom_write_word(uint16_t *addr, uint16_t value);
+void eeprom_write_dword(uint32_t *addr, uint32_t value);
+void eeprom_write_block(const void *src, void *dst, size_t n);
+#define eeprom_update_byte eeprom_write_byte
+#define eeprom_update_word eeprom_write_word
+#define eeprom_update_dword eeprom_write_dword
+#define eeprom_update_block eeprom_write_block
+
+#endif // HOSTSIM_EEPROM_H
@@ -0,0 +1,55 @@
+#! /bin/bash
+# Builds the host simulation of OregonScientificExample into build/hostsim
+# along with the host tools that share its libraries:
+#   build/ookdemod     decodes raw 433.92 MHz captures
+#   build/tracedecode  decodes recorded pulse traces on every core
+#   build/gatewayread  reads the frames a GATEWAY build sends over Serial
+#   build/multigateway merges the frames of several receivers
+#   build/hostcheck    checks the libraries against recorded input, and is run
+# Every library folder next to this one is compiled with the host
+# versions of the Arduino core and the WildFire hardware found here.
+
+cd "$(dirname "$0")"
+SKETCH=../OregonScientificExample
+OUT=build
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--O2 -g}
+# Extra defines, such as DEFINES=-DLATENCY_TRACE to build with the trace points
+DEFINES=${DEFINES:-}
+# The sources with a main function, which are linked on their own
+PROGRAMS="main ookdemod tracedecode gatewayread multigateway hostcheck"
+
+mkdir -p $OUT/obj
+INCLUDES="-I. -I$SKETCH"
+SOURCES=""
+for src in *.cpp; do
+	case " $PROGRAMS " in
+		*" ${src%.cpp} "*) ;;
+		*) SOURCES="$SOURCES $src" ;;
+	esac
+done
+for lib in ../*/; do
+	if [ "$lib" != "../HostSim/" ] && ls $lib*.cpp > /dev/null 2>&1; then
+		INCLUDES="$INCLUDES -I$lib"
+		SOURCES="$SOURCES $lib*.cpp"
+	fi
+done
+FLAGS="-std=gnu++11 -DARDUINO=10600 -DHOSTSIM $DEFINES $CXXFLAGS $INCLUDES"
+
+OBJECTS=""
+for src in $SOURCES; do
+	obj=$OUT/obj/$(basename ${src%.cpp}).o
+	$CXX $FLAGS -c $src -o $obj || exit 1
+	OBJECTS="$OBJECTS $obj"
+done
+rm -f $OUT/libhostsim.a
+ar rcs $OUT/libhostsim.a $OBJECTS || exit 1
+
+python3 sketch.py $SKETCH > $OUT/sketch.cpp || exit 1
+$CXX $FLAGS main.cpp $OUT/sketch.cpp $OUT/libhostsim.a -o $OUT/hostsim -lpthread || exit 1
+$CXX $FLAGS ookdemod.cpp $OUT/libhostsim.a -o $OUT/ookdemod -lpthread || exit 1
+$CXX $FLAGS tracedecode.cpp $OUT/libhostsim.a -o $OUT/tracedecode -lpthread || exit 1
+$CXX $FLAGS gatewayread.cpp $OUT/libhostsim.a -o $OUT/gatewayread -lpthread || exit 1
+$CXX $FLAGS multigateway.cpp $OUT/libhostsim.a -o $OUT/multigateway -lpthread || exit 1
+$CXX $FLAGS hostcheck.cpp $OUT/sketch.cpp $OUT/libhostsim.a -o $OUT/hostcheck -lpthread || exit 1
+$OUT/hostcheck || exit 1
@@ -0,0 +1,168 @@
+// File: gatewayread.cpp
+// Description: Reads the frames that a receiver built for the gateway
+// environment sends over Serial, and measures how fast they can be parsed.
+
+#include <Arduino.h>
+#include <GatewayReader.h>
+#include <OregonScientific.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#include "header.h"
+
+#define BENCH_RECORDS 1000000 ///< The number of records in the benchmark stream.
+#define BENCH_RUNS 5 ///< The number of runs the benchmark keeps the fastest of.
+#define BENCH_NIBBLES 18 ///< The nibbles of a benchmark frame, those of a THGR122NX.
+#define BITS_PER_BYTE 10 ///< The bits on the line for every byte, with its start and stop bits.
+
+static double seconds(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Prints a frame as: seconds protocol device-id channel flags rssi nibbles
+static void printFrame(const GatewayFrame &frame, void *context){
+	(void) context;
+	static const char hex[] = "0123456789ABCDEF";
+	char nibbles[GATEWAY_MAX_NIBBLES + 1];
+	for(uint8_t i = 0; i < frame.size; i++){
+		nibbles[i] = hex[frame.nibble(i)];
+	}
+	nibbles[frame.size] = '\0';
+	printf("%lu.%03lu %s %08lX %u %c%c %d %s\n", (unsigned long) (frame.time / 1000), (unsigned long) (frame.time % 1000),
+		frame.protocol == OSCV_3 ? "V3" : "V2.1", (unsigned long) frame.sensorId, frame.channel,
+		frame.flags & GATEWAY_FLAG_REPAIRED ? 'R' : '-', frame.flags & GATEWAY_FLAG_DROPPED ? 'D' : '-', frame.rssi, nibbles);
+}
+
+// Sums the nibbles so that the benchmark reads every frame it is handed
+static void sumFrame(const GatewayFrame &frame, void *context){
+	uint32_t *sum = (uint32_t *) context;
+	for(uint8_t i = 0; i < frame.size; i++){
+		*sum += frame.nibble(i);
+	}
+}
+
+// Puts a serial device into raw mode at the baud rate
+static boolean setRaw(int fd, uint32_t baud){
+	struct termios tio;
+	if(tcgetattr(fd, &tio) != 0){
+		return false;
+	}
+	cfmakeraw(&tio);
+	speed_t speed;
+	switch(baud){
+	case 115200: speed = B115200; break;
+	case 230400: speed = B230400; break;
+	case 500000: speed = B500000; break;
+	case 1000000: speed = B1000000; break;
+	case 2000000: speed = B2000000; break;
+	default: return false;
+	}
+	cfsetispeed(&tio, speed);
+	cfsetospeed(&tio, speed);
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 0;
+	return tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+// Parses a generated stream in memory, as fast as the reader can, and compares it with the line rate
+static void benchmark(uint32_t count, uint32_t seed){
+	srand(seed);
+	std::vector<uint8_t> stream;
+	stream.reserve((size_t) count * GATEWAY_MAX_ENCODED);
+	uint8_t nibbles[BENCH_NIBBLES];
+	uint8_t record[GATEWAY_MAX_RECORD];
+	uint8_t encoded[GATEWAY_MAX_ENCODED];
+	for(uint32_t i = 0; i < count; i++){
+		for(uint8_t j = 0; j < BENCH_NIBBLES; j++){
+			nibbles[j] = rand() & 0x0F;
+		}
+		uint8_t length = SerialGateway::packFrame(i * 50, 0x1D20 | (rand() & 0x03), 1 + rand() % 3, OSCV_2_1,
+			rand() % 8 == 0 ? GATEWAY_FLAG_REPAIRED : 0, -60 - rand() % 40, nibbles, BENCH_NIBBLES, record);
+		size_t n = SerialGateway::cobsEncode(record, length, encoded);
+		stream.insert(stream.end(), encoded, encoded + n);
+	}
+	// Parsing overwrites the stream, so every run starts from a copy
+	std::vector<uint8_t> work(stream.size());
+	double best = 0;
+	uint32_t sum = 0;
+	uint64_t frames = 0;
+	for(int run = 0; run < BENCH_RUNS; run++){
+		memcpy(&work[0], &stream[0], stream.size());
+		GatewayReader reader(sumFrame, &sum);
+		double start = seconds();
+		reader.parse(&work[0], work.size());
+		double elapsed = seconds() - start;
+		if(run == 0 || elapsed < best){
+			best = elapsed;
+		}
+		frames = reader.getFrames();
+	}
+	double bytesPerSecond = stream.size() / best;
+	double lineBytes = GATEWAY_BAUD / (double) BITS_PER_BYTE;
+	fprintf(stderr, "gatewayread: %llu of %u records (%.1f bytes each) parsed in %.3f ms (checksum %u)\n",
+		(unsigned long long) frames, count, stream.size() / (double) count, best * 1e3, sum);
+	fprintf(stderr, "gatewayread: %.1f MB/s, %.2f M records/s, %.0fx the %u baud line (%.0f records/s)\n",
+		bytesPerSecond / 1e6, frames / best / 1e6, bytesPerSecond / lineBytes, (unsigned) GATEWAY_BAUD,
+		lineBytes / (stream.size() / (double) count));
+}
+
+static void usage(const char *name){
+	fprintf(stderr,
+		"usage: %s [options] [file|device|-]\n"
+		"       %s -b [options]\n"
+		"  -s baud       baud rate of a serial device (default %u)\n"
+		"  -q            do not print the frames\n"
+		"  -b            benchmark the reader on a generated stream\n"
+		"  -n records    records in the generated stream (default %d)\n"
+		"Frames are printed as: seconds protocol device-id channel flags rssi nibbles\n"
+		"The flags are R for a repaired frame and D for one decoded after pulses were dropped.\n",
+		name, name, (unsigned) GATEWAY_BAUD, BENCH_RECORDS);
+	exit(2);
+}
+
+int main(int argc, char **argv){
+	uint32_t baud = GATEWAY_BAUD;
+	boolean quiet = false;
+	boolean bench = false;
+	uint32_t count = BENCH_RECORDS;
+	int opt;
+	while((opt = getopt(argc, argv, "s:qbn:h")) != -1){
+		switch(opt){
+		case 's': baud = strtoul(optarg, NULL, 10); break;
+		case 'q': quiet = true; break;
+		case 'b': bench = true; break;
+		case 'n': count = strtoul(optarg, NULL, 10); break;
+		default: usage(argv[0]);
+		}
+	}
+	if(bench){
+		benchmark(count, 1);
+		return 0;
+	}
+	int fd = STDIN_FILENO;
+	if(optind == argc - 1 && strcmp(argv[optind], "-") != 0){
+		fd = open(argv[optind], O_RDONLY | O_NOCTTY);
+		if(fd < 0){
+			fprintf(stderr, "gatewayread: could not open %s\n", argv[optind]);
+			return 1;
+		}
+		if(isatty(fd) && !setRaw(fd, baud)){
+			fprintf(stderr, "gatewayread: could not set %s to %u baud\n", argv[optind], baud);
+			return 1;
+		}
+	}else if(optind < argc - 1){
+		usage(argv[0]);
+	}
+	uint32_t sum = 0;
+	GatewayReader reader(quiet ? sumFrame : printFrame, &sum);
+	boolean ok = reader.readAll(fd);
+	fprintf(stderr, "gatewayread: %llu frames, %llu bad records, %llu bytes skipped\n",
+		(unsigned long long) reader.getFrames(), (unsigned long long) reader.getBadRecords(),
+		(unsigned long long) reader.getSkippedBytes());
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,999 @@
+// File: hostcheck.cpp
+// Description: Checks the libraries and functions of the sketch on the
+// host against recorded input and straightforward references, and fails
+// the build if any of them disagree.
+
+#include <Arduino.h>
+#include <HTTPResponseParser.h>
+#include <SensorAggregator.h>
+#include <ReportingPolicy.h>
+#include <FrameRepair.h>
+#include <OregonEncoder.h>
+#include <SensorConfig.h>
+#include <RFM69OOK.h>
+#include <RFM69Mock.h>
+#include <SerialGateway.h>
+#include <GatewayReader.h>
+#include <LiquidCrystal.h>
+#include <HostSim.h>
+#include <WildFire_CC3000.h>
+#include <algorithm>
+#include <avr/eeprom.h>
+#include <math.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+#include "header.h"
+
+// The sketch, which is linked in but never set up
+boolean loadSensorConfig(SensorConfig &config);
+void saveSensorConfig(const SensorConfig &config);
+void setEncryptionKey(char *key);
+void encrypt(char *plaintext, char *key, char *encrypted);
+int parseBuildingReply(char *serverReply);
+boolean pollResponse(WildFire_CC3000_Client &client, HTTPResponseParser &response, uint32_t sent_at);
+void serviceServer();
+void lcd_begin();
+void lcd_print_top(char *message);
+void lcd_print_bottom(char *message);
+void lcd_flush(boolean force);
+void lcd_set_immediate(boolean immediate);
+extern LiquidCrystal lcd;
+extern WildFire_CC3000_Client building_client;
+extern HTTPResponseParser building_response;
+extern uint32_t building_sent_at;
+extern boolean building_pending;
+extern int building_id;
+
+static uint32_t checks = 0;
+static uint32_t failures = 0;
+
+/** Counts a check and reports it if it failed. */
+static void check(boolean passed, const char *name, const char *detail){
+	checks++;
+	if(!passed){
+		failures++;
+		fprintf(stderr, "hostcheck: FAILED %s: %s\n", name, detail);
+	}
+}
+
+/** A generator of random numbers that gives the same numbers on every host.
+ * @param &state The state, which is not 0.
+ * @return The next number. */
+static uint32_t nextRandom(uint32_t &state){
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+/*
+ * The reply parser
+ */
+/** A reply as the server sends it, and what the sketch should keep of it. */
+struct RecordedReply{
+	const char *name;
+	const char *text;
+	uint16_t bodySize;
+	uint16_t status;
+	int32_t contentLength;
+	const char *body;
+	boolean overflowed;
+};
+
+/** The replies recorded from the server: an upload reply, a building reply,
+ * and a building reply from a server that closes the connection without a
+ * Content-Length, which finish() completes. The space before the end marker
+ * stays in the body, which the sketch strips before it decrypts, and the
+ * upload reply overflows its buffer, of which the sketch reads one word. */
+static const RecordedReply RECORDED_REPLIES[] = {
+	{"upload reply",
+		"HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: 29\r\nConnection: close\r\n\r\n"
+		"start\nSuccess uploading data\n",
+		UPLOAD_REPLY_SIZE, 200, 29, "Success ", true},
+	{"building reply",
+		"HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: 74\r\nConnection: close\r\n\r\n"
+		"start 9C0E51A7F2D3B6480E1A5C7D92F03B6E4A18D5C2B7E0963F1D4A8C5E2B70F691 end",
+		BUILDING_REPLY_SIZE, 200, 74, "9C0E51A7F2D3B6480E1A5C7D92F03B6E4A18D5C2B7E0963F1D4A8C5E2B70F691 ", false},
+	{"building reply without a length",
+		"HTTP/1.1 200 OK\r\nconnection: close\r\n\r\n"
+		"start 5E2B70F6919C0E51A7F2D3B648 en",
+		BUILDING_REPLY_SIZE, 200, HTTP_NO_LENGTH, "5E2B70F6919C0E51A7F2D3B648 en", false},
+};
+
+/** Opens a connection whose other end the check plays the server on.
+ * @param &client Receives the end that the sketch reads.
+ * @return The end that the reply is written to, or -1. */
+static int openConnection(WildFire_CC3000_Client &client){
+	int ends[2];
+	if(socketpair(AF_UNIX, SOCK_STREAM, 0, ends) != 0){
+		return -1;
+	}
+	client = WildFire_CC3000_Client(ends[0]);
+	return ends[1];
+}
+
+/** Compares what a parser kept of a reply with what it should have kept.
+ * @param *when Where the reply was cut, for the report. */
+static void checkReply(HTTPResponseParser &response, const RecordedReply &reply, const char *when){
+	char detail[200];
+	boolean passed = response.getStatusCode() == reply.status && response.getContentLength() == reply.contentLength
+		&& strcmp(response.getBody(), reply.body) == 0 && response.getBodyLength() == strlen(reply.body)
+		&& response.hasOverflowed() == reply.overflowed;
+	snprintf(detail, sizeof(detail), "%s gave status %u, length %ld, body \"%s\", overflow %d", when,
+		response.getStatusCode(), (long) response.getContentLength(), response.getBody(), response.hasOverflowed());
+	check(passed, reply.name, detail);
+}
+
+/** Sends every recorded reply to pollResponse in pieces of many sizes, with
+ * passes that find nothing to read between them, the way the replies trickle
+ * in over the CC3000. A reply with a length is complete with its last byte,
+ * and one without a length when the server closes the connection. */
+static void checkPolledReplies(){
+	const size_t pieces[] = {1, 2, 3, 5, 8, 13, 64, 1024};
+	char when[64];
+	for(size_t r = 0; r < sizeof(RECORDED_REPLIES) / sizeof(RECORDED_REPLIES[0]); r++){
+		const RecordedReply &reply = RECORDED_REPLIES[r];
+		size_t length = strlen(reply.text);
+		for(size_t p = 0; p < sizeof(pieces) / sizeof(pieces[0]); p++){
+			WildFire_CC3000_Client client;
+			int server = openConnection(client);
+			HTTPResponseParser response(reply.bodySize);
+			uint32_t sentAt = millis();
+			boolean early = pollResponse(client, response, sentAt);
+			size_t sent = 0;
+			while(sent < length && !early){
+				size_t size = length - sent < pieces[p] ? length - sent : pieces[p];
+				send(server, reply.text + sent, size, 0);
+				sent += size;
+				// A pass that reads the piece, and one that finds nothing more
+				boolean complete = pollResponse(client, response, sentAt);
+				complete = pollResponse(client, response, sentAt) || complete;
+				early = complete && sent < length;
+				if(complete){
+					break;
+				}
+			}
+			boolean waited = !response.isComplete();
+			close(server);
+			boolean closed = pollResponse(client, response, sentAt);
+			snprintf(when, sizeof(when), "pieces of %u bytes", (unsigned) pieces[p]);
+			check(!early && closed && waited == (reply.contentLength == HTTP_NO_LENGTH), reply.name,
+				early ? "complete before its last byte" : "not complete when its length was read or the connection closed");
+			checkReply(response, reply, when);
+		}
+	}
+
+	// A server that stops halfway through and never closes the connection
+	const RecordedReply &reply = RECORDED_REPLIES[1];
+	WildFire_CC3000_Client client;
+	int server = openConnection(client);
+	HTTPResponseParser response(reply.bodySize);
+	uint32_t sentAt = millis();
+	size_t half = strlen(reply.text) - 20;
+	send(server, reply.text, half, 0);
+	boolean complete = pollResponse(client, response, sentAt);
+	hostsim_advance((RESPONSE_TIMEOUT_MS - 100) * 1000ULL);
+	complete = pollResponse(client, response, sentAt) || complete;
+	check(!complete, reply.name, "complete before the server stopped for RESPONSE_TIMEOUT_MS");
+	hostsim_advance(200 * 1000ULL);
+	complete = pollResponse(client, response, sentAt);
+	check(complete && !client.connected() && strncmp(response.getBody(), reply.body, strlen(response.getBody())) == 0
+		&& strlen(response.getBody()) > 0, reply.name, "not cut off with what had arrived after RESPONSE_TIMEOUT_MS");
+	close(server);
+}
+
+/** Queries the building the way the main loop does, with the reply in
+ * pieces that serviceServer reads on its passes through the loop.
+ * @param *plain The reply before it is encrypted with the key fffff.
+ * @return The number of passes that found the reply incomplete. */
+static uint16_t queryBuilding(const char *plain){
+	char key[] = "fffff";
+	char cipher[192];
+	strcpy(cipher, plain);
+	setEncryptionKey(key);
+	encrypt(cipher, key, cipher);
+	char text[320];
+	snprintf(text, sizeof(text), "HTTP/1.1 200 OK\r\nContent-Length: %u\r\nConnection: close\r\n\r\nstart %s end",
+		(unsigned) (strlen(cipher) + 10), cipher);
+	int server = openConnection(building_client);
+	building_response.reset();
+	building_sent_at = millis();
+	building_pending = true;
+	size_t length = strlen(text);
+	uint16_t passes = 0;
+	for(size_t sent = 0; sent < length; sent += 7){
+		send(server, text + sent, length - sent < 7 ? length - sent : 7, 0);
+		serviceServer();
+		serviceServer();
+		passes += building_pending;
+	}
+	close(server);
+	return passes;
+}
+
+/** Queries the building with a reply that fits the buffer, and with one
+ * whose sensors run past it, which must be discarded as a whole. */
+static void checkBuildingQuery(){
+	const char *plain = "1792405863 building 7 cutoff 0";
+	char detail[128];
+	building_id = -1;
+	uint16_t passes = queryBuilding(plain);
+	uint16_t expected = (strlen(plain) + strlen("HTTP/1.1 200 OK\r\nContent-Length: 40\r\nConnection: close\r\n\r\nstart  end") + 6) / 7 - 1;
+	snprintf(detail, sizeof(detail), "the building was %d after %u passes, still pending %d", building_id, passes, building_pending);
+	check(!building_pending && building_id == 7 && passes == expected && !building_response.hasOverflowed(), "building query", detail);
+
+	SensorConfig before;
+	SensorConfig after;
+	boolean stored = loadSensorConfig(before);
+	char reply[192] = "1792405863 building 8 cutoff 0 sensors ";
+	while(strlen(reply) <= BUILDING_REPLY_SIZE){
+		strcat(reply, "0104050000");
+	}
+	queryBuilding(reply);
+	snprintf(detail, sizeof(detail), "a reply of %u characters gave the building %d, overflow %d",
+		(unsigned) strlen(reply), building_id, building_response.hasOverflowed());
+	check(!building_pending && building_id == 7 && building_response.hasOverflowed()
+		&& loadSensorConfig(after) == stored && (!stored || after.equals(before)), "building query", detail);
+}
+
+/*
+ * The sensor aggregator
+ */
+#define AGGREGATOR_STREAM 200000 ///< The number of readings in each stream of random readings.
+/** A reading of a THGR122NX as the sketch receives it. */
+struct RecordedReading{
+	uint32_t time; ///< The time of the reading in milliseconds.
+	int16_t values[2]; ///< The temperature in tenths of a degree and the humidity in percent.
+};
+
+/** Readings every 39 seconds or so, below freezing so that the means of the
+ * temperature round negative values, with a gap where the sensor was not heard. */
+static const RecordedReading RECORDED_READINGS[] = {
+	{12000, {-23, 81}}, {50931, {-25, 81}}, {90197, {-29, 80}}, {129345, {-32, 80}}, {168541, {-36, 81}},
+	{207360, {-40, 80}}, {246404, {-38, 79}}, {285250, {-41, 80}}, {324284, {-45, 81}}, {363010, {-46, 82}},
+	{402252, {-50, 83}}, {441451, {-48, 82}}, {480277, {-52, 83}}, {519013, {-52, 83}}, {557760, {-55, 84}},
+	{596675, {-57, 83}}, {635870, {-58, 83}}, {674569, {-61, 84}}, {1133230, {-62, 84}}, {1172526, {-60, 84}},
+	{1211602, {-57, 84}}, {1250508, {-58, 83}}, {1289823, {-59, 82}}, {1329011, {-59, 83}}, {1368117, {-58, 84}},
+	{1407176, {-58, 85}}, {1445850, {-61, 86}}, {1484878, {-63, 86}}, {1523633, {-60, 86}}, {1562273, {-63, 87}},
+	{1601459, {-62, 87}}, {1640770, {-61, 88}}, {1679878, {-58, 87}}, {1718573, {-58, 87}}, {1757886, {-61, 86}},
+	{1797234, {-61, 87}},
+};
+
+/** Compares the summary of a window with one computed directly from its readings.
+ * A window holds at most 0xFFFF readings, after which the aggregator ignores them.
+ * @param *readings The readings that were added.
+ * @param first The index of the first reading of the window.
+ * @param end The index after its last reading.
+ * @param *name The name of the readings, for the report. */
+static void checkWindow(SensorAggregator &aggregate, const RecordedReading *readings, size_t first, size_t end, const char *name){
+	char detail[200];
+	if(end - first > 0xFFFF){
+		end = first + 0xFFFF;
+	}
+	boolean passed = aggregate.getCount() == end - first;
+	snprintf(detail, sizeof(detail), "%s: window of readings %u to %u held %u readings",
+		name, (unsigned) first, (unsigned) end - 1, aggregate.getCount());
+	for(uint8_t f = 0; f < 2 && passed; f++){
+		int16_t minimum = readings[first].values[f];
+		int16_t maximum = minimum;
+		double sum = 0;
+		for(size_t i = first; i < end; i++){
+			int16_t value = readings[i].values[f];
+			minimum = value < minimum ? value : minimum;
+			maximum = value > maximum ? value : maximum;
+			sum += value;
+		}
+		// round() takes halves away from zero, as the aggregator does
+		int16_t mean = (int16_t) round(sum / (end - first));
+		passed = aggregate.getMinimum(f) == minimum && aggregate.getMaximum(f) == maximum
+			&& aggregate.getMean(f) == mean && aggregate.getLast(f) == readings[end - 1].values[f];
+		snprintf(detail, sizeof(detail), "%s: window of readings %u to %u, field %u: min %d max %d mean %d last %d, expected %d %d %d %d",
+			name, (unsigned) first, (unsigned) end - 1, f, aggregate.getMinimum(f), aggregate.getMaximum(f), aggregate.getMean(f),
+			aggregate.getLast(f), minimum, maximum, mean, readings[end - 1].values[f]);
+	}
+	check(passed, "sensor aggregator", detail);
+}
+
+/** Runs readings through an aggregator the way the sketch does, reporting
+ * and resetting each window that has ended before the next reading.
+ * @param *readings The readings, in the order they are received.
+ * @param count The number of readings.
+ * @param windowLength The length of the windows in milliseconds.
+ * @param *name The name of the readings, for the report.
+ * @return The number of windows. */
+static uint32_t runReadings(const RecordedReading *readings, size_t count, uint32_t windowLength, const char *name){
+	SensorAggregator aggregate(2, windowLength);
+	size_t first = 0;
+	uint32_t windows = 1;
+	boolean ended = true;
+	for(size_t i = 0; i < count; i++){
+		if(aggregate.windowComplete(readings[i].time)){
+			checkWindow(aggregate, readings, first, i, name);
+			aggregate.reset();
+			first = i;
+			windows++;
+		}
+		// A window ends with the first reading at least its length after it opened
+		ended = ended && (readings[i].time - readings[first].time < windowLength || i == first);
+		aggregate.addReading(readings[i].values, readings[i].time);
+	}
+	checkWindow(aggregate, readings, first, count, name);
+	check(ended, "sensor aggregator", "a window was not complete at the end of its length");
+	return windows;
+}
+
+/** Gets a value of a field that is often at one of the ends of its range.
+ * @param &state The state of the random numbers. */
+static int16_t extremeValue(uint32_t &state){
+	uint32_t r = nextRandom(state);
+	switch(r % 8){
+	case 0:
+		return INT16_MIN;
+	case 1:
+		return INT16_MAX;
+	case 2:
+		return (int16_t) ((r >> 8) % 5) - 2;
+	default:
+		return (int16_t) (r >> 16);
+	}
+}
+
+/** Runs the recorded readings, then long seeded streams of readings over the
+ * whole range of the fields, through the aggregator and compares every window
+ * with one computed from its readings: readings at the ends of the range, with
+ * gaps longer than a window and across the wrap of millis(), windows whose sums
+ * reach the limits of the range, and a window with more readings than it counts. */
+static void checkAggregator(){
+	const uint32_t windowLengths[] = {AGGREGATION_WINDOW_MS, 60000, 1};
+	size_t count = sizeof(RECORDED_READINGS) / sizeof(RECORDED_READINGS[0]);
+	for(size_t w = 0; w < sizeof(windowLengths) / sizeof(windowLengths[0]); w++){
+		runReadings(RECORDED_READINGS, count, windowLengths[w], "recorded readings");
+	}
+
+	uint32_t state = 0x5EED0029;
+	std::vector<RecordedReading> stream;
+	for(size_t w = 0; w < sizeof(windowLengths) / sizeof(windowLengths[0]); w++){
+		stream.clear();
+		uint32_t now = 0xFFFFFFFF - 50 * windowLengths[w]; // millis() wraps during the stream
+		for(size_t i = 0; i < AGGREGATOR_STREAM; i++){
+			uint32_t r = nextRandom(state);
+			// Mostly several readings a window, sometimes many windows without one
+			now += r % 64 == 0 ? windowLengths[w] * (1 + (r >> 8) % 20) : (r >> 8) % (windowLengths[w] / 8 + 1);
+			RecordedReading reading = {now, {extremeValue(state), extremeValue(state)}};
+			stream.push_back(reading);
+		}
+		char name[48];
+		snprintf(name, sizeof(name), "stream of %lu ms windows", (unsigned long) windowLengths[w]);
+		uint32_t windows = runReadings(stream.data(), stream.size(), windowLengths[w], name);
+		check(windows > AGGREGATOR_STREAM / 128, "sensor aggregator", "the stream did not roll over its windows");
+	}
+
+	// Windows whose sums reach the limits, then one with more readings than its count holds
+	stream.clear();
+	const int16_t saturated[][2] = {{INT16_MAX, INT16_MIN}, {INT16_MIN, INT16_MAX}};
+	uint32_t now = 0;
+	for(size_t w = 0; w < 2; w++, now += AGGREGATION_WINDOW_MS){
+		for(uint32_t i = 0; i < 0xFFFF; i++){
+			RecordedReading reading = {now, {saturated[w][0], saturated[w][1]}};
+			stream.push_back(reading);
+		}
+	}
+	for(uint32_t i = 0; i < 0xFFFF + 5000; i++){
+		RecordedReading reading = {now + i / 1000, {extremeValue(state), extremeValue(state)}};
+		stream.push_back(reading);
+	}
+	RecordedReading after = {now + AGGREGATION_WINDOW_MS, {1, -1}};
+	stream.push_back(after);
+	check(runReadings(stream.data(), stream.size(), AGGREGATION_WINDOW_MS, "saturated windows") == 4,
+		"sensor aggregator", "the saturated windows did not end after their length");
+}
+
+/*
+ * The reporting policy
+ */
+#define POLICY_DAYS 7 ///< The number of days of windows fed to the policy.
+
+/** Feeds a policy the means of windows with the deadbands and the longest
+ * silence of the sketch, and the changes of the battery flag, checking each
+ * decision against the rules. Then measures how many of a week of windows of
+ * a sensor outdoors are suppressed, with every suppressed window within the
+ * deadbands of the last report. */
+static void checkReportingPolicy(){
+	char detail[160];
+	ReportingPolicy policy(2, MAX_SILENCE_MS);
+	policy.setDeadband(0, TEMP_DEADBAND);
+	policy.setDeadband(1, HUMIDITY_DEADBAND);
+	const uint32_t start = 0xFFFFFFFF - AGGREGATION_WINDOW_MS; // millis() wraps during the check
+	uint32_t now = start;
+	int16_t values[2] = {215, 48};
+	check(!policy.batteryChanged(true), "reporting policy", "a battery change was seen before the first report");
+	check(policy.shouldReport(values, false, 8, now) && policy.getReported() == 1, "reporting policy", "the first window was not reported");
+
+	// The deadbands, which are measured from the last report, so that a slow drift is reported once it adds up
+	const int16_t steps[][3] = {
+		{TEMP_DEADBAND, 0, false}, {1, 0, true}, {-1, HUMIDITY_DEADBAND, false}, {-1, 0, false},
+		{0, 1, true}, {-TEMP_DEADBAND, -HUMIDITY_DEADBAND, false}, {TEMP_DEADBAND, HUMIDITY_DEADBAND, false}, {0, -HUMIDITY_DEADBAND - 1, true},
+	};
+	int16_t reported[2] = {values[0], values[1]};
+	uint16_t suppressed = 0;
+	for(size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++){
+		now += AGGREGATION_WINDOW_MS;
+		values[0] += steps[i][0];
+		values[1] += steps[i][1];
+		boolean report = policy.shouldReport(values, false, 8, now);
+		snprintf(detail, sizeof(detail), "a change to %d and %d from %d and %d was %s", values[0], values[1], reported[0], reported[1],
+			report ? "reported" : "suppressed");
+		check(report == (steps[i][2] != 0) && (!report || policy.getSuppressedBeforeReport() == suppressed), "reporting policy", detail);
+		if(report){
+			reported[0] = values[0];
+			reported[1] = values[1];
+			suppressed = 0;
+		}else{
+			suppressed += 8;
+		}
+	}
+
+	// The longest silence, across the wrap of millis()
+	uint32_t last = now;
+	while(!policy.shouldReport(reported, false, 8, now += AGGREGATION_WINDOW_MS)){
+	}
+	snprintf(detail, sizeof(detail), "unchanged windows were reported after %lu ms", (unsigned long) (now - last));
+	check(now - last == (MAX_SILENCE_MS + AGGREGATION_WINDOW_MS - 1) / AGGREGATION_WINDOW_MS * AGGREGATION_WINDOW_MS
+		&& now < start && policy.getSuppressedBeforeReport() == 8 * (MAX_SILENCE_MS / AGGREGATION_WINDOW_MS - 1), "reporting policy", detail);
+
+	// The battery flag, which is reported when it changes and only then
+	check(policy.batteryChanged(true) && !policy.batteryChanged(false), "reporting policy", "a battery change was not seen");
+	check(policy.shouldReport(reported, true, 1, now + 1000), "reporting policy", "a low battery with unchanged values was not reported");
+	check(!policy.batteryChanged(true) && policy.batteryChanged(false), "reporting policy", "the reported battery flag was not kept");
+	check(!policy.shouldReport(reported, true, 1, now + 2000), "reporting policy", "an unchanged low battery was reported again");
+	check(policy.shouldReport(reported, false, 1, now + 3000), "reporting policy", "a battery that was changed back was not reported");
+
+	// A week of windows of a sensor outdoors: the temperature swings over the day
+	// with noise in the means, and the humidity follows it the other way
+	ReportingPolicy week(2, MAX_SILENCE_MS);
+	week.setDeadband(0, TEMP_DEADBAND);
+	week.setDeadband(1, HUMIDITY_DEADBAND);
+	uint32_t state = 0x5EED0030;
+	uint32_t windows = POLICY_DAYS * 86400000UL / AGGREGATION_WINDOW_MS;
+	uint32_t lastReport = 0;
+	boolean followed = true;
+	now = 0;
+	for(uint32_t i = 0; i < windows; i++, now += AGGREGATION_WINDOW_MS){
+		double phase = 2 * M_PI * (now % 86400000UL) / 86400000.0;
+		int16_t means[2] = {(int16_t) lround(120 - 60 * cos(phase) + (int16_t) (nextRandom(state) % 3) - 1),
+			(int16_t) lround(65 + 15 * cos(phase) + (int16_t) (nextRandom(state) % 3) - 1)};
+		boolean report = week.shouldReport(means, false, 8, now);
+		// A window within both deadbands of the last report, and within the longest silence, is suppressed
+		boolean within = i > 0 && abs(means[0] - reported[0]) <= TEMP_DEADBAND && abs(means[1] - reported[1]) <= HUMIDITY_DEADBAND
+			&& now - lastReport < MAX_SILENCE_MS;
+		followed = followed && report != within;
+		if(report){
+			reported[0] = means[0];
+			reported[1] = means[1];
+			lastReport = now;
+		}
+	}
+	snprintf(detail, sizeof(detail), "%lu of %lu windows were reported, %lu readings suppressed",
+		(unsigned long) week.getReported(), (unsigned long) windows, (unsigned long) week.getSuppressed());
+	check(followed && week.getSuppressed() == 8 * (windows - week.getReported()), "reporting policy", detail);
+	fprintf(stderr, "hostcheck: reporting policy reported %lu of %lu windows, suppressing %.0f%%\n",
+		(unsigned long) week.getReported(), (unsigned long) windows, 100.0 * (windows - week.getReported()) / windows);
+}
+
+/*
+ * The frame repair
+ */
+#define REPAIR_PAIRS 20000 ///< The number of corrupted pairs of copies fed to the repair.
+#define REPAIR_REPEAT_MS 200 ///< The time between a message and its repeat.
+
+/** Gives a copy of a message a wrong nibble.
+ * @param *copy The copy.
+ * @param index The nibble.
+ * @param &state The state of the random numbers. */
+static void corruptNibble(uint8_t *copy, uint8_t index, uint32_t &state){
+	copy[index] = (copy[index] + 1 + nextRandom(state) % 15) & 0x0F;
+}
+
+/** Hands two failed copies of a message to a frame repair, the way the sketch does.
+ * @return Whether the repeat was repaired, and then holds the repair. */
+static boolean repairPair(FrameRepair &repair, OregonScientificSensor *sensor, uint8_t *first, uint8_t *repeat, uint32_t &now){
+	now += FRAME_REPAIR_WINDOW_MS * 40;
+	if(repair.repair(sensor, first, now)){
+		return true;
+	}
+	return repair.repair(sensor, repeat, now + REPAIR_REPEAT_MS);
+}
+
+/** Feeds the repair pairs of copies of THGR122NX messages that each failed
+ * their checksum. Copies with one wrong nibble each must either be refused
+ * or repaired to the message that was sent. Copies that differ in the
+ * header of the message, or in more than FRAME_REPAIR_MAX_DIFFS nibbles,
+ * must be refused. */
+static void checkFrameRepair(){
+	char detail[160];
+	OregonScientificSensor sensor(THGR122NX, V2_CHANNEL_1, 7, OregonScientificSensor::THGR122NX_FORMAT, OregonScientificSensor::THGR122NX_TITLES);
+	uint8_t size = sensor.getMessageSize();
+	FrameRepair repair(FRAME_REPAIR_WINDOW_MS, FRAME_REPAIR_MAX_DIFFS);
+	uint32_t state = 0x2545F491;
+	uint32_t now = 0;
+	uint32_t repaired = 0;
+	uint32_t wrong = 0;
+	uint32_t headerRepaired = 0;
+	uint32_t widerRepaired = 0;
+	for(uint32_t p = 0; p < REPAIR_PAIRS; p++){
+		uint8_t sent[FRAME_REPAIR_MAX_NIBBLES];
+		oregon_thgr122nx_message(sent, V2_CHANNEL_1, (int16_t) (nextRandom(state) % 1200) - 400, nextRandom(state) % 100, false);
+		uint8_t first[FRAME_REPAIR_MAX_NIBBLES];
+		uint8_t repeat[FRAME_REPAIR_MAX_NIBBLES];
+		// The nibble after the checksum is not checked, so a copy that is wrong there passes
+		uint8_t checked = size - 1;
+		memcpy(first, sent, size);
+		memcpy(repeat, sent, size);
+		corruptNibble(first, nextRandom(state) % checked, state);
+		corruptNibble(repeat, nextRandom(state) % checked, state);
+		if(repairPair(repair, &sensor, first, repeat, now)){
+			repaired++;
+			if(memcmp(repeat, sent, size) != 0){
+				wrong++;
+			}
+		}
+		// The same, with the first copy wrong in its header
+		memcpy(first, sent, size);
+		memcpy(repeat, sent, size);
+		corruptNibble(first, nextRandom(state) % MESSAGE_BEGIN, state);
+		corruptNibble(repeat, MESSAGE_BEGIN + nextRandom(state) % (checked - MESSAGE_BEGIN), state);
+		headerRepaired += repairPair(repair, &sensor, first, repeat, now);
+		// And with the repeat wrong in one more nibble than may differ
+		memcpy(first, sent, size);
+		memcpy(repeat, sent, size);
+		uint8_t index = MESSAGE_BEGIN + nextRandom(state) % (checked - MESSAGE_BEGIN - FRAME_REPAIR_MAX_DIFFS);
+		corruptNibble(first, index, state);
+		for(uint8_t d = 1; d <= FRAME_REPAIR_MAX_DIFFS; d++){
+			corruptNibble(repeat, index + d, state);
+		}
+		widerRepaired += repairPair(repair, &sensor, first, repeat, now);
+	}
+	snprintf(detail, sizeof(detail), "%u of %u repairs of copies with one wrong nibble each were wrong", wrong, repaired);
+	check(wrong == 0 && repaired > 0, "frame repair", detail);
+	snprintf(detail, sizeof(detail), "%u copies that differ in the header were repaired", headerRepaired);
+	check(headerRepaired == 0, "frame repair", detail);
+	snprintf(detail, sizeof(detail), "%u copies that differ in %u nibbles were repaired", widerRepaired, FRAME_REPAIR_MAX_DIFFS + 1);
+	check(widerRepaired == 0, "frame repair", detail);
+}
+
+/*
+ * The gateway records
+ */
+#define GATEWAY_CHECK_RECORDS 200 ///< The number of records in the stream that the reader is checked with.
+
+/** A frame as the sketch sends it, to compare what is read back with. */
+struct SentFrame{
+	uint32_t time;
+	uint32_t sensorId;
+	uint8_t channel;
+	uint8_t protocol;
+	uint8_t flags;
+	int16_t rssi;
+	uint8_t size;
+	uint8_t nibbles[GATEWAY_MAX_NIBBLES];
+};
+
+/** What a reader handed on, compared with the frames that were sent. */
+struct ReadBack{
+	const std::vector<SentFrame> *sent;
+	std::vector<uint16_t> counts; ///< The times every sent frame was read.
+	uint32_t wrong; ///< The frames read that match none that was sent.
+};
+
+/** Checks whether a frame that was read is one that was sent, field by field. */
+static boolean sameFrame(const GatewayFrame &frame, const SentFrame &sent){
+	if(frame.time != sent.time || frame.sensorId != sent.sensorId || frame.channel != sent.channel || frame.protocol != sent.protocol
+		|| frame.flags != sent.flags || frame.rssi != sent.rssi || frame.size != sent.size){
+		return false;
+	}
+	for(uint8_t i = 0; i < sent.size; i++){
+		if(frame.nibble(i) != sent.nibbles[i]){
+			return false;
+		}
+	}
+	return true;
+}
+
+/** Notes which sent frame a frame that was read is, by its time, which is unique. */
+static void readFrame(const GatewayFrame &frame, void *context){
+	ReadBack *back = (ReadBack *) context;
+	for(size_t i = 0; i < back->sent->size(); i++){
+		if(sameFrame(frame, (*back->sent)[i])){
+			back->counts[i]++;
+			return;
+		}
+	}
+	back->wrong++;
+}
+
+/** Encodes a frame the way SerialGateway::sendFrame writes it.
+ * @param &out The stream the encoded record is appended to. */
+static void appendRecord(std::vector<uint8_t> &out, const SentFrame &frame){
+	uint8_t record[GATEWAY_MAX_RECORD];
+	uint8_t encoded[GATEWAY_MAX_ENCODED];
+	uint8_t length = SerialGateway::packFrame(frame.time, frame.sensorId, frame.channel, frame.protocol, frame.flags,
+		frame.rssi, frame.nibbles, frame.size, record);
+	size_t size = SerialGateway::cobsEncode(record, length, encoded);
+	out.insert(out.end(), encoded, encoded + size);
+}
+
+/** Parses a stream in pieces the way readAll does, moving the part of a
+ * record that a piece cut off to the front to be finished by the next.
+ * @param piece The size of the pieces, or 0 for random sizes. */
+static void parseInPieces(GatewayReader &reader, const std::vector<uint8_t> &stream, size_t piece, uint32_t &state){
+	std::vector<uint8_t> buffer;
+	for(size_t at = 0; at < stream.size(); ){
+		size_t size = piece > 0 ? piece : 1 + nextRandom(state) % (2 * GATEWAY_MAX_ENCODED);
+		size = std::min(size, stream.size() - at);
+		buffer.insert(buffer.end(), stream.begin() + at, stream.begin() + at + size);
+		at += size;
+		size_t used = reader.parse(buffer.data(), buffer.size());
+		buffer.erase(buffer.begin(), buffer.begin() + used);
+	}
+}
+
+/** Writes seeded frames of every size and extreme field as records and reads
+ * them back: whole, in pieces that cut records anywhere, with a bit flipped
+ * anywhere in a record, and with garbage inserted between and into records,
+ * after which the reader must find the next record. */
+static void checkGatewayRecords(){
+	char detail[160];
+	uint32_t state = 0x5EED0041;
+	std::vector<SentFrame> sent(GATEWAY_CHECK_RECORDS);
+	std::vector<uint8_t> stream;
+	for(size_t i = 0; i < sent.size(); i++){
+		SentFrame &frame = sent[i];
+		frame.time = i == 0 ? 0 : (i == 1 ? 0xFFFFFFFF : nextRandom(state) | 0x100);
+		frame.time = frame.time - frame.time % sent.size() + i; // unique, so that readFrame can tell them apart
+		frame.sensorId = i % 3 == 0 ? 0 : nextRandom(state);
+		frame.channel = nextRandom(state);
+		frame.protocol = i % 2 == 0 ? OSCV_2_1 : OSCV_3;
+		frame.flags = i % 4;
+		frame.rssi = i % 5 == 0 ? -128 : (i % 5 == 1 ? 127 : (int8_t) nextRandom(state));
+		frame.size = i % (GATEWAY_MAX_NIBBLES + 1);
+		for(uint8_t n = 0; n < GATEWAY_MAX_NIBBLES; n++){
+			frame.nibbles[n] = i % 7 == 0 ? 0 : nextRandom(state) & 0x0F;
+		}
+		appendRecord(stream, frame);
+	}
+
+	// Whole, and in pieces of every size up to two records and of random sizes
+	const size_t pieces[] = {0, 1, 2, 3, 7, 16, GATEWAY_MAX_ENCODED - 1, GATEWAY_MAX_ENCODED, 2 * GATEWAY_MAX_ENCODED, stream.size()};
+	for(size_t p = 0; p < sizeof(pieces) / sizeof(pieces[0]); p++){
+		ReadBack back = {&sent, std::vector<uint16_t>(sent.size(), 0), 0};
+		GatewayReader reader(readFrame, &back);
+		parseInPieces(reader, stream, pieces[p], state);
+		boolean once = std::count(back.counts.begin(), back.counts.end(), 1) == (long) sent.size();
+		snprintf(detail, sizeof(detail), "in pieces of %u bytes %llu of %u frames were read, %u wrong, %llu bad records",
+			(unsigned) pieces[p], (unsigned long long) reader.getFrames(), (unsigned) sent.size(), back.wrong,
+			(unsigned long long) reader.getBadRecords());
+		check(once && back.wrong == 0 && reader.getBadRecords() == 0 && reader.getSkippedBytes() == 0, "gateway records", detail);
+	}
+
+	// Every bit of a record flipped in turn, between two good records
+	std::vector<SentFrame> three(sent.begin() + 30, sent.begin() + 33);
+	std::vector<uint8_t> good;
+	appendRecord(good, three[0]);
+	size_t first = good.size();
+	appendRecord(good, three[1]);
+	size_t last = good.size();
+	appendRecord(good, three[2]);
+	uint32_t misses = 0;
+	for(size_t byte = first; byte < last; byte++){
+		for(uint8_t bit = 0; bit < 8; bit++){
+			std::vector<uint8_t> flipped(good);
+			flipped[byte] ^= 1 << bit;
+			ReadBack back = {&three, std::vector<uint16_t>(three.size(), 0), 0};
+			GatewayReader reader(readFrame, &back);
+			parseInPieces(reader, flipped, flipped.size(), state);
+			// A flipped zero joins the record to the next, which is lost with it
+			boolean joined = byte == last - 1;
+			boolean passed = back.wrong == 0 && back.counts[0] == 1 && back.counts[1] == 0
+				&& back.counts[2] == (joined ? 0 : 1) && reader.getBadRecords() >= 1;
+			if(!passed && misses++ == 0){
+				snprintf(detail, sizeof(detail), "bit %u of byte %u flipped: read %u %u %u, %u wrong, %llu bad records", bit,
+					(unsigned) (byte - first), back.counts[0], back.counts[1], back.counts[2], back.wrong,
+					(unsigned long long) reader.getBadRecords());
+			}
+		}
+	}
+	check(misses == 0, "gateway records", misses == 0 ? "" : detail);
+
+	// Garbage between records, at the start, and into the middle of records,
+	// and a run longer than any record, read in random pieces
+	std::vector<uint8_t> noisy;
+	std::vector<boolean> damaged(sent.size(), false);
+	const char *garbage = "\r\nWildFire boot\r\n";
+	noisy.insert(noisy.end(), garbage, garbage + strlen(garbage));
+	noisy.push_back(0);
+	for(size_t i = 0; i < sent.size(); i++){
+		std::vector<uint8_t> record;
+		appendRecord(record, sent[i]);
+		switch(nextRandom(state) % 8){
+		case 0:
+			// Garbage ended by a zero, which the reader counts as a bad record
+			for(uint32_t n = 1 + nextRandom(state) % 40; n > 0; n--){
+				noisy.push_back(nextRandom(state) % 255 + 1);
+			}
+			noisy.push_back(0);
+			break;
+		case 1:
+			// Garbage within the record, which loses it
+			record.insert(record.begin() + nextRandom(state) % (record.size() - 1), 1 + nextRandom(state) % 16, 0x55);
+			damaged[i] = true;
+			break;
+		case 2:
+			// A run without a zero longer than any record, which is skipped up to the next zero
+			for(uint32_t n = 2 * GATEWAY_MAX_ENCODED; n > 0; n--){
+				noisy.push_back(nextRandom(state) % 255 + 1);
+			}
+			damaged[i] = true;
+			break;
+		}
+		noisy.insert(noisy.end(), record.begin(), record.end());
+	}
+	ReadBack back = {&sent, std::vector<uint16_t>(sent.size(), 0), 0};
+	GatewayReader reader(readFrame, &back);
+	parseInPieces(reader, noisy, 0, state);
+	uint32_t read = 0;
+	uint32_t expected = 0;
+	boolean passed = back.wrong == 0;
+	for(size_t i = 0; i < sent.size(); i++){
+		read += back.counts[i];
+		expected += !damaged[i];
+		passed = passed && back.counts[i] == (damaged[i] ? 0 : 1);
+	}
+	snprintf(detail, sizeof(detail), "with garbage %u frames were read of %u undamaged, %u wrong, %llu bad records, %llu bytes skipped",
+		read, expected, back.wrong, (unsigned long long) reader.getBadRecords(), (unsigned long long) reader.getSkippedBytes());
+	check(passed && reader.getBadRecords() > 0 && reader.getSkippedBytes() > 0, "gateway records", detail);
+}
+
+/*
+ * The RFM69
+ */
+#define RADIO_INTERRUPT 1 ///< The interrupt whose pin DIO2 drives, as in the sketch.
+#define RADIO_LEAD_US 20000 ///< The time left for begin before the air is scheduled.
+
+/** A level of the air and how long it holds. */
+struct AirLevel{
+	double dBm; ///< The level.
+	uint32_t us; ///< How long it holds in microseconds.
+};
+
+/** Carriers above the RSSI threshold, with noise and weak sensors between them that
+ * are above the floor of the slicer but below the threshold. */
+static const AirLevel AIR_LEVELS[] = {
+	{-110, 2000}, {-100, 3000}, {-60, 500}, {-100, 1500}, {RFM69_RSSI_THRESHOLD_DBM - 1, 1000}, {-110, 5000},
+	{-70, 1000}, {-100, 500}, {-98, 5000}, {-60, 500}, {-110, 1000}, {RFM69_RSSI_THRESHOLD_DBM - 0.5, 8000}, {-110, 1000},
+};
+
+static uint64_t dio2Edges[16]; ///< The times of the edges of DIO2, which is low when receive is entered.
+static uint8_t dio2EdgeCount = 0; ///< The number of edges of DIO2.
+
+/** Notes the time of an edge of DIO2. */
+static void dio2Edge(){
+	if(dio2EdgeCount < sizeof(dio2Edges) / sizeof(dio2Edges[0])){
+		dio2Edges[dio2EdgeCount] = hostsim_time_us();
+	}
+	dio2EdgeCount++;
+}
+
+/** Runs begin against the mock with the settings of the sketch, which must
+ * configure it the way rfm69_mock_check_config expects, then checks that
+ * DIO2 only goes high for the carriers above the RSSI threshold. */
+static void checkRadio(){
+	char detail[128];
+	uint64_t at = hostsim_time_us() + RADIO_LEAD_US;
+	rfm69_mock_attach(RFM69_SS_PIN, RADIO_INTERRUPT);
+	rfm69_mock_rf(0, -110);
+	uint64_t starts[sizeof(AIR_LEVELS) / sizeof(AIR_LEVELS[0])];
+	uint8_t carriers = 0;
+	for(size_t i = 0; i < sizeof(AIR_LEVELS) / sizeof(AIR_LEVELS[0]); i++){
+		starts[i] = at;
+		rfm69_mock_rf(at, AIR_LEVELS[i].dBm);
+		at += AIR_LEVELS[i].us;
+		carriers += AIR_LEVELS[i].dBm >= RFM69_RSSI_THRESHOLD_DBM;
+	}
+	RFM69OOK receiver(RFM69_SS_PIN);
+	boolean began = receiver.begin(RFM69_FREQUENCY_HZ, RFM69_RSSI_THRESHOLD_DBM, RFM69_OOK_FLOOR_DB);
+	const char *error = rfm69_mock_check_config();
+	snprintf(detail, sizeof(detail), "begin returned %d and the configuration was %s", began, error == NULL ? "right" : error);
+	check(began && error == NULL && starts[0] > hostsim_time_us(), "RFM69", detail);
+
+	attachInterrupt(RADIO_INTERRUPT, dio2Edge, CHANGE);
+	hostsim_advance(starts[2] + AIR_LEVELS[2].us / 2 - hostsim_time_us());
+	int16_t rssi = receiver.readRssi();
+	hostsim_advance(at - hostsim_time_us());
+	detachInterrupt(RADIO_INTERRUPT);
+	// DIO2 is high from the start of each carrier above the threshold to its end, and low otherwise
+	uint8_t matched = 0;
+	for(uint8_t e = 0; e + 1 < dio2EdgeCount && e + 1 < sizeof(dio2Edges) / sizeof(dio2Edges[0]); e += 2){
+		for(size_t i = 0; i < sizeof(AIR_LEVELS) / sizeof(AIR_LEVELS[0]); i++){
+			matched += AIR_LEVELS[i].dBm >= RFM69_RSSI_THRESHOLD_DBM && dio2Edges[e] == starts[i]
+				&& dio2Edges[e + 1] == starts[i] + AIR_LEVELS[i].us;
+		}
+	}
+	snprintf(detail, sizeof(detail), "DIO2 had %u edges for %u carriers above the threshold, %u high for just a carrier",
+		dio2EdgeCount, carriers, matched);
+	check(dio2EdgeCount == 2 * carriers && matched == carriers, "RFM69", detail);
+	snprintf(detail, sizeof(detail), "the RSSI of a carrier of %.0f dBm was read as %d", AIR_LEVELS[2].dBm, rssi);
+	check(rssi == (int16_t) AIR_LEVELS[2].dBm, "RFM69", detail);
+}
+
+/*
+ * The sensor configuration
+ */
+/** Hex that must be refused, and why. */
+static const char * const BAD_SENSOR_HEX[][2] = {
+	{"", "no record"},
+	{" 0104050000", "no record before the space"},
+	{"010405000", "an odd number of digits"},
+	{"01040500", "part of a record"},
+	{"0304050000", "an unknown model"},
+	{"0104050000020600000001040500000206000000010405000", "more than four records"},
+	{"01040500000206000000010405000002060000000104050000", "more than four records"},
+};
+
+/** Parses and writes sensor configurations, and keeps them in the EEPROM
+ * of the host and reads them back the way the sketch does. */
+static void checkSensorConfig(){
+	char detail[160];
+	SensorConfig config;
+	boolean passed = config.parseHex("0104050000 end") && config.getCount() == 1 && config.getRecords()[0].model == SENSOR_MODEL_THGR122NX
+		&& config.getRecords()[0].channel == 0x04 && config.getRecords()[0].tempDeadband == 5 && config.checksum() == 0xF4;
+	check(passed, "sensor config", "one record stopped by a space did not parse to THGR122NX channel 4, deadband 5, checksum F4");
+	for(size_t i = 0; i < sizeof(BAD_SENSOR_HEX) / sizeof(BAD_SENSOR_HEX[0]); i++){
+		snprintf(detail, sizeof(detail), "\"%s\" with %s was parsed, or changed the configuration", BAD_SENSOR_HEX[i][0], BAD_SENSOR_HEX[i][1]);
+		check(!config.parseHex(BAD_SENSOR_HEX[i][0]) && config.getCount() == 1, "sensor config", detail);
+	}
+	const char *full = "0104050a000242000000013033781e02ff0a0bFF";
+	char hex[SENSOR_CONFIG_HEX_SIZE];
+	SensorConfig parsed;
+	passed = config.parseHex(full) && config.getCount() == SENSOR_CONFIG_MAX_RECORDS;
+	config.toHex(hex);
+	passed = passed && strcasecmp(hex, full) == 0 && parsed.parseHex(hex) && parsed.equals(config);
+	snprintf(detail, sizeof(detail), "\"%s\" was written back as \"%s\"", full, hex);
+	check(passed, "sensor config", detail);
+
+	// The EEPROM of the sketch, saved and loaded
+	SensorConfig loaded;
+	saveSensorConfig(config);
+	check(loadSensorConfig(loaded) && loaded.equals(config), "sensor config", "four records were not loaded as they were saved");
+	config.parseHex("0206000000");
+	saveSensorConfig(config);
+	check(loadSensorConfig(loaded) && loaded.equals(config), "sensor config", "a shorter configuration was not loaded as it was saved");
+	uint8_t *stored = (uint8_t *) (E2END + 1 - (3 + SENSOR_CONFIG_MAX_RECORDS * SENSOR_CONFIG_RECORD_SIZE));
+	eeprom_write_byte(stored + 2, SENSOR_MODEL_THGR122NX);
+	check(!loadSensorConfig(loaded) && loaded.equals(config), "sensor config", "a record that does not match its checksum was loaded");
+	saveSensorConfig(config);
+	eeprom_write_byte(stored, 0);
+	check(!loadSensorConfig(loaded), "sensor config", "a configuration without its magic number was loaded");
+	SensorConfig empty;
+	saveSensorConfig(empty);
+	check(!loadSensorConfig(loaded), "sensor config", "a configuration without records was loaded");
+
+	// Pushed in the reply to the building query with keys whose end marker
+	// space decrypts to a hex digit and to a character that is not one
+	const char *keys[] = {"fffff", "zzzzz", "a1"};
+	for(size_t k = 0; k < sizeof(keys) / sizeof(keys[0]); k++){
+		char key[32];
+		char pushed[SENSOR_CONFIG_HEX_SIZE];
+		char reply[96];
+		// Each push has a different silence, since the sketch keeps only a configuration that differs from its own
+		snprintf(pushed, sizeof(pushed), "01040500%02X", (unsigned) k + 1);
+		snprintf(reply, sizeof(reply), "1792405863 building 1 cutoff 0 sensors %s", pushed);
+		strcpy(key, keys[k]);
+		setEncryptionKey(key);
+		encrypt(reply, key, reply);
+		strcat(reply, " ");
+		int building = parseBuildingReply(reply);
+		config.parseHex(pushed);
+		snprintf(detail, sizeof(detail), "a configuration pushed with the key %s was not kept, building %d", keys[k], building);
+		check(building == 1 && loadSensorConfig(loaded) && loaded.equals(config), "sensor config", detail);
+	}
+}
+
+/*
+ * The LCD
+ */
+/** Runs the main loop's flush of the LCD every 10 ms until a row shows a text.
+ * @param row The row to watch.
+ * @param *text The text, which is padded with spaces to the width of the LCD.
+ * @param limit_ms How long to wait for it (in milliseconds).
+ * @return The time it took (in milliseconds), or limit_ms if it never showed. */
+static uint32_t flushUntilShown(uint8_t row, const char *text, uint32_t limit_ms){
+	char padded[LCD_COLS + 1];
+	snprintf(padded, sizeof(padded), "%-*s", LCD_COLS, text);
+	uint32_t start = millis();
+	while(millis() - start < limit_ms){
+		lcd_flush(false);
+		if(strcmp(lcd.getRow(row), padded) == 0){
+			return millis() - start;
+		}
+		hostsim_advance(10 * 1000ULL);
+	}
+	return limit_ms;
+}
+
+/** Shows statuses the way the main loop does, and checks that each one
+ * that replaces the screen is shown for LCD_MIN_STATUS_MS, that a burst of
+ * them keeps the oldest and the newest, and that a change to the status on
+ * the screen is not held back. */
+static void checkLCD(){
+	char detail[128];
+	char text[LCD_COLS + 1];
+	lcd_begin();
+	strcpy(text, "Listening 492Mhz");
+	lcd_print_top(text);
+	lcd_set_immediate(false);
+	hostsim_advance(LCD_MIN_STATUS_MS * 1000ULL);
+
+	// "Querying Server" then "Activated" a pass later
+	strcpy(text, "Querying Server");
+	lcd_print_top(text);
+	flushUntilShown(0, text, LCD_FLUSH_INTERVAL_MS);
+	uint32_t shown = millis();
+	hostsim_advance((LCD_FLUSH_INTERVAL_MS + 10) * 1000ULL);
+	strcpy(text, "Activated");
+	lcd_print_top(text);
+	uint32_t waited = flushUntilShown(0, text, 2 * LCD_MIN_STATUS_MS) + (uint32_t) (LCD_FLUSH_INTERVAL_MS + 10);
+	snprintf(detail, sizeof(detail), "\"Querying Server\" was replaced after %lu ms", (unsigned long) (millis() - shown));
+	check(millis() - shown >= LCD_MIN_STATUS_MS && millis() - shown < LCD_MIN_STATUS_MS + 20 && waited < 2 * LCD_MIN_STATUS_MS, "LCD", detail);
+
+	// A change to the status on the screen is flushed at the next interval
+	hostsim_advance(LCD_FLUSH_INTERVAL_MS * 1000ULL);
+	strcpy(text, "Got Message");
+	lcd_print_bottom(text);
+	waited = flushUntilShown(1, text, LCD_MIN_STATUS_MS);
+	snprintf(detail, sizeof(detail), "a change to the bottom row waited %lu ms", (unsigned long) waited);
+	check(waited == 0, "LCD", detail);
+
+	// A burst in one pass: the pending statuses, then the newest in place of the one past the queue
+	hostsim_advance(LCD_MIN_STATUS_MS * 1000ULL);
+	for(uint8_t i = 0; i < LCD_STATUS_QUEUE + 2; i++){
+		snprintf(text, sizeof(text), "Status %u", i);
+		lcd_print_top(text);
+	}
+	uint8_t seen = 0;
+	for(uint8_t i = 0; i < LCD_STATUS_QUEUE + 2; i++){
+		if(i == LCD_STATUS_QUEUE){
+			continue;
+		}
+		snprintf(text, sizeof(text), "Status %u", i);
+		waited = flushUntilShown(0, text, 2 * LCD_MIN_STATUS_MS);
+		seen += waited < 2 * LCD_MIN_STATUS_MS && (i == 0 || waited >= LCD_MIN_STATUS_MS - 10);
+	}
+	snprintf(detail, sizeof(detail), "%u of %u statuses of a burst were shown in order for their time", seen, LCD_STATUS_QUEUE + 1);
+	check(seen == LCD_STATUS_QUEUE + 1, "LCD", detail);
+}
+
+int main(){
+	// The EEPROM of the host is a scratch file, so that a run of the sketch is left as it was
+	char eeprom[] = "/tmp/hostcheck_eeprom_XXXXXX";
+	int fd = mkstemp(eeprom);
+	if(fd >= 0){
+		close(fd);
+		unlink(eeprom);
+	}
+	setenv("HOSTSIM_EEPROM", eeprom, 1);
+	// Only the failures are printed
+	hostsim_set_serial_enabled(false);
+	checkPolledReplies();
+	checkBuildingQuery();
+	checkAggregator();
+	checkReportingPolicy();
+	checkFrameRepair();
+	checkSensorConfig();
+	checkRadio();
+	checkGatewayRecords();
+	checkLCD();
+	unlink(eeprom);
+	fprintf(stderr, "hostcheck: %u checks, %u failed\n", checks, failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,273 @@
+// File: main.cpp
+// Description: Runs the sketch on Linux against scheduled radio pulses and
+// the mock server, then reports how the run went.
+
+#include <Arduino.h>
+#include <HostSim.h>
+#include <MockServer.h>
+#include <OregonEncoder.h>
+#include <OregonScientific.h>
+#include <ManchesterDecoder.h>
+#include <LiquidCrystal.h>
+#include <TinyWatchdog.h>
+#include <LatencyTrace.h>
+#include <MemoryMonitor.h>
+#include <RFM69Mock.h>
+#include <getopt.h>
+#include <sys/time.h>
+#include "header.h"
+
+#define FRAME_LEAD_IN_US 10000 ///< The quiet time before each frame, which resets the decoder.
+#define DEFAULT_START_MS 10000 ///< The time of the first frame, after setup has finished.
+#define DEFAULT_FRAME_INTERVAL_MS 39000 ///< The time between frames of a THGR122NX.
+#define DEFAULT_DURATION_MS 900000 ///< The length of the simulation when no duration is given.
+#define DEFAULT_JITTER_US 40 ///< The random error of every generated pulse.
+#define NOISE_MIN_US 10 ///< The shortest pulse of the noise between frames.
+#define NOISE_MAX_US 1500 ///< The longest pulse of the noise between frames.
+#define RF_SIGNAL_DBM -75 ///< The mean level of the carrier of a generated sensor (in dBm).
+#define RF_SIGNAL_SPREAD_DB 5 ///< The most the carrier of a frame is off its mean (in dB).
+#define RF_NOISE_DBM -110.0 ///< The mean level of the noise of the band (in dBm).
+#define RF_NOISE_SD_DB 3.5 ///< The standard deviation of the noise of the band (in dB).
+#define RF_QUIET_DBM -120.0 ///< The level of the air when there is no noise, below the sensitivity of the RFM69 (in dBm).
+
+// The sketch
+void setup();
+void loop();
+boolean validEncryptionKey();
+void setEncryptionKey(char *key);
+void getEncryptionKey(char *buffer);
+extern LiquidCrystal lcd;
+extern TinyWatchdog tinyWDT;
+extern ManchesterDecoder md;
+
+static struct timeval started;
+static uint32_t frames = 0;
+static uint32_t pulse_files = 0;
+static boolean rf = false;
+
+/** Prints to stderr so the report stays apart from the Serial output of the sketch. */
+class ErrorPrint : public Print
+{
+public:
+	size_t write(uint8_t c){ return fputc(c, stderr) == EOF ? 0 : 1; }
+	using Print::write;
+};
+
+static void usage(const char *name){
+	fprintf(stderr,
+		"usage: %s [options] [pulse-file ...]\n"
+		"  -n frames     generate this many THGR122NX frames on channel 1\n"
+		"  -i ms         time between generated frames (default %d)\n"
+		"  -j us         random error of every generated pulse (default %d)\n"
+		"  -N            fill the time between generated frames with receiver noise\n"
+		"  -R            receive the generated frames through the RFM69 mock as RF levels\n"
+		"  -t ms         time of the first frame or pulse file (default %d)\n"
+		"  -d ms         length of the simulation (default %d)\n"
+		"  -k key        encryption key, stored in the EEPROM file\n"
+		"  -b id         building id returned by the mock server (default 1)\n"
+		"  -S hex        sensor configuration pushed by the mock server, as in SensorConfig.h\n"
+		"  -s seed       seed of the random numbers (default 1)\n"
+		"  -x            use the server at HOSTSIM_HOST instead of the mock server\n"
+		"  -q            do not print the Serial output of the sketch\n"
+		"  -v            print every upload received by the mock server\n"
+		"Pulse files hold one pulse width in microseconds per line.\n",
+		name, DEFAULT_FRAME_INTERVAL_MS, DEFAULT_JITTER_US, DEFAULT_START_MS, DEFAULT_DURATION_MS);
+	exit(2);
+}
+
+static void report(){
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	double real = (now.tv_sec - started.tv_sec) + (now.tv_usec - started.tv_usec) / 1e6;
+	double simulated = hostsim_time_us() / 1e6;
+	fprintf(stderr, "hostsim: simulated %.3f s in %.3f s (%.0fx real time)\n", simulated, real, real > 0 ? simulated / real : 0.0);
+	fprintf(stderr, "hostsim: %llu edges from %u generated frames and %u pulse files\n",
+		(unsigned long long) hostsim_edges_fired(), frames, pulse_files);
+	fprintf(stderr, "hostsim: server answered %u building queries and %u uploads (%u malformed)\n",
+		mock_server_queries(), mock_server_uploads(), mock_server_bad_uploads());
+	uint32_t gated = md.getGatedPulses();
+	uint32_t decoded = md.getDecodedPulses();
+	if(rf){
+		const char *error = rfm69_mock_check_config();
+		fprintf(stderr, "hostsim: RFM69 configuration %s, DIO2 put out %llu edges, RSSI read %u times\n",
+			error == NULL ? "right" : error, (unsigned long long) rfm69_mock_edges(), rfm69_mock_rssi_reads());
+	}
+	fprintf(stderr, "hostsim: preamble gate kept %lu pulses from the decoder and passed %lu", (unsigned long) gated, (unsigned long) decoded);
+	if(decoded > 0){
+		fprintf(stderr, " (%.1f gated per decoded)", (double) gated / decoded);
+	}
+	fprintf(stderr, "\n");
+	fprintf(stderr, "hostsim: pulse buffer of %u %s dropped %lu pulses\n", QUANTIZED_PULSES ? DECODER_PULSE_SYMBOLS : DECODER_BUFFER_SIZE,
+		QUANTIZED_PULSES ? "bytes" : "words", (unsigned long) md.getDroppedPulses());
+	fprintf(stderr, "hostsim: stack used %lu bytes, heap top rose %lu bytes, %lu bytes of paint untouched\n",
+		(unsigned long) MemoryMonitor::getStackUsed(), (unsigned long) MemoryMonitor::getHeapPeak(), (unsigned long) MemoryMonitor::getUntouched());
+	fprintf(stderr, "hostsim: LCD bus writes %lu, clears %lu\n", lcd.busWrites, lcd.clears);
+	tinyWDT.noteGap();
+	fprintf(stderr, "hostsim: watchdog pets %lu, longest gap %llu ms%s\n", tinyWDT.pets,
+		(unsigned long long) tinyWDT.longestGap, tinyWDT.wouldHaveBitten() ? " (the watchdog would have reset the device)" : "");
+#ifdef LATENCY_TRACE
+	ErrorPrint err;
+	LatencyTrace::print(err);
+#endif
+	// A run whose receiver was configured wrongly fails, rather than only saying so
+	if(rf && rfm69_mock_check_config() != NULL){
+		fflush(stdout);
+		exit(1);
+	}
+}
+
+// Schedules the random pulses a receiver puts out when there is no signal, from one edge to the next
+static void scheduleNoise(uint64_t from, uint64_t to){
+	uint64_t at = from;
+	for(;;){
+		at += NOISE_MIN_US + rand() % (NOISE_MAX_US - NOISE_MIN_US);
+		if(at >= to){
+			return;
+		}
+		hostsim_schedule_edge(1, at);
+	}
+}
+
+// Gives the level of the noise of the band, nearly normal as the sum of twelve uniform numbers
+static double noiseLevel(){
+	double sum = 0;
+	for(uint8_t i = 0; i < 12; i++){
+		sum += rand() / (double) RAND_MAX;
+	}
+	return RF_NOISE_DBM + (sum - 6) * RF_NOISE_SD_DB;
+}
+
+// Schedules the level of the air between frames, changing as often as the noise pulses of a receiver
+static void scheduleAirNoise(uint64_t from, uint64_t to, boolean noise){
+	if(!noise){
+		rfm69_mock_rf(from, RF_QUIET_DBM);
+		return;
+	}
+	for(uint64_t at = from; at < to; at += NOISE_MIN_US + rand() % (NOISE_MAX_US - NOISE_MIN_US)){
+		rfm69_mock_rf(at, noiseLevel());
+	}
+}
+
+// Schedules the carrier of a frame as RF levels, on for the first pulse and off for the next
+static uint64_t scheduleAirPulses(const uint32_t *widths, size_t count, uint64_t at, boolean noise){
+	double carrier = RF_SIGNAL_DBM + (rand() % (2 * RF_SIGNAL_SPREAD_DB + 1)) - RF_SIGNAL_SPREAD_DB;
+	for(size_t i = 0; i < count; i++){
+		rfm69_mock_rf(at, i % 2 == 0 ? carrier : (noise ? noiseLevel() : RF_QUIET_DBM));
+		at += widths[i];
+	}
+	return at;
+}
+
+// Schedules frames of a THGR122NX whose temperature drifts slowly
+static uint64_t scheduleFrames(uint32_t count, uint64_t start, uint32_t interval_ms, uint16_t jitter, boolean noise){
+	uint8_t nibbles[18];
+	uint32_t widths[OREGON_MAX_PULSES + 1];
+	int16_t tenths = 215;
+	uint64_t at = start;
+	for(uint32_t i = 0; i < count; i++){
+		tenths += (rand() % 7) - 3;
+		oregon_thgr122nx_message(nibbles, V2_CHANNEL_1, tenths, 45 + (rand() % 3), false);
+		widths[0] = FRAME_LEAD_IN_US;
+		size_t n = oregon_encode(OSCV_2_1, nibbles, sizeof(nibbles), widths + 1, OREGON_MAX_PULSES, jitter);
+		if(rf){
+			uint64_t end = scheduleAirPulses(widths + 1, n, at + widths[0], noise);
+			at += (uint64_t) interval_ms * 1000;
+			scheduleAirNoise(end, at + FRAME_LEAD_IN_US, noise);
+			continue;
+		}
+		uint64_t end = hostsim_schedule_pulses(1, widths, n + 1, at);
+		at += (uint64_t) interval_ms * 1000;
+		if(noise){
+			scheduleNoise(end, at);
+		}
+	}
+	return at;
+}
+
+int main(int argc, char **argv){
+	uint32_t count = 0;
+	uint32_t interval_ms = DEFAULT_FRAME_INTERVAL_MS;
+	uint16_t jitter = DEFAULT_JITTER_US;
+	uint64_t start_ms = DEFAULT_START_MS;
+	uint64_t duration_ms = DEFAULT_DURATION_MS;
+	const char *key = NULL;
+	int building = 1;
+	const char *sensors = NULL;
+	boolean external = false;
+	boolean noise = false;
+	int opt;
+	srand(1);
+	while((opt = getopt(argc, argv, "n:i:j:NRt:d:k:b:S:s:xqvh")) != -1){
+		switch(opt){
+		case 'n': count = strtoul(optarg, NULL, 10); break;
+		case 'i': interval_ms = strtoul(optarg, NULL, 10); break;
+		case 'j': jitter = strtoul(optarg, NULL, 10); break;
+		case 'N': noise = true; break;
+		case 'R': rf = true; break;
+		case 't': start_ms = strtoull(optarg, NULL, 10); break;
+		case 'd': duration_ms = strtoull(optarg, NULL, 10); break;
+		case 'k': key = optarg; break;
+		case 'b': building = atoi(optarg); break;
+		case 'S': sensors = optarg; break;
+		case 's': srand(strtoul(optarg, NULL, 10)); break;
+		case 'x': external = true; break;
+		case 'q': hostsim_set_serial_enabled(false); break;
+		case 'v': mock_server_set_verbose(true); break;
+		default: usage(argv[0]);
+		}
+	}
+
+	// The key is kept in the EEPROM file between runs
+	char stored[33] = "HostSimKey";
+	if(key != NULL){
+		strncpy(stored, key, 32);
+		setEncryptionKey(stored);
+	}else if(!validEncryptionKey()){
+		setEncryptionKey(stored);
+	}
+	getEncryptionKey(stored);
+
+	if(!external){
+		const char *env = getenv("HOSTSIM_PORT");
+		uint16_t port = env != NULL ? atoi(env) : LISTEN_PORT;
+		if(sensors != NULL){
+			mock_server_set_sensors(sensors);
+		}
+		if(!mock_server_start(port, stored, building)){
+			fprintf(stderr, "hostsim: the mock server could not listen on port %u\n", port);
+			return 1;
+		}
+	}
+
+	uint64_t at = start_ms * 1000;
+	if(rf){
+		if(optind < argc){
+			fprintf(stderr, "hostsim: pulse files cannot be received through the RFM69 mock\n");
+			return 1;
+		}
+		rfm69_mock_attach(RFM69_SS_PIN, 1);
+		scheduleAirNoise(0, at + FRAME_LEAD_IN_US, noise);
+	}
+	for(int i = optind; i < argc; i++){
+		uint64_t last = hostsim_schedule_pulse_file(1, argv[i], at);
+		if(last == 0){
+			fprintf(stderr, "hostsim: could not read %s\n", argv[i]);
+			return 1;
+		}
+		pulse_files++;
+		at = last + FRAME_LEAD_IN_US;
+	}
+	if(noise && count > 0 && !rf){
+		scheduleNoise(0, at);
+	}
+	scheduleFrames(count, at, interval_ms, jitter, noise);
+	frames = count;
+
+	gettimeofday(&started, NULL);
+	hostsim_set_end_us(duration_ms * 1000);
+	hostsim_on_end(report);
+	setup();
+	while(1){
+		loop();
+	}
+}
@@ -0,0 +1,640 @@
+// File: multigateway.cpp
+// Description: Decodes the pulse streams of several receivers at once, one
+// thread each, and merges the copies of a frame that more than one heard.
+
+#include <Arduino.h>
+#include <FrameDedupe.h>
+#include <FrameQueue.h>
+#include <OregonEncoder.h>
+#include <PulseDecoder.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <mutex>
+#include <termios.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#define QUEUE_SLOTS 4096 ///< The number of frames the queue between the receivers and the dedupe holds.
+#define READ_SIZE 65536 ///< The size of the reads from a source, after which the time of the receiver is published.
+#define DEFAULT_WINDOW_MS 500 ///< The default window in which copies of a frame are merged.
+#define DEFAULT_BAUD 115200 ///< The default baud rate of a serial source.
+#define BENCH_FRAMES 2000 ///< The number of messages each simulated receiver is sent.
+#define BENCH_RECEIVERS 16 ///< The most simulated receivers.
+#define BENCH_ERROR_RATE 0.002 ///< The chance that a bit of a message is flipped at a simulated receiver.
+#define BENCH_MISS_RATE 0.1 ///< The chance that a simulated receiver does not hear a message at all.
+#define BENCH_SPACING_US 500000 ///< The shortest time between the starts of two messages.
+#define NOISE_PULSES 60 ///< The most noise pulses between messages.
+#define REPEAT_GAP_US 10000 ///< The gap between the two copies of a version 2.1 message.
+#define REPAIR_WINDOW_MS 1000 ///< The repair window, FRAME_REPAIR_WINDOW_MS in header.h.
+#define REPAIR_MAX_DIFFS 2 ///< The most differing nibbles of a repair, FRAME_REPAIR_MAX_DIFFS in header.h.
+#define IDLE_SPINS 100 ///< The passes the merge yields with nothing to do before it sleeps, which is cheaper than waking when the receivers are busy.
+#define IDLE_WAIT_MS 10 ///< The longest the merge sleeps with nothing to do, so that windows on the clock of the host still close.
+#define LATENCY_SUB_BUCKETS 8 ///< The buckets of a latency histogram for every doubling, which keeps a percentile within 1/16 of the latency.
+#define LATENCY_BUCKETS (30 * LATENCY_SUB_BUCKETS) ///< The buckets of a latency histogram, enough for every 32 bit latency.
+
+/*
+ * A source is text with one pulse width in microseconds per line, as
+ * written by ookdemod -p, from a file, a pipe, or a serial device.
+ */
+
+static uint64_t nanoseconds(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/** Reads the width on the line at p.
+ * @param *width Set to the width, saturating at 32 bits.
+ * @param *valid Set to whether the line held a number.
+ * @return The start of the next line. */
+static const char *readWidth(const char *p, const char *end, uint32_t *width, boolean *valid){
+	while(p < end && (*p == ' ' || *p == '\t')){
+		p++;
+	}
+	uint64_t value = 0;
+	const char *digits = p;
+	while(p < end && *p >= '0' && *p <= '9'){
+		value = value * 10 + (*p - '0');
+		if(value > 0xFFFFFFFFull){
+			value = 0xFFFFFFFFull;
+		}
+		p++;
+	}
+	*valid = p > digits;
+	*width = (uint32_t) value;
+	while(p < end && *p != '\n'){
+		p++;
+	}
+	return p < end ? p + 1 : end;
+}
+
+/*
+ * The latencies
+ */
+/** A histogram of latencies in nanoseconds, whose buckets widen with
+ * the latency so that a fixed number of them covers every latency. */
+struct LatencyHistogram{
+	uint64_t counts[LATENCY_BUCKETS];
+	uint64_t total;
+};
+
+/** Adds a latency to a histogram.
+ * @param ns The latency in nanoseconds, saturating at 32 bits. */
+static void addLatency(LatencyHistogram &histogram, uint64_t ns){
+	uint32_t value = (uint32_t) std::min<uint64_t>(ns, UINT32_MAX);
+	size_t bucket = value;
+	if(value >= LATENCY_SUB_BUCKETS){
+		// The top bit picks the doubling, and the three bits below it the bucket within it
+		unsigned top = 31 - __builtin_clz(value);
+		bucket = (top - 2) * LATENCY_SUB_BUCKETS + ((value >> (top - 3)) & (LATENCY_SUB_BUCKETS - 1));
+	}
+	histogram.counts[bucket]++;
+	histogram.total++;
+}
+
+/** Gets a percentile of the latencies in a histogram.
+ * @return The middle of the bucket that holds it, in microseconds. */
+static double percentile(const LatencyHistogram &histogram, double fraction){
+	if(histogram.total == 0){
+		return 0;
+	}
+	uint64_t rank = (uint64_t) (fraction * (histogram.total - 1));
+	size_t bucket = 0;
+	for(uint64_t seen = histogram.counts[0]; seen <= rank; seen += histogram.counts[++bucket]){
+	}
+	if(bucket < LATENCY_SUB_BUCKETS){
+		return bucket / 1e3;
+	}
+	unsigned top = bucket / LATENCY_SUB_BUCKETS + 2;
+	double low = (double) ((LATENCY_SUB_BUCKETS + bucket % LATENCY_SUB_BUCKETS) << (top - 3));
+	return (low + (1u << (top - 3)) / 2.0) / 1e3;
+}
+
+/*
+ * The receivers
+ */
+/** Wakes the merge when a receiver has queued a frame or moved its time on.
+ * A receiver counts the event and then looks whether the merge sleeps, and
+ * the merge says it sleeps and then looks whether the count moved, so that
+ * with both in sequential order one of them always sees the other. */
+struct Wakeup{
+	std::mutex lock;
+	std::condition_variable ready;
+	std::atomic<uint64_t> events;
+	std::atomic<boolean> sleeping;
+	uint64_t sleeps; ///< The times the merge slept.
+};
+
+/** Counts an event and wakes the merge if it sleeps. */
+static void wake(Wakeup *wakeup){
+	wakeup->events.fetch_add(1);
+	if(wakeup->sleeping.load()){
+		std::lock_guard<std::mutex> hold(wakeup->lock);
+		wakeup->ready.notify_one();
+	}
+}
+
+/** A receiver and the thread that decodes its stream. */
+struct Receiver{
+	uint8_t index;
+	const char *path; ///< The source, or NULL for a stream in memory.
+	int fd;
+	const char *data; ///< The stream in memory.
+	size_t size;
+	PulseDecoder *decoder;
+	FrameQueue *queue;
+	Wakeup *wakeup;
+	std::atomic<uint64_t> time_us; ///< The time of the receiver up to which its frames are queued.
+	std::atomic<boolean> done;
+	uint64_t frames;
+	uint64_t fullWaits; ///< The times a frame waited for room in the queue.
+	boolean failed;
+};
+
+// Queues a frame with the time of its last pulse, waiting while the dedupe catches up
+static void queueFrame(const DecodedFrame &frame, void *context){
+	Receiver *receiver = (Receiver *) context;
+	ReceivedFrame received;
+	received.frame = frame;
+	received.receiver = receiver->index;
+	received.end_us = receiver->decoder->getTime();
+	received.decoded_ns = nanoseconds();
+	while(!receiver->queue->push(received)){
+		receiver->fullWaits++;
+		std::this_thread::yield();
+	}
+	receiver->frames++;
+	wake(receiver->wakeup);
+}
+
+/** Decodes the whole lines in a buffer and publishes the time they reach.
+ * @param last Whether the buffer ends the stream, so that its last line need not end in a newline.
+ * @return The bytes consumed, those of the whole lines. */
+static size_t ingest(Receiver &receiver, const char *data, size_t length, boolean last){
+	const char *end = data + length;
+	if(!last){
+		const char *newline = (const char *) memrchr(data, '\n', length);
+		end = newline != NULL ? newline + 1 : data;
+	}
+	const char *p = data;
+	while(p < end){
+		uint32_t width;
+		boolean valid;
+		p = readWidth(p, end, &width, &valid);
+		if(valid){
+			receiver.decoder->addPulse(width);
+		}
+	}
+	// Every frame up to this time is in the queue
+	receiver.time_us.store(receiver.decoder->getTime(), std::memory_order_release);
+	wake(receiver.wakeup);
+	return end - data;
+}
+
+static void receive(Receiver *receiver){
+	if(receiver->path == NULL){
+		for(size_t at = 0; at < receiver->size; ){
+			size_t length = receiver->size - at < READ_SIZE ? receiver->size - at : READ_SIZE;
+			size_t used = ingest(*receiver, receiver->data + at, length, at + length == receiver->size);
+			// A line longer than a read is taken whole
+			at += used > 0 ? used : length;
+		}
+	}else{
+		std::vector<char> buffer(READ_SIZE * 2);
+		size_t kept = 0;
+		for(;;){
+			ssize_t n = read(receiver->fd, &buffer[kept], buffer.size() - kept);
+			if(n < 0 && errno == EINTR){
+				continue;
+			}
+			if(n <= 0){
+				ingest(*receiver, &buffer[0], kept, true);
+				receiver->failed = n < 0;
+				break;
+			}
+			size_t length = kept + n;
+			size_t used = ingest(*receiver, &buffer[0], length, false);
+			if(used == 0 && length == buffer.size()){
+				// A line that fills the buffer holds no width, so it is skipped
+				used = length;
+			}
+			kept = length - used;
+			memmove(&buffer[0], &buffer[used], kept);
+		}
+	}
+	receiver->time_us.store(UINT64_MAX, std::memory_order_release);
+	receiver->done.store(true, std::memory_order_release);
+	wake(receiver->wakeup);
+}
+
+/*
+ * The merge
+ */
+/** The state of a run of the gateway. */
+struct Gateway{
+	std::vector<Receiver *> receivers;
+	uint64_t window_us;
+	boolean arrival; ///< Whether windows are measured on the clock of the host rather than the clocks of the receivers.
+	DedupeHandler handler;
+	void *context;
+	LatencyHistogram queueLatency; ///< The time from decoding to leaving the queue of every copy.
+	uint64_t sleeps; ///< The times the merge slept with nothing to do.
+	uint64_t copies;
+	uint64_t frames;
+	uint64_t replaced;
+	uint64_t outvoted;
+};
+
+/** Starts a thread for every receiver, merges their frames until all
+ * of them have ended, and waits for the threads. With nothing to merge
+ * for IDLE_SPINS passes it sleeps until a receiver queues a frame or
+ * moves its time on. */
+static void runGateway(Gateway &gateway, boolean repair){
+	FrameQueue queue(QUEUE_SLOTS);
+	Wakeup wakeup;
+	wakeup.events = 0;
+	wakeup.sleeping = false;
+	wakeup.sleeps = 0;
+	gateway.queueLatency = LatencyHistogram();
+	std::vector<std::thread> threads;
+	for(size_t i = 0; i < gateway.receivers.size(); i++){
+		Receiver *receiver = gateway.receivers[i];
+		receiver->decoder = new PulseDecoder(queueFrame, receiver);
+		if(repair){
+			receiver->decoder->enableRepair(REPAIR_WINDOW_MS, REPAIR_MAX_DIFFS);
+		}
+		receiver->queue = &queue;
+		receiver->wakeup = &wakeup;
+		receiver->time_us = 0;
+		receiver->done = false;
+		receiver->frames = 0;
+		receiver->fullWaits = 0;
+		receiver->failed = false;
+		threads.push_back(std::thread(receive, receiver));
+	}
+	FrameDedupe dedupe(gateway.window_us, gateway.handler, gateway.context);
+	uint64_t start_ns = nanoseconds();
+	uint32_t idlePasses = 0;
+	for(;;){
+		// Read before the times, so that an event after them wakes the sleep below
+		uint64_t events = wakeup.events.load();
+		// Read before the queue is emptied, so that the frames these times cover are all in it
+		boolean done = true;
+		uint64_t time_us = UINT64_MAX;
+		for(size_t i = 0; i < gateway.receivers.size(); i++){
+			done = done && gateway.receivers[i]->done.load(std::memory_order_acquire);
+			uint64_t reached = gateway.receivers[i]->time_us.load(std::memory_order_acquire);
+			time_us = reached < time_us ? reached : time_us;
+		}
+		ReceivedFrame received;
+		boolean idle = true;
+		while(queue.pop(received)){
+			uint64_t now = nanoseconds();
+			addLatency(gateway.queueLatency, now - received.decoded_ns);
+			dedupe.add(received, gateway.arrival ? (now - start_ns) / 1000 : received.end_us);
+			idle = false;
+		}
+		if(done){
+			break;
+		}
+		dedupe.close(gateway.arrival ? (nanoseconds() - start_ns) / 1000 : time_us);
+		if(!idle){
+			idlePasses = 0;
+		}else if(++idlePasses < IDLE_SPINS){
+			std::this_thread::yield();
+		}else{
+			std::unique_lock<std::mutex> hold(wakeup.lock);
+			wakeup.sleeping.store(true);
+			wakeup.ready.wait_for(hold, std::chrono::milliseconds(IDLE_WAIT_MS),
+				[&wakeup, events]{ return wakeup.events.load() != events; });
+			wakeup.sleeping.store(false);
+			wakeup.sleeps++;
+		}
+	}
+	gateway.sleeps = wakeup.sleeps;
+	dedupe.flush();
+	for(size_t i = 0; i < threads.size(); i++){
+		threads[i].join();
+		delete gateway.receivers[i]->decoder;
+		gateway.receivers[i]->decoder = NULL;
+	}
+	gateway.copies = dedupe.getCopies();
+	gateway.frames = dedupe.getFrames();
+	gateway.replaced = dedupe.getReplaced();
+	gateway.outvoted = dedupe.getOutvoted();
+}
+
+// Prints a frame as: seconds protocol device-id channel nibbles receiver votes/copies jitter flags
+static void printFrame(const DedupedFrame &frame, void *context){
+	(void) context;
+	char line[128];
+	PulseDecoder::formatFrame(frame.best.frame, line, sizeof(line));
+	printf("%s %u %u/%u %u %c\n", line, frame.best.receiver, frame.votes, frame.copies, frame.best.frame.jitter,
+		frame.best.frame.repaired ? 'R' : '-');
+}
+
+// Drops the frame, which the dedupe has already counted
+static void countFrame(const DedupedFrame &frame, void *context){
+	(void) frame;
+	(void) context;
+}
+
+// Puts a serial device into raw mode at the baud rate
+static boolean setRaw(int fd, uint32_t baud){
+	struct termios tio;
+	if(tcgetattr(fd, &tio) != 0){
+		return false;
+	}
+	cfmakeraw(&tio);
+	speed_t speed;
+	switch(baud){
+	case 9600: speed = B9600; break;
+	case 57600: speed = B57600; break;
+	case 115200: speed = B115200; break;
+	case 230400: speed = B230400; break;
+	case 500000: speed = B500000; break;
+	case 1000000: speed = B1000000; break;
+	default: return false;
+	}
+	cfsetispeed(&tio, speed);
+	cfsetospeed(&tio, speed);
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 0;
+	return tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+/*
+ * The simulated receivers
+ */
+/** A message that every receiver was sent. */
+struct Transmission{
+	uint64_t time_us; ///< The time of the first edge of its first copy.
+	uint8_t protocol;
+	uint8_t size;
+	uint8_t nibbles[18];
+};
+
+/** Appends a pulse to a stream. */
+static void appendWidth(std::vector<char> &out, uint32_t width, uint64_t *time){
+	char line[16];
+	int n = snprintf(line, sizeof(line), "%u\n", width);
+	out.insert(out.end(), line, line + n);
+	*time += width;
+}
+
+/** Plans the messages of the six sensors of the sketch, at least BENCH_SPACING_US apart. */
+static void planMessages(std::vector<Transmission> &sent, uint32_t frames){
+	const uint8_t v2Channels[3] = {V2_CHANNEL_1, V2_CHANNEL_2, V2_CHANNEL_3};
+	const uint8_t v3Channels[3] = {V3_CHANNEL_1, V3_CHANNEL_2, V3_CHANNEL_3};
+	uint64_t time = BENCH_SPACING_US;
+	for(uint32_t f = 0; f < frames; f++){
+		Transmission message;
+		message.time_us = time;
+		if(f % 2 == 0){
+			message.protocol = OSCV_2_1;
+			message.size = 18;
+			oregon_thgr122nx_message(message.nibbles, v2Channels[f / 2 % 3], 200 + f % 100, 40 + f % 10, false);
+		}else{
+			message.protocol = OSCV_3;
+			message.size = 15;
+			oregon_thwr800_message(message.nibbles, v3Channels[f / 2 % 3], -50 + f % 100);
+		}
+		sent.push_back(message);
+		time += BENCH_SPACING_US + rand() % BENCH_SPACING_US;
+	}
+}
+
+/** Generates what one receiver heard of the messages. Each receiver has
+ * its own noise, misses some messages, and flips some bits of others,
+ * and the pulses of receiver r are off by up to 20 + 10r microseconds,
+ * so that receiver 0 hears every sensor most clearly. */
+static void simulateReceiver(std::vector<char> &out, const std::vector<Transmission> &sent, uint8_t index){
+	uint32_t widths[OREGON_MAX_PULSES];
+	uint8_t nibbles[18];
+	uint16_t jitter = 20 + 10 * index;
+	uint64_t time = 0;
+	for(size_t m = 0; m < sent.size(); m++){
+		const Transmission &message = sent[m];
+		// Noise, and the gap that ends at the first edge of the message
+		for(uint32_t i = rand() % NOISE_PULSES; i > 0 && time + 3010 + 20000 < message.time_us; i--){
+			appendWidth(out, 10 + rand() % 3000, &time);
+		}
+		appendWidth(out, (uint32_t) (message.time_us - time), &time);
+		if(rand() < BENCH_MISS_RATE * RAND_MAX){
+			continue;
+		}
+		for(int copy = 0; copy < (message.protocol == OSCV_2_1 ? 2 : 1); copy++){
+			if(copy > 0){
+				appendWidth(out, REPEAT_GAP_US, &time);
+			}
+			memcpy(nibbles, message.nibbles, message.size);
+			for(uint8_t i = 0; i < message.size; i++){
+				for(uint8_t bit = 0; bit < 4; bit++){
+					if(rand() < BENCH_ERROR_RATE * RAND_MAX){
+						nibbles[i] ^= 1 << bit;
+					}
+				}
+			}
+			size_t count = oregon_encode(message.protocol, nibbles, message.size, widths, OREGON_MAX_PULSES, jitter);
+			for(size_t i = 0; i < count; i++){
+				appendWidth(out, widths[i], &time);
+			}
+		}
+		appendWidth(out, 20000, &time);
+	}
+}
+
+/** Checks the merged frames against the messages that were sent. */
+struct Delivery{
+	const std::vector<Transmission> *sent;
+	std::vector<uint8_t> received; ///< The frames merged for every message.
+	LatencyHistogram emitLatency; ///< The time from decoding the first copy to merging.
+	uint32_t wrong;
+	uint32_t cleanest; ///< The frames kept from the receiver with the least jitter that heard the message.
+};
+
+static void checkFrame(const DedupedFrame &frame, void *context){
+	Delivery *delivery = (Delivery *) context;
+	addLatency(delivery->emitLatency, nanoseconds() - frame.first_ns);
+	const std::vector<Transmission> &sent = *delivery->sent;
+	// The last message that started before the frame ended
+	size_t low = 0;
+	size_t high = sent.size();
+	while(high - low > 1){
+		size_t middle = (low + high) / 2;
+		if(sent[middle].time_us <= frame.best.end_us){
+			low = middle;
+		}else{
+			high = middle;
+		}
+	}
+	const DecodedFrame &best = frame.best.frame;
+	if(best.size == sent[low].size && memcmp(best.nibbles, sent[low].nibbles, best.size) == 0){
+		delivery->received[low]++;
+	}else{
+		delivery->wrong++;
+	}
+	// The lowest receiver in the set heard it with the least jitter
+	if((frame.receivers & ((uint32_t) 1 << frame.best.receiver)) != 0
+		&& (frame.receivers & (((uint32_t) 1 << frame.best.receiver) - 1)) == 0){
+		delivery->cleanest++;
+	}
+}
+
+/** Runs the gateway on 1 to maxReceivers simulated receivers that were all sent the same messages. */
+static void benchmark(uint32_t frames, unsigned maxReceivers, uint64_t window_us, boolean repair, uint32_t seed){
+	srand(seed);
+	std::vector<Transmission> sent;
+	planMessages(sent, frames);
+	std::vector<std::vector<char> > streams(maxReceivers);
+	size_t bytes = 0;
+	for(unsigned r = 0; r < maxReceivers; r++){
+		simulateReceiver(streams[r], sent, r);
+		bytes += streams[r].size();
+	}
+	printf("%u messages, %.1f MB of pulses per receiver, %u cores; each receiver misses %.0f%% of the messages\n",
+		frames, bytes / 1e6 / maxReceivers, std::thread::hardware_concurrency(), BENCH_MISS_RATE * 100);
+	printf("receivers\tseconds\tMpulses/s\tcopies/s\tcopies\tframes\tdelivered\twrong\tdoubled\toutvoted\tcleanest\tqueue p50/p99 us\tmerge p50/p99 ms\tfull waits\tsleeps\n");
+	for(unsigned count = 1; count <= maxReceivers; count = count < maxReceivers && count * 2 > maxReceivers ? maxReceivers : count * 2){
+		std::vector<Receiver> receivers(count);
+		Delivery delivery = {&sent, std::vector<uint8_t>(sent.size(), 0), LatencyHistogram(), 0, 0};
+		Gateway gateway;
+		gateway.window_us = window_us;
+		gateway.arrival = false;
+		gateway.handler = checkFrame;
+		gateway.context = &delivery;
+		uint64_t lines = 0;
+		for(unsigned r = 0; r < count; r++){
+			receivers[r].index = r;
+			receivers[r].path = NULL;
+			receivers[r].data = &streams[r][0];
+			receivers[r].size = streams[r].size();
+			lines += std::count(streams[r].begin(), streams[r].end(), '\n');
+			gateway.receivers.push_back(&receivers[r]);
+		}
+		uint64_t start = nanoseconds();
+		runGateway(gateway, repair);
+		double elapsed = (nanoseconds() - start) / 1e9;
+		uint32_t delivered = 0;
+		uint32_t duplicated = 0;
+		uint64_t fullWaits = 0;
+		for(size_t i = 0; i < sent.size(); i++){
+			delivered += delivery.received[i] > 0;
+			duplicated += delivery.received[i] > 1;
+		}
+		for(unsigned r = 0; r < count; r++){
+			fullWaits += receivers[r].fullWaits;
+		}
+		printf("%u\t\t%.3f\t%.1f\t\t%.0f\t\t%llu\t%llu\t%.2f%%\t\t%u\t%u\t%llu\t\t%.1f%%\t\t%.1f / %.1f\t\t%.1f / %.1f\t\t%llu\t\t%llu\n",
+			count, elapsed, lines / elapsed / 1e6, gateway.copies / elapsed, (unsigned long long) gateway.copies,
+			(unsigned long long) gateway.frames, 100.0 * delivered / sent.size(), delivery.wrong, duplicated,
+			(unsigned long long) gateway.outvoted,
+			100.0 * delivery.cleanest / (gateway.frames > 0 ? gateway.frames : 1),
+			percentile(gateway.queueLatency, 0.5), percentile(gateway.queueLatency, 0.99),
+			percentile(delivery.emitLatency, 0.5) / 1e3, percentile(delivery.emitLatency, 0.99) / 1e3,
+			(unsigned long long) fullWaits, (unsigned long long) gateway.sleeps);
+		if(count == maxReceivers){
+			break;
+		}
+	}
+}
+
+static void usage(const char *name){
+	fprintf(stderr,
+		"usage: %s [options] source...\n"
+		"       %s -b [options]\n"
+		"  -w ms         window in which copies of a frame are merged (default %d)\n"
+		"  -a            measure the window on the clock of this computer, for live receivers\n"
+		"                that were not started together, rather than the clocks of the receivers\n"
+		"  -r            repair frames from their repeats, as the sketch does\n"
+		"  -s baud       baud rate of serial sources (default %u)\n"
+		"  -q            do not print the frames\n"
+		"  -b            benchmark on 1 up to -j simulated receivers\n"
+		"  -j receivers  most simulated receivers (default %d)\n"
+		"  -n messages   messages sent to the simulated receivers (default %d)\n"
+		"A source is a file, a pipe, a serial device, or - for standard input, which\n"
+		"carries one pulse width in microseconds per line, as written by ookdemod -p.\n"
+		"Frames are printed as: seconds protocol device-id channel nibbles receiver votes/copies jitter flags\n"
+		"where the receiver is the one whose copy was kept, the votes are the copies that agreed\n"
+		"with its nibbles, and the flag R marks a repaired frame.\n",
+		name, name, DEFAULT_WINDOW_MS, (unsigned) DEFAULT_BAUD, BENCH_RECEIVERS, BENCH_FRAMES);
+	exit(2);
+}
+
+int main(int argc, char **argv){
+	uint64_t window_us = DEFAULT_WINDOW_MS * 1000ull;
+	boolean arrival = false;
+	boolean repair = false;
+	uint32_t baud = DEFAULT_BAUD;
+	boolean quiet = false;
+	boolean bench = false;
+	unsigned maxReceivers = BENCH_RECEIVERS;
+	uint32_t frames = BENCH_FRAMES;
+	int opt;
+	while((opt = getopt(argc, argv, "w:ars:qbj:n:h")) != -1){
+		switch(opt){
+		case 'w': window_us = strtoull(optarg, NULL, 10) * 1000; break;
+		case 'a': arrival = true; break;
+		case 'r': repair = true; break;
+		case 's': baud = strtoul(optarg, NULL, 10); break;
+		case 'q': quiet = true; break;
+		case 'b': bench = true; break;
+		case 'j': maxReceivers = strtoul(optarg, NULL, 10); break;
+		case 'n': frames = strtoul(optarg, NULL, 10); break;
+		default: usage(argv[0]);
+		}
+	}
+	if(bench){
+		// The simulated receivers are decoded as fast as they can be, so only their own clocks mean anything
+		if(maxReceivers < 1 || maxReceivers > FRAME_DEDUPE_MAX_RECEIVERS || frames < 1 || arrival){
+			usage(argv[0]);
+		}
+		benchmark(frames, maxReceivers, window_us, repair, 1);
+		return 0;
+	}
+	size_t count = argc - optind;
+	if(count < 1 || count > FRAME_DEDUPE_MAX_RECEIVERS){
+		usage(argv[0]);
+	}
+	std::vector<Receiver> receivers(count);
+	Gateway gateway;
+	gateway.window_us = window_us;
+	gateway.arrival = arrival;
+	gateway.handler = quiet ? countFrame : printFrame;
+	gateway.context = NULL;
+	for(size_t i = 0; i < count; i++){
+		Receiver &receiver = receivers[i];
+		receiver.index = i;
+		receiver.path = argv[optind + i];
+		receiver.fd = STDIN_FILENO;
+		if(strcmp(receiver.path, "-") != 0){
+			receiver.fd = open(receiver.path, O_RDONLY | O_NOCTTY);
+			if(receiver.fd < 0){
+				fprintf(stderr, "multigateway: could not open %s\n", receiver.path);
+				return 1;
+			}
+			if(isatty(receiver.fd) && !setRaw(receiver.fd, baud)){
+				fprintf(stderr, "multigateway: could not set %s to %u baud\n", receiver.path, baud);
+				return 1;
+			}
+		}
+		gateway.receivers.push_back(&receiver);
+	}
+	runGateway(gateway, repair);
+	boolean ok = true;
+	for(size_t i = 0; i < count; i++){
+		fprintf(stderr, "multigateway: receiver %u (%s) decoded %llu frames%s\n", (unsigned) i, receivers[i].path,
+			(unsigned long long) receivers[i].frames, receivers[i].failed ? ", then failed to read" : "");
+		ok = ok && !receivers[i].failed;
+	}
+	fprintf(stderr, "multigateway: %llu copies merged into %llu frames, %llu replaced by a better copy, %llu with copies outvoted\n",
+		(unsigned long long) gateway.copies, (unsigned long long) gateway.frames, (unsigned long long) gateway.replaced,
+		(unsigned long long) gateway.outvoted);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,4 @@
+// File: new.h
+// Description: The placement new header of the AVR core, which the host
+// C++ library already provides.
+#include <new>
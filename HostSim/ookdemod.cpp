@@ -0,0 +1,298 @@
+// File: ookdemod.cpp
+// Description: Decodes Oregon Scientific frames from raw 433.92 MHz
+// capture files, and benchmarks the demodulator on generated captures.
+
+#include <Arduino.h>
+#include <OOKFrontEnd.h>
+#include <OregonEncoder.h>
+#include <PulseDecoder.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <math.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#define DEFAULT_SAMPLE_RATE 1000000 ///< The sample rate when none is given.
+#define DEFAULT_FRAMES 50 ///< The number of frames in a generated capture.
+#define FRAME_GAP_MS 250 ///< The quiet time between generated frames.
+#define READ_CHUNK (1 << 20) ///< The size of the reads from a pipe.
+#define BENCH_MIN_SECONDS 0.5 ///< The least time each kernel is measured for.
+
+/** The state shared with the callbacks. */
+struct Demodulation{
+	PulseDecoder *decoder;
+	boolean printPulses;
+	uint64_t pulseSum;
+};
+
+static double seconds(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void printFrame(const DecodedFrame &frame, void *context){
+	(void) context;
+	char line[128];
+	PulseDecoder::formatFrame(frame, line, sizeof(line));
+	puts(line);
+}
+
+static void ignoreFrame(const DecodedFrame &frame, void *context){
+	(void) frame;
+	(void) context;
+}
+
+static void decodePulse(uint32_t width, void *context){
+	Demodulation *demod = (Demodulation *) context;
+	demod->pulseSum += width;
+	if(demod->printPulses){
+		printf("%u\n", width);
+	}else{
+		demod->decoder->addPulse(width);
+	}
+}
+
+static void countPulse(uint32_t width, void *context){
+	((Demodulation *) context)->pulseSum += width;
+}
+
+/*
+ * The capture generator
+ */
+/** Appends samples of the carrier, or of noise alone when it is off, advancing the phase of the carrier by step per sample. */
+static void appendSamples(std::vector<uint8_t> &out, OOKSampleFormat format, uint64_t count, boolean on, double amplitude, const std::vector<int8_t> &noise, double step, double *phase, uint32_t *seed){
+	for(uint64_t i = 0; i < count; i++){
+		*seed = *seed * 1103515245 + 12345;
+		double ni = noise[(*seed >> 8) & 0xFFFF];
+		double nq = noise[(*seed >> 16) & 0xFFFF];
+		double si = on ? amplitude * cos(*phase) : 0;
+		double sq = on ? amplitude * sin(*phase) : 0;
+		*phase += step;
+		if(format == OOK_MAG8){
+			double m = sqrt((si + ni) * (si + ni) + (sq + nq) * (sq + nq));
+			out.push_back(m > 255 ? 255 : (uint8_t) m);
+		}else{
+			int i8 = (int) lround(si + ni);
+			int q8 = (int) lround(sq + nq);
+			i8 = i8 < -128 ? -128 : i8 > 127 ? 127 : i8;
+			q8 = q8 < -128 ? -128 : q8 > 127 ? 127 : q8;
+			out.push_back(format == OOK_IQ8_UNSIGNED ? (uint8_t) (i8 + 128) : (uint8_t) i8);
+			out.push_back(format == OOK_IQ8_UNSIGNED ? (uint8_t) (q8 + 128) : (uint8_t) q8);
+		}
+	}
+}
+
+/** Generates a capture of alternating THGR122NX and THWR800 frames. */
+static void generateCapture(std::vector<uint8_t> &out, OOKSampleFormat format, uint32_t rate, uint32_t frames, double amplitude, double sigma){
+	std::vector<int8_t> noise(65536);
+	srand(7);
+	for(size_t i = 0; i < noise.size(); i++){
+		double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+		double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+		double n = sigma * sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+		noise[i] = n < -127 ? -127 : n > 127 ? 127 : (int8_t) lround(n);
+	}
+	// The carrier is 10 kHz off the center frequency
+	double step = 2 * M_PI * 10000.0 / rate;
+	double phase = 0;
+	uint32_t seed = 1;
+	uint8_t nibbles[18];
+	uint32_t widths[OREGON_MAX_PULSES];
+	for(uint32_t f = 0; f < frames; f++){
+		appendSamples(out, format, (uint64_t) rate * FRAME_GAP_MS / 1000, false, amplitude, noise, step, &phase, &seed);
+		size_t n;
+		if(f % 2 == 0){
+			oregon_thgr122nx_message(nibbles, V2_CHANNEL_1, 200 + f, 40 + f % 10, false);
+			n = oregon_encode(OSCV_2_1, nibbles, 18, widths, OREGON_MAX_PULSES, 30);
+		}else{
+			oregon_thwr800_message(nibbles, V3_CHANNEL_1, -50 + f);
+			n = oregon_encode(OSCV_3, nibbles, 15, widths, OREGON_MAX_PULSES, 30);
+		}
+		// The pulses alternate between carrier and silence, starting with the carrier
+		for(size_t i = 0; i < n; i++){
+			appendSamples(out, format, (uint64_t) widths[i] * rate / 1000000, i % 2 == 0, amplitude, noise, step, &phase, &seed);
+		}
+	}
+	appendSamples(out, format, (uint64_t) rate * FRAME_GAP_MS / 1000, false, amplitude, noise, step, &phase, &seed);
+}
+
+/*
+ * The benchmark
+ */
+static void benchmark(const std::vector<uint8_t> &capture, OOKSampleFormat format, uint32_t rate, uint32_t expected){
+	uint64_t samples = capture.size() / OOKFrontEnd::bytesPerSample(format);
+	double captured = (double) samples / rate;
+	printf("capture: %llu samples, %.1f s at %u S/s, %u frames sent\n", (unsigned long long) samples, captured, rate, expected);
+	printf("kernel\tstage\t\tMS/s\tx real time\tframes\tpulse sum\n");
+	uint64_t reference = 0;
+	for(int k = OOK_KERNEL_SCALAR; k < OOK_KERNEL_AUTO; k++){
+		OOKKernel kernel = (OOKKernel) k;
+		if(!OOKFrontEnd::kernelAvailable(kernel)){
+			printf("%s\tnot supported by this CPU\n", OOKFrontEnd::kernelName(kernel));
+			continue;
+		}
+		for(int stage = 0; stage < 2; stage++){
+			boolean decode = stage == 1;
+			uint32_t runs = 0;
+			uint32_t frames = 0;
+			uint64_t pulseSum = 0;
+			double start = seconds();
+			double elapsed;
+			do{
+				PulseDecoder decoder(ignoreFrame, NULL);
+				Demodulation demod = {&decoder, false, 0};
+				OOKFrontEnd frontEnd(format, rate, kernel, decode ? decodePulse : countPulse, &demod);
+				frontEnd.process(&capture[0], capture.size());
+				frontEnd.finish();
+				frames = decoder.getFrames();
+				pulseSum = demod.pulseSum;
+				runs++;
+				elapsed = seconds() - start;
+			}while(elapsed < BENCH_MIN_SECONDS);
+			double rateMs = samples * (double) runs / elapsed / 1e6;
+			printf("%s\t%s\t%.1f\t%.0f\t\t", OOKFrontEnd::kernelName(kernel), decode ? "demod+decode" : "demod\t", rateMs, rateMs * 1e6 / rate);
+			if(decode){
+				printf("%u/%u", frames, expected);
+			}else{
+				printf("-");
+			}
+			printf("\t%llu%s\n", (unsigned long long) pulseSum, reference != 0 && pulseSum != reference ? " MISMATCH" : "");
+			if(reference == 0){
+				reference = pulseSum;
+			}
+		}
+	}
+}
+
+static void usage(const char *name){
+	fprintf(stderr,
+		"usage: %s [options] capture-file|-\n"
+		"       %s -b [options]\n"
+		"  -f format     iq8 (unsigned I/Q, rtl_sdr), iq8s (signed I/Q, hackrf) or mag8 (default iq8)\n"
+		"  -r rate       samples per second (default %d)\n"
+		"  -k kernel     auto, scalar, sse2 or avx2 (default auto)\n"
+		"  -t level      fixed on threshold instead of following the signal\n"
+		"  -p            print the pulse widths in microseconds instead of the frames\n"
+		"  -b            benchmark every kernel on a generated capture\n"
+		"  -w file       write a generated capture to a file\n"
+		"  -n frames     frames in a generated capture (default %d)\n"
+		"  -a amplitude  amplitude of the generated carrier (default 40)\n"
+		"  -z sigma      standard deviation of the generated noise (default 4)\n"
+		"Frames are printed as: seconds protocol device-id channel nibbles\n",
+		name, name, DEFAULT_SAMPLE_RATE, DEFAULT_FRAMES);
+	exit(2);
+}
+
+int main(int argc, char **argv){
+	OOKSampleFormat format = OOK_IQ8_UNSIGNED;
+	uint32_t rate = DEFAULT_SAMPLE_RATE;
+	OOKKernel kernel = OOK_KERNEL_AUTO;
+	uint32_t threshold = 0;
+	boolean printPulses = false;
+	boolean bench = false;
+	const char *writePath = NULL;
+	uint32_t frames = DEFAULT_FRAMES;
+	double amplitude = 40;
+	double sigma = 4;
+	int opt;
+	while((opt = getopt(argc, argv, "f:r:k:t:pbw:n:a:z:h")) != -1){
+		switch(opt){
+		case 'f':
+			if(strcmp(optarg, "iq8") == 0) format = OOK_IQ8_UNSIGNED;
+			else if(strcmp(optarg, "iq8s") == 0) format = OOK_IQ8_SIGNED;
+			else if(strcmp(optarg, "mag8") == 0) format = OOK_MAG8;
+			else usage(argv[0]);
+			break;
+		case 'r': rate = strtoul(optarg, NULL, 10); break;
+		case 'k':
+			if(strcmp(optarg, "scalar") == 0) kernel = OOK_KERNEL_SCALAR;
+			else if(strcmp(optarg, "sse2") == 0) kernel = OOK_KERNEL_SSE2;
+			else if(strcmp(optarg, "avx2") == 0) kernel = OOK_KERNEL_AVX2;
+			else if(strcmp(optarg, "auto") == 0) kernel = OOK_KERNEL_AUTO;
+			else usage(argv[0]);
+			break;
+		case 't': threshold = strtoul(optarg, NULL, 10); break;
+		case 'p': printPulses = true; break;
+		case 'b': bench = true; break;
+		case 'w': writePath = optarg; break;
+		case 'n': frames = strtoul(optarg, NULL, 10); break;
+		case 'a': amplitude = atof(optarg); break;
+		case 'z': sigma = atof(optarg); break;
+		default: usage(argv[0]);
+		}
+	}
+	if(rate == 0){
+		usage(argv[0]);
+	}
+
+	if(bench || writePath != NULL){
+		std::vector<uint8_t> capture;
+		generateCapture(capture, format, rate, frames, amplitude, sigma);
+		if(writePath != NULL){
+			FILE *file = fopen(writePath, "wb");
+			if(file == NULL || fwrite(&capture[0], 1, capture.size(), file) != capture.size()){
+				fprintf(stderr, "ookdemod: could not write %s\n", writePath);
+				return 1;
+			}
+			fclose(file);
+		}
+		if(bench){
+			benchmark(capture, format, rate, frames);
+		}
+		return 0;
+	}
+	if(optind != argc - 1){
+		usage(argv[0]);
+	}
+
+	PulseDecoder decoder(printFrame, NULL);
+	Demodulation demod = {&decoder, printPulses, 0};
+	OOKFrontEnd frontEnd(format, rate, kernel, decodePulse, &demod);
+	if(threshold > 0){
+		frontEnd.setThreshold(threshold);
+	}
+	double start = seconds();
+	const char *path = argv[optind];
+	if(strcmp(path, "-") == 0){
+		// A pipe is read in chunks that hold whole samples
+		std::vector<uint8_t> chunk(READ_CHUNK);
+		size_t held = 0;
+		ssize_t n;
+		while((n = read(STDIN_FILENO, &chunk[held], chunk.size() - held)) > 0){
+			held += n;
+			size_t whole = held - held % OOKFrontEnd::bytesPerSample(format);
+			frontEnd.process(&chunk[0], whole);
+			memmove(&chunk[0], &chunk[whole], held - whole);
+			held -= whole;
+		}
+	}else{
+		int fd = open(path, O_RDONLY);
+		struct stat st;
+		if(fd < 0 || fstat(fd, &st) != 0){
+			fprintf(stderr, "ookdemod: could not open %s\n", path);
+			return 1;
+		}
+		if(st.st_size > 0){
+			const uint8_t *data = (const uint8_t *) mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if(data == MAP_FAILED){
+				fprintf(stderr, "ookdemod: could not map %s\n", path);
+				return 1;
+			}
+			madvise((void *) data, st.st_size, MADV_SEQUENTIAL);
+			frontEnd.process(data, st.st_size);
+			munmap((void *) data, st.st_size);
+		}
+		close(fd);
+	}
+	frontEnd.finish();
+	double elapsed = seconds() - start;
+	double captured = (double) frontEnd.getSamples() / rate;
+	fprintf(stderr, "ookdemod: %llu samples (%.1f s) in %.3f s with the %s kernel, %.0fx real time, %llu edges, %u frames\n",
+		(unsigned long long) frontEnd.getSamples(), captured, elapsed, OOKFrontEnd::kernelName(frontEnd.getKernel()),
+		elapsed > 0 ? captured / elapsed : 0.0, (unsigned long long) frontEnd.getEdges(), decoder.getFrames());
+	return 0;
+}
@@ -0,0 +1,71 @@
+#! /usr/bin/env python3
+# File: sketch.py
+# Description: Merges the tabs of a sketch into one C++ file the way the
+# Arduino builder does so the sketch can be compiled for the host.
+#
+# The main tab comes first and the others follow in alphabetical order.
+# Prototypes of every function are inserted before the first function
+# definition, and #line directives keep compiler errors pointing at the
+# original tabs.
+
+import glob
+import os
+import re
+import sys
+
+FUNCTION = re.compile(r'^((?:inline\s+|static\s+)*[A-Za-z_][\w<>:\*\s&]*?[\s\*&]+)([A-Za-z_]\w*)\s*\(([^;{)]*)\)\s*\{', re.M)
+KEYWORDS = ('if', 'while', 'for', 'switch')
+NOT_TYPES = ('else', 'return', 'struct', 'class', 'enum', 'union')
+
+
+def tabs(sketch):
+    name = os.path.basename(os.path.normpath(sketch))
+    main = os.path.join(sketch, name + '.ino')
+    others = sorted(f for f in glob.glob(os.path.join(sketch, '*.ino')) if f != main)
+    return [main] + others
+
+
+def strip_comments(text):
+    # Keeps the newlines so that line numbers still match
+    text = re.sub(r'/\*.*?\*/', lambda m: '\n' * m.group(0).count('\n'), text, flags=re.S)
+    return re.sub(r'//[^\n]*', '', text)
+
+
+def prototypes(text):
+    protos = []
+    for match in FUNCTION.finditer(strip_comments(text)):
+        ret, name, args = match.groups()
+        if name in KEYWORDS or ret.strip() in NOT_TYPES:
+            continue
+        # Default arguments stay on the definition
+        args = re.sub(r'\s*=\s*[^,]+', '', args)
+        protos.append('%s %s(%s);' % (ret.strip(), name, ' '.join(args.split())))
+    return protos
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit('usage: sketch.py <sketch directory>')
+    files = tabs(sys.argv[1])
+    sources = [(f, open(f).read()) for f in files]
+    protos = prototypes('\n'.join(text for _, text in sources))
+    out = ['#include <Arduino.h>']
+    inserted = False
+    for path, text in sources:
+        path = os.path.abspath(path)
+        out.append('#line 1 "%s"' % path)
+        if not inserted:
+            match = next((m for m in FUNCTION.finditer(text) if m.group(2) not in KEYWORDS), None)
+            if match is not None:
+                line = text.count('\n', 0, match.start())
+                out.append(text[:match.start()])
+                out.extend(protos)
+                out.append('#line %d "%s"' % (line + 1, path))
+                text = text[match.start():]
+                inserted = True
+        out.append(text)
+    print('\n'.join(out))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,549 @@
+// File: tracedecode.cpp
+// Description: Decodes Oregon Scientific frames from recorded pulse traces
+// on every core, and checks that the result matches a single decoder.
+
+#include <Arduino.h>
+#include <OregonEncoder.h>
+#include <PulseDecoder.h>
+#include <WorkStealingPool.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#define SEGMENTS_PER_THREAD 16 ///< The number of segments a trace is split into for each thread, so that stealing can even out the load.
+#define MIN_SEGMENT_BYTES 65536 ///< The smallest segment worth handing to a thread.
+#define DEFAULT_FRAMES 20000 ///< The number of frames in a generated trace.
+#define NOISE_PULSES 60 ///< The most noise pulses between generated frames.
+#define READ_CHUNK (1 << 20) ///< The size of the reads from a pipe.
+#define BENCH_RUNS 3 ///< The number of runs the benchmark keeps the fastest of.
+#define REPEAT_GAP_US 10000 ///< The gap between the two copies of a generated version 2.1 message.
+#define REPAIR_WINDOW_MS 1000 ///< The repair window of the benchmark, FRAME_REPAIR_WINDOW_MS in header.h.
+#define REPAIR_MAX_DIFFS 2 ///< The most differing nibbles of the benchmark, FRAME_REPAIR_MAX_DIFFS in header.h.
+
+/*
+ * A trace is text with one pulse width in microseconds per line, as
+ * written by ookdemod -p. Lines without a number are skipped.
+ */
+
+/** Reads the width on the line at p.
+ * @param *width Set to the width, saturating at 32 bits.
+ * @param *valid Set to whether the line held a number.
+ * @return The start of the next line. */
+static const char *readWidth(const char *p, const char *end, uint32_t *width, boolean *valid){
+	while(p < end && (*p == ' ' || *p == '\t')){
+		p++;
+	}
+	uint64_t value = 0;
+	const char *digits = p;
+	while(p < end && *p >= '0' && *p <= '9'){
+		value = value * 10 + (*p - '0');
+		if(value > 0xFFFFFFFFull){
+			value = 0xFFFFFFFFull;
+		}
+		p++;
+	}
+	*valid = p > digits;
+	*width = (uint32_t) value;
+	while(p < end && *p != '\n'){
+		p++;
+	}
+	return p < end ? p + 1 : end;
+}
+
+/** A part of the trace that starts right after a gap, or at the start of the trace. */
+struct Segment{
+	const char *begin;
+	const char *end;
+	uint64_t duration; ///< The sum of the widths in the segment.
+	uint64_t pulses;
+	std::vector<DecodedFrame> frames; ///< The frames, timed from the start of the segment.
+};
+
+/** The state shared with the tasks. */
+struct Batch{
+	std::vector<Segment> *segments;
+	std::vector<PulseDecoder *> decoders; ///< One per thread.
+	std::vector<std::vector<DecodedFrame> *> outputs; ///< The frame list each thread's decoder appends to.
+};
+
+static double seconds(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void collectFrame(const DecodedFrame &frame, void *context){
+	(*(std::vector<DecodedFrame> **) context)->push_back(frame);
+}
+
+/** Adds a segment that has not been decoded yet. */
+static void addSegment(std::vector<Segment> &segments, const char *begin, const char *end){
+	Segment segment;
+	segment.begin = begin;
+	segment.end = end;
+	segment.duration = 0;
+	segment.pulses = 0;
+	segments.push_back(segment);
+}
+
+/** Splits a trace into about count segments. Each boundary is moved
+ * forward to the line after the next gap, since no frame spans a gap. */
+static void splitTrace(const char *data, size_t size, size_t count, std::vector<Segment> &segments){
+	segments.clear();
+	const char *end = data + size;
+	const char *begin = data;
+	for(size_t k = 1; k < count && begin < end; k++){
+		const char *p = data + size * k / count;
+		if(p <= begin){
+			continue;
+		}
+		// Starts at the beginning of a line
+		while(p < end && p[-1] != '\n'){
+			p++;
+		}
+		boolean gap = false;
+		while(p < end && !gap){
+			uint32_t width;
+			boolean valid;
+			p = readWidth(p, end, &width, &valid);
+			gap = valid && PulseDecoder::isGap(width);
+		}
+		if(!gap){
+			break;
+		}
+		addSegment(segments, begin, p);
+		begin = p;
+	}
+	if(begin < end || segments.empty()){
+		addSegment(segments, begin, end);
+	}
+}
+
+/** Feeds the widths from begin to end to a decoder.
+ * @return The number of pulses. */
+static uint64_t feed(PulseDecoder &decoder, const char *begin, const char *end){
+	uint64_t pulses = 0;
+	const char *p = begin;
+	while(p < end){
+		uint32_t width;
+		boolean valid;
+		p = readWidth(p, end, &width, &valid);
+		if(valid){
+			decoder.addPulse(width);
+			pulses++;
+		}
+	}
+	return pulses;
+}
+
+static void decodeSegment(size_t index, unsigned worker, void *context){
+	Batch *batch = (Batch *) context;
+	Segment &segment = (*batch->segments)[index];
+	segment.frames.clear();
+	if(index == 0){
+		// The first segment starts with a decoder that has seen no gap yet, like the single decoder
+		std::vector<DecodedFrame> *output = &segment.frames;
+		PulseDecoder decoder(collectFrame, &output);
+		segment.pulses = feed(decoder, segment.begin, segment.end);
+		segment.duration = decoder.getTime();
+	}else{
+		PulseDecoder *decoder = batch->decoders[worker];
+		batch->outputs[worker] = &segment.frames;
+		decoder->restart(0);
+		segment.pulses = feed(*decoder, segment.begin, segment.end);
+		segment.duration = decoder->getTime();
+	}
+}
+
+/** Decodes a trace on a pool of threads. The segments are in the order
+ * of the trace, so shifting each one's frames by the duration of those
+ * before it and appending them keeps the frames in order of time.
+ * @return The number of pulses. */
+static uint64_t decodeParallel(const char *data, size_t size, WorkStealingPool &pool, std::vector<DecodedFrame> &frames, size_t *segmentCount){
+	size_t count = (size_t) pool.getThreads() * SEGMENTS_PER_THREAD;
+	if(count > size / MIN_SEGMENT_BYTES){
+		count = size / MIN_SEGMENT_BYTES;
+	}
+	std::vector<Segment> segments;
+	splitTrace(data, size, count > 0 ? count : 1, segments);
+	Batch batch;
+	batch.segments = &segments;
+	batch.outputs.resize(pool.getThreads());
+	for(unsigned w = 0; w < pool.getThreads(); w++){
+		batch.decoders.push_back(new PulseDecoder(collectFrame, &batch.outputs[w]));
+	}
+	pool.run(segments.size(), decodeSegment, &batch);
+	for(unsigned w = 0; w < pool.getThreads(); w++){
+		delete batch.decoders[w];
+	}
+	frames.clear();
+	uint64_t offset = 0;
+	uint64_t pulses = 0;
+	for(size_t i = 0; i < segments.size(); i++){
+		for(size_t f = 0; f < segments[i].frames.size(); f++){
+			frames.push_back(segments[i].frames[f]);
+			frames.back().time_us += offset;
+		}
+		offset += segments[i].duration;
+		pulses += segments[i].pulses;
+	}
+	*segmentCount = segments.size();
+	return pulses;
+}
+
+/** Decodes a trace with one decoder, the reference for the parallel decoder.
+ * @return The number of pulses. */
+static uint64_t decodeSingle(const char *data, size_t size, std::vector<DecodedFrame> &frames){
+	frames.clear();
+	std::vector<DecodedFrame> *output = &frames;
+	PulseDecoder decoder(collectFrame, &output);
+	return feed(decoder, data, data + size);
+}
+
+/** Finds the first frame that differs between two runs.
+ * @return The index of the frame, or -1 if the runs match. */
+static long firstDifference(const std::vector<DecodedFrame> &a, const std::vector<DecodedFrame> &b){
+	size_t n = a.size() < b.size() ? a.size() : b.size();
+	for(size_t i = 0; i < n; i++){
+		if(a[i].time_us != b[i].time_us || a[i].protocol != b[i].protocol || a[i].sensorId != b[i].sensorId
+			|| a[i].channel != b[i].channel || a[i].size != b[i].size || memcmp(a[i].nibbles, b[i].nibbles, a[i].size) != 0){
+			return (long) i;
+		}
+	}
+	return a.size() == b.size() ? -1 : (long) n;
+}
+
+static void printMismatch(const std::vector<DecodedFrame> &single, const std::vector<DecodedFrame> &parallel, long index){
+	char line[128];
+	fprintf(stderr, "tracedecode: MISMATCH at frame %ld (%u frames single-threaded, %u in parallel)\n",
+		index, (unsigned) single.size(), (unsigned) parallel.size());
+	if((size_t) index < single.size()){
+		PulseDecoder::formatFrame(single[index], line, sizeof(line));
+		fprintf(stderr, "  single:   %s\n", line);
+	}
+	if((size_t) index < parallel.size()){
+		PulseDecoder::formatFrame(parallel[index], line, sizeof(line));
+		fprintf(stderr, "  parallel: %s\n", line);
+	}
+}
+
+/*
+ * The trace generator
+ */
+/** A message that the generator sent. */
+struct Transmission{
+	uint64_t time_us; ///< The time of the first edge of its first copy.
+	uint8_t size;
+	uint8_t nibbles[18];
+};
+
+/** Appends a pulse to a trace. */
+static void appendWidth(std::vector<char> &out, uint32_t width, uint64_t *time){
+	char line[16];
+	int n = snprintf(line, sizeof(line), "%u\n", width);
+	out.insert(out.end(), line, line + n);
+	*time += width;
+}
+
+/** Generates a trace of frames from the six sensors of the sketch, with
+ * bursts of noise between them as a receiver with no signal produces.
+ * Version 2.1 messages are sent twice, as the sensors do.
+ * @param errorRate The chance that interference flips a bit of a copy of a message. The
+ * flip keeps the Manchester decoder in step, as a wrong nibble in a whole frame does.
+ * @param *sent Receives the messages that were sent, or NULL. */
+static void generateTrace(std::vector<char> &out, uint32_t frames, uint32_t seed, double errorRate, std::vector<Transmission> *sent){
+	uint32_t widths[OREGON_MAX_PULSES];
+	uint8_t nibbles[18];
+	const uint8_t v2Channels[3] = {V2_CHANNEL_1, V2_CHANNEL_2, V2_CHANNEL_3};
+	const uint8_t v3Channels[3] = {V3_CHANNEL_1, V3_CHANNEL_2, V3_CHANNEL_3};
+	uint64_t time = 0;
+	srand(seed);
+	for(uint32_t f = 0; f < frames; f++){
+		uint32_t noise = rand() % NOISE_PULSES;
+		for(uint32_t i = 0; i < noise; i++){
+			appendWidth(out, 10 + rand() % 3000, &time);
+		}
+		appendWidth(out, 20000 + rand() % 80000, &time);
+		Transmission message;
+		message.time_us = time;
+		uint8_t protocol;
+		if(f % 2 == 0){
+			protocol = OSCV_2_1;
+			message.size = 18;
+			oregon_thgr122nx_message(message.nibbles, v2Channels[f / 2 % 3], 200 + f % 100, 40 + f % 10, false);
+		}else{
+			protocol = OSCV_3;
+			message.size = 15;
+			oregon_thwr800_message(message.nibbles, v3Channels[f / 2 % 3], -50 + f % 100);
+		}
+		if(sent != NULL){
+			sent->push_back(message);
+		}
+		for(int copy = 0; copy < (protocol == OSCV_2_1 ? 2 : 1); copy++){
+			if(copy > 0){
+				appendWidth(out, REPEAT_GAP_US, &time);
+			}
+			memcpy(nibbles, message.nibbles, message.size);
+			for(uint8_t i = 0; i < message.size && errorRate > 0; i++){
+				for(uint8_t bit = 0; bit < 4; bit++){
+					if(rand() < errorRate * RAND_MAX){
+						nibbles[i] ^= 1 << bit;
+					}
+				}
+			}
+			size_t count = oregon_encode(protocol, nibbles, message.size, widths, OREGON_MAX_PULSES, 60);
+			for(size_t i = 0; i < count; i++){
+				appendWidth(out, widths[i], &time);
+			}
+		}
+	}
+}
+
+/*
+ * The repair benchmark
+ */
+/** Counts the messages that arrived whole, and the frames that do not match what was sent. */
+struct Delivery{
+	const std::vector<Transmission> *sent;
+	std::vector<boolean> received;
+	uint32_t wrong;
+	uint32_t repaired;
+};
+
+static void checkFrame(const DecodedFrame &frame, void *context){
+	Delivery *delivery = (Delivery *) context;
+	const std::vector<Transmission> &sent = *delivery->sent;
+	// The last message sent at or before the frame
+	size_t low = 0;
+	size_t high = sent.size();
+	while(high - low > 1){
+		size_t middle = (low + high) / 2;
+		if(sent[middle].time_us <= frame.time_us){
+			low = middle;
+		}else{
+			high = middle;
+		}
+	}
+	if(frame.size == sent[low].size && memcmp(frame.nibbles, sent[low].nibbles, frame.size) == 0){
+		delivery->received[low] = true;
+	}else{
+		delivery->wrong++;
+	}
+	if(frame.repaired){
+		delivery->repaired++;
+	}
+}
+
+/** Decodes a trace with and without repair at every level of interference. */
+static void repairBenchmark(uint32_t frames, uint32_t seed){
+	const double rates[] = {0, 0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1};
+	printf("%u messages per level, V2.1 sent twice; each bit of a copy is flipped with the given chance\n", frames);
+	printf("\t\tall messages\t\tV2.1 messages\n");
+	printf("error rate\twithout\twith repair\twithout\twith repair\trepaired\trefused\twrong frames without / with\n");
+	for(size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++){
+		std::vector<char> trace;
+		std::vector<Transmission> sent;
+		generateTrace(trace, frames, seed, rates[r], &sent);
+		Delivery plain = {&sent, std::vector<boolean>(sent.size(), false), 0, 0};
+		Delivery fixed = {&sent, std::vector<boolean>(sent.size(), false), 0, 0};
+		PulseDecoder plainDecoder(checkFrame, &plain);
+		feed(plainDecoder, &trace[0], &trace[0] + trace.size());
+		PulseDecoder repairDecoder(checkFrame, &fixed);
+		repairDecoder.enableRepair(REPAIR_WINDOW_MS, REPAIR_MAX_DIFFS);
+		feed(repairDecoder, &trace[0], &trace[0] + trace.size());
+		uint32_t plainCount = 0;
+		uint32_t fixedCount = 0;
+		uint32_t v2Count = 0;
+		uint32_t v2Plain = 0;
+		uint32_t v2Fixed = 0;
+		for(size_t i = 0; i < sent.size(); i++){
+			plainCount += plain.received[i];
+			fixedCount += fixed.received[i];
+			if(sent[i].size == OregonScientificSensor::THGR122NX_FORMAT[1]){
+				v2Count++;
+				v2Plain += plain.received[i];
+				v2Fixed += fixed.received[i];
+			}
+		}
+		printf("%.4f\t\t%.2f%%\t%.2f%%\t\t%.2f%%\t%.2f%%\t\t%u\t\t%u\t%u / %u\n", rates[r], 100.0 * plainCount / sent.size(), 100.0 * fixedCount / sent.size(),
+			100.0 * v2Plain / v2Count, 100.0 * v2Fixed / v2Count, fixed.repaired, repairDecoder.getRefused(), plain.wrong, fixed.wrong);
+	}
+}
+
+/*
+ * The benchmark
+ */
+static void benchmark(const char *data, size_t size, unsigned maxThreads){
+	std::vector<DecodedFrame> reference;
+	uint64_t pulses = 0;
+	double single = 0;
+	for(int run = 0; run < BENCH_RUNS; run++){
+		double start = seconds();
+		pulses = decodeSingle(data, size, reference);
+		double elapsed = seconds() - start;
+		single = run == 0 || elapsed < single ? elapsed : single;
+	}
+	printf("trace: %.1f MB, %llu pulses, %u frames\n", size / 1e6, (unsigned long long) pulses, (unsigned) reference.size());
+	printf("threads\tsegments\tsteals\tseconds\tMpulses/s\tspeedup\tefficiency\toutput\n");
+	printf("single\t-\t\t-\t%.3f\t%.1f\t\t1.00\t-\t\treference\n", single, pulses / single / 1e6);
+	for(unsigned threads = 1; threads <= maxThreads; threads = threads < maxThreads && threads * 2 > maxThreads ? maxThreads : threads * 2){
+		WorkStealingPool pool(threads);
+		std::vector<DecodedFrame> frames;
+		size_t segments;
+		double elapsed = 0;
+		for(int run = 0; run < BENCH_RUNS; run++){
+			double start = seconds();
+			decodeParallel(data, size, pool, frames, &segments);
+			double time = seconds() - start;
+			elapsed = run == 0 || time < elapsed ? time : elapsed;
+		}
+		long difference = firstDifference(reference, frames);
+		printf("%u\t%u\t\t%llu\t%.3f\t%.1f\t\t%.2f\t%.0f%%\t\t%s\n", threads, (unsigned) segments, (unsigned long long) pool.getSteals(),
+			elapsed, pulses / elapsed / 1e6, single / elapsed, 100 * single / elapsed / threads, difference < 0 ? "matches" : "MISMATCH");
+		if(threads == maxThreads){
+			break;
+		}
+	}
+}
+
+static void usage(const char *name){
+	fprintf(stderr,
+		"usage: %s [options] trace-file|-\n"
+		"       %s -b [options] [trace-file]\n"
+		"  -j threads    decoding threads (default one per core)\n"
+		"  -c            also decode with a single decoder and fail unless the frames match\n"
+		"  -q            do not print the frames\n"
+		"  -b            benchmark from one thread up to -j, on the trace or a generated one\n"
+		"  -w file       write a generated trace to a file\n"
+		"  -n frames     frames in a generated trace (default %d)\n"
+		"  -s seed       seed of the generated trace (default 1)\n"
+		"  -e rate       chance that a bit of a generated frame is flipped by interference (default 0)\n"
+		"  -R            measure the frames recovered by the frame repair at rising interference\n"
+		"A trace holds one pulse width in microseconds per line, as written by ookdemod -p.\n"
+		"Frames are printed as: seconds protocol device-id channel nibbles\n",
+		name, name, DEFAULT_FRAMES);
+	exit(2);
+}
+
+int main(int argc, char **argv){
+	unsigned threads = std::thread::hardware_concurrency();
+	boolean check = false;
+	boolean quiet = false;
+	boolean bench = false;
+	const char *writePath = NULL;
+	uint32_t generated = DEFAULT_FRAMES;
+	uint32_t seed = 1;
+	double errorRate = 0;
+	boolean repairBench = false;
+	int opt;
+	while((opt = getopt(argc, argv, "j:cqbw:n:s:e:Rh")) != -1){
+		switch(opt){
+		case 'j': threads = strtoul(optarg, NULL, 10); break;
+		case 'c': check = true; break;
+		case 'q': quiet = true; break;
+		case 'b': bench = true; break;
+		case 'w': writePath = optarg; break;
+		case 'n': generated = strtoul(optarg, NULL, 10); break;
+		case 's': seed = strtoul(optarg, NULL, 10); break;
+		case 'e': errorRate = atof(optarg); break;
+		case 'R': repairBench = true; break;
+		default: usage(argv[0]);
+		}
+	}
+	if(threads == 0){
+		threads = 1;
+	}
+
+	if(repairBench){
+		repairBenchmark(generated, seed);
+		return 0;
+	}
+	std::vector<char> buffer;
+	const char *data = NULL;
+	size_t size = 0;
+	if(optind == argc && (bench || writePath != NULL)){
+		generateTrace(buffer, generated, seed, errorRate, NULL);
+		if(writePath != NULL){
+			FILE *file = fopen(writePath, "wb");
+			if(file == NULL || fwrite(&buffer[0], 1, buffer.size(), file) != buffer.size()){
+				fprintf(stderr, "tracedecode: could not write %s\n", writePath);
+				return 1;
+			}
+			fclose(file);
+			if(!bench){
+				return 0;
+			}
+		}
+		data = &buffer[0];
+		size = buffer.size();
+	}else if(optind == argc - 1 && strcmp(argv[optind], "-") == 0){
+		// A pipe is read whole, since the split needs all of it
+		ssize_t n;
+		do{
+			buffer.resize(size + READ_CHUNK);
+			n = read(STDIN_FILENO, &buffer[size], READ_CHUNK);
+			size += n > 0 ? n : 0;
+		}while(n > 0);
+		data = size > 0 ? &buffer[0] : NULL;
+	}else if(optind == argc - 1){
+		const char *path = argv[optind];
+		int fd = open(path, O_RDONLY);
+		struct stat st;
+		if(fd < 0 || fstat(fd, &st) != 0){
+			fprintf(stderr, "tracedecode: could not open %s\n", path);
+			return 1;
+		}
+		size = st.st_size;
+		if(size > 0){
+			data = (const char *) mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if(data == MAP_FAILED){
+				fprintf(stderr, "tracedecode: could not map %s\n", path);
+				return 1;
+			}
+		}
+		close(fd);
+	}else{
+		usage(argv[0]);
+	}
+	if(size == 0){
+		fprintf(stderr, "tracedecode: the trace is empty\n");
+		return 1;
+	}
+
+	if(bench){
+		benchmark(data, size, threads);
+		return 0;
+	}
+	WorkStealingPool pool(threads);
+	std::vector<DecodedFrame> frames;
+	size_t segments;
+	double start = seconds();
+	uint64_t pulses = decodeParallel(data, size, pool, frames, &segments);
+	double elapsed = seconds() - start;
+	if(!quiet){
+		char line[128];
+		for(size_t i = 0; i < frames.size(); i++){
+			PulseDecoder::formatFrame(frames[i], line, sizeof(line));
+			puts(line);
+		}
+	}
+	fprintf(stderr, "tracedecode: %llu pulses in %.3f s on %u threads, %u segments, %llu steals, %u frames\n",
+		(unsigned long long) pulses, elapsed, pool.getThreads(), (unsigned) segments,
+		(unsigned long long) pool.getSteals(), (unsigned) frames.size());
+	if(check){
+		std::vector<DecodedFrame> single;
+		decodeSingle(data, size, single);
+		long difference = firstDifference(single, frames);
+		if(difference >= 0){
+			printMismatch(single, frames, difference);
+			return 1;
+		}
+		fprintf(stderr, "tracedecode: the %u frames match the single-threaded run\n", (unsigned) single.size());
+	}
+	return 0;
+}
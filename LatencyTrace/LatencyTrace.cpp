@@ -0,0 +1,241 @@
+#include <LatencyTrace.h>
+
+#ifdef LATENCY_TRACE
+
+TraceRecord LatencyTrace::records[LATENCY_TRACE_RECORDS];
+uint8_t LatencyTrace::nextRecord = 0;
+int8_t LatencyTrace::current = -1;
+volatile uint32_t LatencyTrace::starts[LATENCY_TRACE_STARTS];
+volatile uint8_t LatencyTrace::startsQueued = 0;
+uint8_t LatencyTrace::startsTaken = 0;
+uint32_t LatencyTrace::frameStart = 0;
+boolean LatencyTrace::frameStartKnown = false;
+uint16_t LatencyTrace::histograms[TRACE_STAGES][LATENCY_TRACE_BUCKETS];
+uint16_t LatencyTrace::counts[TRACE_STAGES];
+uint32_t LatencyTrace::maxima[TRACE_STAGES];
+uint16_t LatencyTrace::completed = 0;
+uint16_t LatencyTrace::dropped = 0;
+
+static const char * const stageNames[TRACE_STAGES] = {"end-to-end", "sync", "validate", "json", "assemble", "connect", "send", "response"};
+
+void LatencyTrace::edgeAfterGap(uint32_t now){
+	starts[startsQueued % LATENCY_TRACE_STARTS] = now;
+	startsQueued++;
+}
+
+void LatencyTrace::gapDecoded(){
+	uint8_t queued = startsQueued;
+	// The ISR has overwritten the start of this burst if it ran too far ahead
+	frameStartKnown = (uint8_t)(queued - startsTaken) > 0 && (uint8_t)(queued - startsTaken) < LATENCY_TRACE_STARTS;
+	if(frameStartKnown){
+		frameStart = starts[startsTaken % LATENCY_TRACE_STARTS];
+	}
+	startsTaken++;
+}
+
+void LatencyTrace::sync(uint32_t now){
+	if(!frameStartKnown){
+		return;
+	}
+	if(current >= 0){
+		TraceRecord *open = &records[current];
+		if(open->stamps[TRACE_FIRST_EDGE] == frameStart){
+			// Both parsers can sync on the same burst; the first one counts
+			return;
+		}
+		// The record of an earlier burst that never reached a sensor is reused
+	}else{
+		// A free record is taken, and the oldest slot is only overwritten when all are in use
+		uint8_t free = 0;
+		while(free < LATENCY_TRACE_RECORDS && records[(nextRecord + free) % LATENCY_TRACE_RECORDS].stages != 0){
+			free++;
+		}
+		current = free < LATENCY_TRACE_RECORDS ? (nextRecord + free) % LATENCY_TRACE_RECORDS : nextRecord;
+		nextRecord = (current + 1) % LATENCY_TRACE_RECORDS;
+		if(records[current].stages != 0){
+			dropped++;
+		}
+	}
+	TraceRecord *record = &records[current];
+	record->stamps[TRACE_FIRST_EDGE] = frameStart;
+	record->stamps[TRACE_SYNC] = now;
+	record->stages = (1 << TRACE_FIRST_EDGE) | (1 << TRACE_SYNC);
+	record->tag = TRACE_ANY_TAG;
+}
+
+void LatencyTrace::validated(uint32_t now){
+	if(current < 0 || records[current].stages != ((1 << TRACE_FIRST_EDGE) | (1 << TRACE_SYNC))){
+		return;
+	}
+	records[current].stamps[TRACE_VALIDATE] = now;
+	records[current].stages |= 1 << TRACE_VALIDATE;
+}
+
+void LatencyTrace::tagFrame(uint8_t tag){
+	if(current < 0 || !(records[current].stages & (1 << TRACE_VALIDATE))){
+		return;
+	}
+	// The frame is done with once it is in the summary
+	TraceRecord *frame = &records[current];
+	addSample(TRACE_SYNC, frame->stamps[TRACE_SYNC] - frame->stamps[TRACE_FIRST_EDGE]);
+	addSample(TRACE_VALIDATE, frame->stamps[TRACE_VALIDATE] - frame->stamps[TRACE_SYNC]);
+	frame->tag = tag;
+	for(uint8_t i = 0; i < LATENCY_TRACE_RECORDS; i++){
+		if(i != current && records[i].stages != 0 && records[i].tag == tag && !(records[i].stages & (1 << TRACE_JSON))){
+			// The window is already traced from its first frame
+			frame->stages = 0;
+			break;
+		}
+	}
+	current = -1;
+}
+
+void LatencyTrace::mark(uint8_t stage, uint32_t now, uint8_t tag){
+	for(uint8_t i = 0; i < LATENCY_TRACE_RECORDS; i++){
+		TraceRecord *record = &records[i];
+		if(i == current || !(record->stages & (1 << (stage - 1))) || (record->stages & (1 << stage))){
+			continue;
+		}
+		if(tag != TRACE_ANY_TAG && record->tag != tag){
+			continue;
+		}
+		record->stamps[stage] = now;
+		record->stages |= 1 << stage;
+		if(stage == TRACE_RESPONSE){
+			complete(record);
+		}
+	}
+}
+
+void LatencyTrace::discard(uint8_t tag){
+	for(uint8_t i = 0; i < LATENCY_TRACE_RECORDS; i++){
+		if(i != current && records[i].stages != 0 && records[i].tag == tag && !(records[i].stages & (1 << TRACE_JSON))){
+			records[i].stages = 0;
+			dropped++;
+		}
+	}
+}
+
+void LatencyTrace::abandon(uint8_t stage){
+	for(uint8_t i = 0; i < LATENCY_TRACE_RECORDS; i++){
+		if(records[i].stages & (1 << stage)){
+			records[i].stages = 0;
+			dropped++;
+		}
+	}
+}
+
+void LatencyTrace::reset(){
+	for(uint8_t i = 0; i < LATENCY_TRACE_RECORDS; i++){
+		records[i].stages = 0;
+	}
+	for(uint8_t i = 0; i < TRACE_STAGES; i++){
+		for(uint8_t j = 0; j < LATENCY_TRACE_BUCKETS; j++){
+			histograms[i][j] = 0;
+		}
+		counts[i] = 0;
+		maxima[i] = 0;
+	}
+	current = -1;
+	completed = 0;
+	dropped = 0;
+}
+
+void LatencyTrace::complete(TraceRecord *record){
+	addSample(TRACE_FIRST_EDGE, record->stamps[TRACE_RESPONSE] - record->stamps[TRACE_FIRST_EDGE]);
+	// The stages of the frame were added when it was tagged
+	for(uint8_t i = TRACE_JSON; i < TRACE_STAGES; i++){
+		addSample(i, record->stamps[i] - record->stamps[i - 1]);
+	}
+	record->stages = 0;
+	completed++;
+}
+
+void LatencyTrace::addSample(uint8_t stage, uint32_t us){
+	uint16_t *bucket = &histograms[stage][bucketOf(us)];
+	// The counts saturate rather than wrap
+	if(*bucket < 0xFFFF){
+		(*bucket)++;
+	}
+	if(counts[stage] < 0xFFFF){
+		counts[stage]++;
+	}
+	if(us > maxima[stage]){
+		maxima[stage] = us;
+	}
+}
+
+// Two buckets per power of two: the bit below the highest one picks the half
+uint8_t LatencyTrace::bucketOf(uint32_t us){
+	if(us < 2){
+		return us;
+	}
+	uint8_t octave = 0;
+	for(uint32_t v = us; v > 1; v >>= 1){
+		octave++;
+	}
+	return octave * 2 + ((us >> (octave - 1)) & 0x01);
+}
+
+uint32_t LatencyTrace::bucketLimit(uint8_t bucket){
+	if(bucket < 2){
+		return bucket;
+	}
+	uint8_t octave = bucket / 2;
+	uint32_t half = (uint32_t) 1 << (octave - 1);
+	uint32_t lower = ((uint32_t) 1 << octave) + (bucket & 0x01) * half;
+	return lower + (half - 1);
+}
+
+uint32_t LatencyTrace::getPercentile(uint8_t stage, uint8_t percent){
+	uint32_t total = 0;
+	for(uint8_t i = 0; i < LATENCY_TRACE_BUCKETS; i++){
+		total += histograms[stage][i];
+	}
+	if(total == 0){
+		return 0;
+	}
+	uint32_t target = (total * percent + 99) / 100;
+	uint32_t seen = 0;
+	for(uint8_t i = 0; i < LATENCY_TRACE_BUCKETS; i++){
+		seen += histograms[stage][i];
+		if(seen >= target){
+			// The bucket can not be worse than the largest sample
+			uint32_t limit = bucketLimit(i);
+			return limit < maxima[stage] ? limit : maxima[stage];
+		}
+	}
+	return maxima[stage];
+}
+
+uint16_t LatencyTrace::getCompleted(){
+	return completed;
+}
+
+uint16_t LatencyTrace::getDropped(){
+	return dropped;
+}
+
+void LatencyTrace::print(Print &out){
+	out.print(F("Latency trace: "));
+	out.print(completed);
+	out.print(F(" windows, "));
+	out.print(dropped);
+	out.println(F(" dropped"));
+	out.println(F("stage\tn\tp50\tp90\tp99\tmax (us)"));
+	for(uint8_t i = 0; i < TRACE_STAGES; i++){
+		out.print(stageNames[i]);
+		out.print('\t');
+		out.print(counts[i]);
+		out.print('\t');
+		out.print(getPercentile(i, 50));
+		out.print('\t');
+		out.print(getPercentile(i, 90));
+		out.print('\t');
+		out.print(getPercentile(i, 99));
+		out.print('\t');
+		out.println(maxima[i]);
+	}
+}
+
+#endif // LATENCY_TRACE
@@ -0,0 +1,151 @@
+// File: LatencyTrace.h
+// Description: Defines trace points that follow each sensor frame from
+// its first radio edge to the acknowledgement of the server and keep
+// per-stage latency histograms.
+
+/**
+ * The Latency Trace timestamps every frame with micros() as it
+ * passes each stage of the pipeline. A record is opened when a
+ * parser finds the sync nibble, using the time of the first edge
+ * of the burst that the decoder saw. Once the frame is validated
+ * and added to the summary of its sensor, its sync and validate
+ * times are added to the histograms. The record of the first frame
+ * of a window then follows the window, and is completed when the
+ * server acknowledges the upload that carried its summary, so the
+ * end-to-end latency is that of the oldest reading in the upload;
+ * the records of the later frames are freed. The histograms have
+ * two buckets per power of two, so p50/p90/p99 are known to
+ * within a quarter or so without keeping the samples.
+ *
+ * Tracing is compiled out unless LATENCY_TRACE is defined, either
+ * below or in the compiler flags; every TRACE_POINT then expands
+ * to nothing and the library takes no RAM.
+ * @file LatencyTrace.h */
+
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include <Arduino.h>
+
+//#define LATENCY_TRACE ///< Define to record the trace points.
+
+#ifdef LATENCY_TRACE
+/** Calls a member of LatencyTrace when tracing is enabled.
+ * @param call The member and its arguments, e.g. mark(TRACE_SEND, micros()). */
+#define TRACE_POINT(call) LatencyTrace::call
+#else
+#define TRACE_POINT(call)
+#endif
+
+#define LATENCY_TRACE_RECORDS 8 ///< Defines the number of frames that can be traced at once: one for the current burst and one for every open or uploading window.
+#define LATENCY_TRACE_STARTS 8 ///< Defines the number of burst start times queued between the ISR and the decoder.
+#define LATENCY_TRACE_BUCKETS 64 ///< Defines the number of buckets in each histogram, two for every bit of a 32 bit time.
+#define TRACE_ANY_TAG 0xFF ///< Defines the tag that matches every record.
+
+/** @enum TraceStage The stages that a frame passes through. The time of
+ * each stage is measured from the stage before it. */
+enum TraceStage{
+	TRACE_FIRST_EDGE, ///< The first edge of the burst in the ISR; its histogram holds the end-to-end latency.
+	TRACE_SYNC, ///< The parser found the sync nibble.
+	TRACE_VALIDATE, ///< The checksum of the frame was valid.
+	TRACE_JSON, ///< The summary of the window was built, measured from the first frame of the window.
+	TRACE_ASSEMBLE, ///< The packet was assembled.
+	TRACE_CONNECT, ///< The TCP connection was opened.
+	TRACE_SEND, ///< The packet was sent.
+	TRACE_RESPONSE, ///< The reply of the server was parsed.
+	TRACE_STAGES ///< The number of stages.
+};
+
+/** A frame that is being traced.
+ * @struct TraceRecord */
+struct TraceRecord{
+	uint32_t stamps[TRACE_STAGES]; ///< The time of each stage in microseconds.
+	uint8_t stages; ///< A bit for every stage that has been stamped, 0 if the record is free.
+	uint8_t tag; ///< The owner of the reading, such as the index of its aggregated sensor.
+};
+
+/** LatencyTrace keeps the trace records and histograms of the whole
+ * program, so all of its members are static.
+ * @class LatencyTrace
+ * @details The ISR calls edgeAfterGap on every edge that ends a pulse
+ * the decoder will treat as a reset, and the decoder calls gapDecoded
+ * when it emits that reset. The two share a short queue of start
+ * times, so the main loop may lag the ISR by up to
+ * LATENCY_TRACE_STARTS bursts and still match every frame to its
+ * first edge. The later stages are stamped with mark; a stage is
+ * only stamped on records that have passed the stage before it. */
+class LatencyTrace
+{
+public:
+	/** Records the first edge of a burst. Called from the ISR.
+	 * @param now The time of the edge in microseconds. */
+	static void edgeAfterGap(uint32_t now);
+	/** Takes the start time of the burst that follows a reset emitted by the decoder. */
+	static void gapDecoded();
+	/** Opens a record for the current burst, or keeps the one that is open for it.
+	 * @param now The time at which the sync nibble was found. */
+	static void sync(uint32_t now);
+	/** Stamps the open record of the current burst as valid.
+	 * @param now The time at which the checksum was checked. */
+	static void validated(uint32_t now);
+	/** Adds the sync and validate times of the current burst to the histograms
+	 * and gives its record to an owner, which is used to stamp the stages of
+	 * its upload. If the owner already has a record that has not reached
+	 * TRACE_JSON, that record follows the window and this one is freed.
+	 * Records that are never tagged are reused by the next frame.
+	 * @param tag The owner of the reading. */
+	static void tagFrame(uint8_t tag);
+	/** Stamps a stage on every record that has passed the stage before it.
+	 * Records are completed, added to the histograms, and freed at TRACE_RESPONSE.
+	 * @param stage The stage.
+	 * @param now The time of the stage in microseconds.
+	 * @param tag Only records with this tag are stamped, or TRACE_ANY_TAG. */
+	static void mark(uint8_t stage, uint32_t now, uint8_t tag = TRACE_ANY_TAG);
+	/** Frees the records of an owner that were never uploaded, as when
+	 * a summary is suppressed.
+	 * @param tag The owner of the readings. */
+	static void discard(uint8_t tag);
+	/** Frees the records of an upload that failed or was dropped.
+	 * @param stage The stage that the records of the upload have reached,
+	 * which keeps the records of a newer upload that has not reached it. */
+	static void abandon(uint8_t stage);
+	/** Clears the histograms and every record. */
+	static void reset();
+	/** Gets the number of windows that were traced to the server. */
+	static uint16_t getCompleted();
+	/** Gets the number of records that were overwritten or freed before completion. */
+	static uint16_t getDropped();
+	/** Estimates a percentile of a stage from its histogram.
+	 * @param stage The stage.
+	 * @param percent The percentile, between 1 and 100.
+	 * @return The upper bound of the bucket holding the percentile in microseconds, or 0 if the stage has no samples. */
+	static uint32_t getPercentile(uint8_t stage, uint8_t percent);
+	/** Prints the count, p50, p90, p99, and maximum of every stage.
+	 * @param &out Where to print, such as Serial. */
+	static void print(Print &out);
+private:
+	/** Adds a sample to the histogram of a stage. */
+	static void addSample(uint8_t stage, uint32_t us);
+	/** Adds the end-to-end time and the stages of the upload of a completed record to the histograms and frees it. */
+	static void complete(TraceRecord *record);
+	/** Gets the bucket of a latency. */
+	static uint8_t bucketOf(uint32_t us);
+	/** Gets the largest latency that falls in a bucket. */
+	static uint32_t bucketLimit(uint8_t bucket);
+
+	static TraceRecord records[LATENCY_TRACE_RECORDS];
+	static uint8_t nextRecord; ///< The slot after the newest record, where the search for a free one starts.
+	static int8_t current; ///< The record of the current burst or -1.
+	static volatile uint32_t starts[LATENCY_TRACE_STARTS];
+	static volatile uint8_t startsQueued; ///< The number of bursts the ISR has seen, modulo 256.
+	static uint8_t startsTaken; ///< The number of resets the decoder has emitted, modulo 256.
+	static uint32_t frameStart; ///< The first edge of the current burst.
+	static boolean frameStartKnown; ///< Whether the first edge of the current burst is known.
+	static uint16_t histograms[TRACE_STAGES][LATENCY_TRACE_BUCKETS];
+	static uint16_t counts[TRACE_STAGES];
+	static uint32_t maxima[TRACE_STAGES];
+	static uint16_t completed;
+	static uint16_t dropped;
+};
+
+#endif // LATENCY_TRACE_H
@@ -3,6 +3,28 @@
 // Static self pointer definition for the ISR
 ManchesterDecoder* ManchesterDecoder::selfPointer;
 
+#define MACHINE_START 0x04u ///< The state flag set until the first long pulse.
+#define MACHINE_HALF_CLOCK 0x02u ///< The state flag set halfway through a bit.
+#define MACHINE_BIT 0x01u ///< The state flag holding the current bit.
+#define MACHINE_STATE 0x07u ///< The flags of a state.
+#define MACHINE_EMIT 0x08u ///< The flag of a transition that outputs the current bit.
+
+/*
+ * The transitions of the state machine, indexed by the state and whether
+ * the pulse is long. A short pulse moves half a bit, a long one toggles the
+ * bit and moves a whole one, and a short pulse at the start counts as long.
+ */
+static const uint8_t transitions[16] PROGMEM = {
+	0x02, 0x09, 0x03, 0x08, 0x08, 0x03, 0x09, 0x02,
+	0x09, 0x09, 0x08, 0x08, 0x03, 0x03, 0x02, 0x02
+};
+
+#if QUANTIZED_PULSES
+#define PULSE_ENTRY(width) quantize(width)
+#else
+#define PULSE_ENTRY(width) (width)
+#endif
+
 /*
  * The Constructor of the ManchesterDecoder class
  */
@@ -11,13 +33,7 @@ ManchesterDecoder::ManchesterDecoder(){
 	pinMode(3, INPUT);
 	// Configures the interrupt pin with internal pullup resistor
   	digitalWrite(3, 1);
-  	// Allocates memory for the buffers
-	data_buffer = new WordBuffer(DEFAULT_SIZE);
-	pulse_buffer = new WordBuffer(DEFAULT_SIZE);
-	// Initializes the member variables
-	halfClock = 1;
-	start = true;
-	state = ZERO;
+  	init();
 	selfPointer = this;
 	// Attaches the interrupt to the IRS on pin change
 	attachInterrupt(1, ManchesterDecoder::isr2, CHANGE);
@@ -25,6 +41,40 @@ ManchesterDecoder::ManchesterDecoder(){
 	interrupts();
 }
 
+/*
+ * The constructor of a decoder that is fed directly
+ */
+ManchesterDecoder::ManchesterDecoder(boolean attach){
+	if(attach){
+		pinMode(3, INPUT);
+		digitalWrite(3, 1);
+	}
+	init();
+	if(attach){
+		selfPointer = this;
+		attachInterrupt(1, ManchesterDecoder::isr2, CHANGE);
+		interrupts();
+	}
+}
+
+void ManchesterDecoder::init(){
+  	// Allocates memory for the buffers
+	data_buffer = new WordBuffer(DECODER_BUFFER_SIZE);
+#if QUANTIZED_PULSES
+	pulse_buffer = new ByteBuffer(DECODER_PULSE_SYMBOLS);
+#else
+	pulse_buffer = new WordBuffer(DECODER_BUFFER_SIZE);
+#endif
+	// Initializes the member variables
+	machine = MACHINE_START | MACHINE_HALF_CLOCK;
+	gateOpen = PREAMBLE_PULSES == 0;
+	preambleCount = 0;
+	preambleLong = false;
+	gatedPulses = 0;
+	decodedPulses = 0;
+	droppedPulses = 0;
+}
+
 /*
  * The destructor of the ManchesterDecoder class
  */
@@ -50,27 +100,96 @@ void ManchesterDecoder::isr2(){
 void ManchesterDecoder::interruptResponder(){
 	// Static variable records the last time when the function was called
 	static word last;
+	unsigned long now = micros();
 	// Computes the time since the last function call
-  	pulse = micros() - last;
+  	pulse = now - last;
   	last += pulse;
-  	// Assumes that the buffer will always be empty
-  	// Insert the pulse into the buffer
-  	pulse_buffer->insert(pulse);
+#if PREAMBLE_PULSES > 0
+  	if(!gateOpen){
+  		// Noise only runs the preamble detector and is never queued
+  		gatedPulses++;
+  		if(pulse < PREAMBLE_MIN_WIDTH || pulse >= MAX_PULSE_WIDTH){
+  			preambleCount = 0;
+  			return;
+  		}
+  		boolean longPulse = pulse >= SHORT_PULSE_LIMIT;
+  		if(preambleCount == 0 || longPulse != preambleLong){
+  			preambleCount = 0;
+  			preambleLong = longPulse;
+#ifdef LATENCY_TRACE
+  			preambleStart = now - pulse;
+#endif
+  		}
+  		if(++preambleCount < PREAMBLE_PULSES){
+  			return;
+  		}
+  		// An even number of pulses was skipped, so starting from a reset keeps the phase of the bits
+  		gateOpen = true;
+  		if(!pulse_buffer->insert(PULSE_ENTRY(0))){
+  			droppedPulses++;
+  		}
+#ifdef LATENCY_TRACE
+  		else{
+  			LatencyTrace::edgeAfterGap(preambleStart);
+  		}
+#endif
+  		return;
+  	}
+  	decodedPulses++;
+  	if(pulse < MIN_PULSE_WIDTH || pulse >= MAX_PULSE_WIDTH){
+  		// The gap that ends the transmission is queued so the decoder resets
+  		gateOpen = false;
+  		preambleCount = 0;
+  	}
+#endif
+  	// Insert the pulse into the buffer, counting it if the buffer is full
+  	if(!pulse_buffer->insert(PULSE_ENTRY(pulse))){
+  		droppedPulses++;
+  	}
+#ifdef LATENCY_TRACE
+  	// The edge that ends a gap is the first edge of the next burst
+  	else if(pulse < MIN_PULSE_WIDTH || pulse >= MAX_PULSE_WIDTH){
+  		LatencyTrace::edgeAfterGap(now);
+  	}
+#endif
 }
 
 /*
  * Resets the member variables.
  */
 void ManchesterDecoder::reset(){
-	halfClock = 0;
-	state = ZERO;
-	start = true;
+	machine = MACHINE_START;
+}
+
+uint32_t ManchesterDecoder::getGatedPulses(){
+	noInterrupts();
+	uint32_t count = gatedPulses;
+	interrupts();
+	return count;
+}
+
+uint32_t ManchesterDecoder::getDecodedPulses(){
+	noInterrupts();
+	uint32_t count = decodedPulses;
+	interrupts();
+	return count;
+}
+
+uint32_t ManchesterDecoder::getDroppedPulses(){
+	noInterrupts();
+	uint32_t count = droppedPulses;
+	interrupts();
+	return count;
 }
 
 boolean ManchesterDecoder::hasNextPulse(){
 	if(!pulse_buffer->isEmpty()){
 		while(!pulse_buffer->isEmpty()){
+#if QUANTIZED_PULSES
+			decodeSymbol(pulse_buffer->remove());
+#else
 			decode(pulse_buffer->remove());
+#endif
 		}
 	}
 	return !data_buffer->isEmpty();
@@ -80,43 +199,36 @@ uint8_t ManchesterDecoder::getNextPulse(){
 	return data_buffer->remove();
 }
 
-void ManchesterDecoder::toggle(unsigned int *state){
-	if(state == ZERO){
-		*state = ONE;
-	}else{
-		*state = ZERO;
+uint8_t ManchesterDecoder::quantize(word width){
+	uint8_t steps = width >= 0x3Fu * PULSE_WIDTH_UNIT ? 0x3Fu : width / PULSE_WIDTH_UNIT;
+	if(width < MIN_PULSE_WIDTH){
+		return PULSE_GLITCH | steps;
 	}
+	if(width < SHORT_PULSE_LIMIT){
+		return PULSE_SHORT | steps;
+	}
+	if(width < MAX_PULSE_WIDTH){
+		return PULSE_LONG | steps;
+	}
+	return PULSE_GAP | steps;
 }
 
 void ManchesterDecoder::decode(word width){
-  	if (50 <= width && width < 1400) {
-		boolean w = width >= 750;
-		switch(w){
-			 // Short pulses increase count by 1
-			// There is a boundary condition between the two protocols
-			case SHORT_PULSE:
-				if(!start){
-					halfClock++;
-			  		break;
-				}
-			 // Long pulses increase count by 2
-			case LONG_PULSE:
-				start = false;
-				if(state == ZERO){
-					state = ONE;
-				}else{
-					state = ZERO;
-				}
-				halfClock+=2;
-				break;
-		}
-		halfClock %= 2;
-		if(halfClock == 0){
-			data_buffer->insert(state);
+	decodeSymbol(quantize(width));
+}
+
+void ManchesterDecoder::decodeSymbol(uint8_t symbol){
+	uint8_t kind = PULSE_CLASS(symbol);
+	if(kind == PULSE_SHORT || kind == PULSE_LONG){
+		uint8_t next = pgm_read_byte(&transitions[(machine << 1) | (kind == PULSE_LONG)]);
+		machine = next & MACHINE_STATE;
+		if(next & MACHINE_EMIT){
+			data_buffer->insert(next & MACHINE_BIT ? ONE : ZERO);
 		}
-  	}
-  	else{
+	}
+	else{
 		data_buffer->insert(RESET);
+		TRACE_POINT(gapDecoded());
 		reset();
-  	}
-}
\ No newline at end of file
+	}
+}
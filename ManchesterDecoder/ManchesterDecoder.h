@@ -21,6 +21,19 @@
  * One consideration that must be made is that
  * the code was designed to be used with a device
  * that supports interrupts on the specified pin.
+ * Between transmissions the receiver puts out noise,
+ * so the ISR keeps the pulses away from the decoder
+ * until it sees a preamble: PREAMBLE_PULSES pulses in
+ * a row that are all short or all long, as the ones
+ * (V3) or the alternating ones and zeros (V2.1) of an
+ * Oregon Scientific preamble are. The gate closes again
+ * at the gap that ends the transmission.
+ * The decoder only tells four kinds of pulse apart, so
+ * unless QUANTIZED_PULSES is 0 the ISR classifies each
+ * pulse and queues a single byte, its class and a coarse
+ * width, which buffers twice the pulses in the same RAM.
+ * The state machine is a table indexed by its state and
+ * the class of the pulse.
  * @author Joel D. Sabol
  * @date June 2014
  * @file ManchesterDecoder.h */
@@ -30,11 +43,35 @@
 
 #include <Arduino.h>
 #include <WordBuffer.h>
+#include <ByteBuffer.h>
+#include <LatencyTrace.h>
 
 #define LONG_PULSE 1  ///< Defines a long pulse as 1.
 #define SHORT_PULSE 0 ///< Defines a shor pulse as 0.
 
-#define DEFAULT_SIZE 1024u ///< Defines the default size of the input and output buffers.
+#define MIN_PULSE_WIDTH 50u ///< Defines the shortest pulse that is not noise (in microseconds).
+#define SHORT_PULSE_LIMIT 750u ///< Defines the width at which a pulse becomes long (in microseconds).
+#define MAX_PULSE_WIDTH 1400u ///< Defines the width at which a pulse becomes a gap that resets the decoder (in microseconds).
+
+#ifndef PREAMBLE_PULSES
+#define PREAMBLE_PULSES 16u ///< Defines the number of pulses of a preamble that open the gate to the decoder, which must be even; 0 decodes every pulse.
+#endif
+#define PREAMBLE_MIN_WIDTH 200u ///< Defines the shortest pulse that counts toward a preamble (in microseconds).
+
+#define DECODER_BUFFER_SIZE 255u ///< Defines the size of the input and output buffers, which WordBuffer limits to 255.
+
+#ifndef QUANTIZED_PULSES
+#define QUANTIZED_PULSES 1 ///< Defines whether the ISR queues each pulse as one byte, its class and a coarse width; 0 queues the width in a word.
+#endif
+#define DECODER_PULSE_SYMBOLS (2u * DECODER_BUFFER_SIZE) ///< Defines the number of pulses the quantized input buffer holds, in the RAM of DECODER_BUFFER_SIZE widths.
+
+#define PULSE_GLITCH 0x00u ///< Defines the class of a pulse shorter than MIN_PULSE_WIDTH.
+#define PULSE_SHORT 0x40u ///< Defines the class of a pulse shorter than SHORT_PULSE_LIMIT.
+#define PULSE_LONG 0x80u ///< Defines the class of a pulse shorter than MAX_PULSE_WIDTH.
+#define PULSE_GAP 0xC0u ///< Defines the class of any longer pulse, which resets the decoder.
+#define PULSE_CLASS(symbol) ((symbol) & 0xC0u) ///< Gets the class of a quantized pulse.
+#define PULSE_WIDTH_UNIT 32u ///< Defines the step of the coarse width kept in the low 6 bits of a quantized pulse (in microseconds).
+#define PULSE_WIDTH(symbol) (((symbol) & 0x3Fu) * PULSE_WIDTH_UNIT) ///< Gets the coarse width of a quantized pulse, at most 2016 (in microseconds).
 
 #define RESET 0xFFu ///< Defines reset as 0xFF so the parser will know that the decoder timed out.
 #define ONE 0x08u ///< Defines One as 0x80 so it can be shifted into the variable.
@@ -44,6 +81,10 @@ class ManchesterDecoder{
 public:
 	/** The Default Constructor */
 	ManchesterDecoder();
+	/** The constructor for a decoder that may be fed from somewhere
+	 * other than the pin, such as a capture file on a host.
+	 * @param attach Whether to attach the ISR to interrupt 1. */
+	ManchesterDecoder(boolean attach);
 	/** The Destructor */
 	~ManchesterDecoder();
 	/** Gets the next result from the decoder (ZERO, ONE, RESET). 
@@ -54,34 +95,45 @@ public:
 	boolean hasNextPulse();
 	/** Resets the decoder by clearing the input and output buffers and re-initializing the state machine. */
 	void reset();
+	/** Decodes the pulse width and updates the state machine, which could in turn add data to the data buffer.
+	 * The ISR queues its pulses for this; a decoder that is not attached is fed by calling it directly.
+	 * @param width The time between two edges in microseconds. */
+	void decode(word width);
+	/** Updates the state machine with a quantized pulse, as queued by the ISR.
+	 * @param symbol The class of the pulse and its coarse width. */
+	void decodeSymbol(uint8_t symbol);
+	/** Quantizes a pulse into its class and coarse width.
+	 * @param width The time between two edges in microseconds.
+	 * @return The class in the high 2 bits and the width in PULSE_WIDTH_UNIT steps in the low 6 bits. */
+	static uint8_t quantize(word width);
+	/** Gets the number of pulses that the preamble gate kept from the decoder. */
+	uint32_t getGatedPulses();
+	/** Gets the number of pulses that passed the preamble gate and were queued for the decoder.
+	 * Neither count is kept when PREAMBLE_PULSES is 0. */
+	uint32_t getDecodedPulses();
+	/** Gets the number of pulses dropped because the input buffer was full. */
+	uint32_t getDroppedPulses();
 private:
+	/** Allocates the buffers and initializes the state machine. */
+	void init();
 	/** The private static interrupt service routine.
 	 * Responds to the interrupts by calling the interrupt handler. */
 	static void isr2();
 	/** The private virtual iterrupt handler which is called by the isr. */
 	void virtual interruptResponder();
-	/** Decodes the pulse width and updates the state machine, which could in turn add data to the data buffer. */
-	void decode(word width);
-	/** A helper function used to toggle the state of the state machine. */
-	void toggle(unsigned int *state);
 	/** The static self pointer which is necessary in order for the interrupt
 	 * handler to be able to add data to the input buffer. */
 	static ManchesterDecoder* selfPointer;
-	/** The state variable used by the state machine. */
-	unsigned int state;
-
-	/** A variable used by the state machine to determine what state to go to next.
-	 * It also determines whether the given pulse was valid or if it produced output. */
-	uint8_t halfClock;
-	/** A boolean variable which is used to ensure that special
-	 * considerations are met when decoding the manchester encoded
-	 * data fro the Oregon Scientific Sensors. This is because the
-	 * version 3.0 and 2.1 protocols differ in the way in which
-	 * they start their messages. In version 3.0 messages you do
-	 * not consider the first transition to be decoded as a logical
-	 * 1, whereas in the version 2.1 protocol you do in order to
-	 * prodce the correct output. */
-	boolean start;
+	/** The state of the state machine: the start flag, the half clock and the
+	 * current bit. The start flag ensures that special considerations are met
+	 * when decoding the manchester encoded data fro the Oregon Scientific
+	 * Sensors. This is because the version 3.0 and 2.1 protocols differ in
+	 * the way in which they start their messages. In version 3.0 messages you
+	 * do not consider the first transition to be decoded as a logical 1,
+	 * whereas in the version 2.1 protocol you do in order to prodce the
+	 * correct output. The half clock determines whether a pulse completed a
+	 * bit, which is then output. */
+	uint8_t machine;
 	/** The volatile variable pulse is used to record the time
 	 * between transition on the data line. It must volatile,
 	 * because it appears to the compiler that the value should
@@ -89,8 +141,28 @@ private:
 	 * inside an isr it does change thereby requiring the volatile
 	 * keyword.*/
 	volatile word pulse;
+	/** Whether a preamble has been seen and pulses are queued for the decoder. */
+	volatile boolean gateOpen;
+	/** The number of pulses in the current run of pulses of the same kind. */
+	uint8_t preambleCount;
+	/** Whether the current run is of long pulses. */
+	boolean preambleLong;
+#ifdef LATENCY_TRACE
+	/** The time of the first edge of the current run. */
+	unsigned long preambleStart;
+#endif
+	/** The number of pulses kept from the decoder. */
+	volatile uint32_t gatedPulses;
+	/** The number of pulses queued for the decoder. */
+	volatile uint32_t decodedPulses;
+	/** The number of pulses dropped because the input buffer was full. */
+	volatile uint32_t droppedPulses;
 	/** The input buffer in which the pulse values are stored. */
+#if QUANTIZED_PULSES
+	ByteBuffer *pulse_buffer;
+#else
 	WordBuffer *pulse_buffer;
+#endif
 	/** The data buffer in which the decoded data is placed. */
 	WordBuffer *data_buffer;
 };
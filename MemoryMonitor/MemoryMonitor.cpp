@@ -0,0 +1,195 @@
+#include <MemoryMonitor.h>
+
+#ifdef __AVR__
+extern char __heap_start;
+extern char *__brkval;
+/** A block on the free list of the malloc of avr-libc. */
+struct __freelist{
+	size_t sz;
+	struct __freelist *nx;
+};
+extern struct __freelist *__flp;
+// Left alone by the startup code, so it still holds the last run after a reset
+#define MEMORY_NOINIT __attribute__((section(".noinit")))
+#else
+#include <malloc.h>
+#include <unistd.h>
+#define MEMORY_NOINIT
+#endif
+
+static uint16_t magic MEMORY_NOINIT; ///< MEMORY_MAGIC once the marks below are valid.
+static uintptr_t heapPeak MEMORY_NOINIT; ///< The highest top of the heap.
+static uintptr_t heapPeakCheck MEMORY_NOINIT; ///< The complement of heapPeak, which tells a reset from a power up.
+
+static uintptr_t heapBase; ///< The bottom of the heap.
+static uintptr_t paintBottom; ///< The address of the lowest byte that was painted.
+static uintptr_t stackTop; ///< The address of the byte above the stack.
+static boolean lastRun = false;
+static size_t lastStackUsed = 0;
+static size_t lastHeapPeak = 0;
+
+/*
+ * Gets the top of the heap, above which malloc has handed nothing out.
+ */
+static uintptr_t heapMark(){
+#ifdef __AVR__
+	return (uintptr_t) (__brkval != 0 ? __brkval : __malloc_heap_start);
+#else
+	return (uintptr_t) sbrk(0);
+#endif
+}
+
+/*
+ * Gets the lowest byte at or above from that is not paint, which is the
+ * deepest the stack has reached.
+ */
+static uint8_t *deepestStack(uint8_t *from, uint8_t *to){
+	while(from < to && *from == MEMORY_PAINT){
+		from++;
+	}
+	return from;
+}
+
+#ifndef __AVR__
+/*
+ * Paints the stack below the frame of its caller, which the functions
+ * called after it reuse. Only the address of the paint is kept, since
+ * the area itself is gone once this returns.
+ */
+static void __attribute__((noinline)) paintHostStack(){
+	volatile uint8_t area[MEMORY_HOST_STACK];
+	for(size_t i = 0; i < MEMORY_HOST_STACK; i++){
+		area[i] = MEMORY_PAINT;
+	}
+	paintBottom = (uintptr_t) area;
+	stackTop = paintBottom + MEMORY_HOST_STACK;
+}
+#endif
+
+void MemoryMonitor::begin(){
+#ifdef __AVR__
+	uint8_t *sp = (uint8_t *) SP;
+	if(magic == MEMORY_MAGIC && heapPeakCheck == (uintptr_t) ~heapPeak
+		&& heapPeak >= (uintptr_t) &__heap_start && heapPeak < (uintptr_t) sp){
+		// The paint of the last run is still there, below the little stack used since the reset
+		lastStackUsed = (uint8_t *) RAMEND + 1 - deepestStack((uint8_t *) heapPeak, sp);
+		lastHeapPeak = heapPeak - (uintptr_t) &__heap_start;
+		lastRun = true;
+	}
+	heapBase = (uintptr_t) &__heap_start;
+	paintBottom = heapMark();
+	stackTop = (uintptr_t) RAMEND + 1;
+	for(uint8_t *p = (uint8_t *) paintBottom; p < sp; p++){
+		*p = MEMORY_PAINT;
+	}
+#else
+	// The heap of the host is only followed from here on
+	heapBase = heapMark();
+	paintHostStack();
+#endif
+	heapPeak = heapMark();
+	heapPeakCheck = ~heapPeak;
+	magic = MEMORY_MAGIC;
+}
+
+void MemoryMonitor::sample(){
+	uintptr_t mark = heapMark();
+	if(mark > heapPeak){
+		heapPeak = mark;
+		heapPeakCheck = ~mark;
+	}
+}
+
+size_t MemoryMonitor::getStackUsed(){
+	uint8_t *from = (uint8_t *) paintBottom;
+#ifdef __AVR__
+	// The heap may have grown into the paint
+	from = (uint8_t *) heapPeak;
+#endif
+	return (uint8_t *) stackTop - deepestStack(from, (uint8_t *) stackTop);
+}
+
+size_t MemoryMonitor::getHeapPeak(){
+	return heapPeak - heapBase;
+}
+
+size_t MemoryMonitor::getUntouched(){
+#ifdef __AVR__
+	uint8_t *from = (uint8_t *) heapPeak;
+#else
+	uint8_t *from = (uint8_t *) paintBottom;
+#endif
+	return deepestStack(from, (uint8_t *) stackTop) - from;
+}
+
+size_t MemoryMonitor::getFreeListBytes(){
+#ifdef __AVR__
+	size_t total = 0;
+	for(struct __freelist *block = __flp; block != NULL; block = block->nx){
+		total += block->sz;
+	}
+	return total;
+#else
+	return mallinfo2().fordblks;
+#endif
+}
+
+size_t MemoryMonitor::getLargestFreeBlock(){
+#ifdef __AVR__
+	size_t largest = 0;
+	for(struct __freelist *block = __flp; block != NULL; block = block->nx){
+		if(block->sz > largest){
+			largest = block->sz;
+		}
+	}
+	return largest;
+#else
+	// The C library does not show its blocks, so the free space counts as one
+	return mallinfo2().fordblks;
+#endif
+}
+
+uint16_t MemoryMonitor::getFreeBlocks(){
+#ifdef __AVR__
+	uint16_t blocks = 0;
+	for(struct __freelist *block = __flp; block != NULL; block = block->nx){
+		blocks++;
+	}
+	return blocks;
+#else
+	return mallinfo2().ordblks;
+#endif
+}
+
+boolean MemoryMonitor::hasLastRun(){
+	return lastRun;
+}
+
+size_t MemoryMonitor::getLastStackUsed(){
+	return lastStackUsed;
+}
+
+size_t MemoryMonitor::getLastHeapPeak(){
+	return lastHeapPeak;
+}
+
+void MemoryMonitor::print(Print &out){
+	out.print(F("Stack used: "));
+	out.print(getStackUsed());
+	out.print(F(" heap peak: "));
+	out.print(getHeapPeak());
+	out.print(F(" untouched: "));
+	out.println(getUntouched());
+	out.print(F("Free list: "));
+	out.print(getFreeListBytes());
+	out.print(F(" in "));
+	out.print(getFreeBlocks());
+	out.print(F(" blocks, largest "));
+	out.println(getLargestFreeBlock());
+	if(lastRun){
+		out.print(F("Before reset stack used: "));
+		out.print(lastStackUsed);
+		out.print(F(" heap peak: "));
+		out.println(lastHeapPeak);
+	}
+}
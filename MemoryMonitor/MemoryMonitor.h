@@ -0,0 +1,67 @@
+// File: MemoryMonitor.h
+// Description: Defines the instrumentation that records how deep the
+// stack and how high the heap have grown, and how fragmented the heap is.
+
+/**
+ * The Memory Monitor paints the free RAM between the heap and the
+ * stack with a known byte when the program starts. The stack wipes
+ * the paint out as it grows down, so the lowest byte of paint left
+ * above the heap marks the deepest the stack has been, and the paint
+ * that is left is the RAM that neither has ever touched.
+ * avr-libc offers no hooks into malloc and the Arduino core owns
+ * operator new, so the heap is followed through the allocator's own
+ * state: the top of the heap is sampled for its peak, and the free
+ * list is walked to see how fragmented it is.
+ *
+ * On the device the peak of the heap is kept in RAM that is not
+ * cleared at reset, and the paint survives a reset as well, so after
+ * the watchdog resets a unit the marks of the run that crashed can
+ * still be read. On the host the stack below the caller of begin is
+ * painted instead, the heap is followed from begin on, and the free
+ * list is read from the C library, which only tells its total.
+ * @file MemoryMonitor.h */
+
+#ifndef MEMORY_MONITOR_H
+#define MEMORY_MONITOR_H
+
+#include <Arduino.h>
+
+#define MEMORY_PAINT 0xC5 ///< Defines the byte that the free RAM is painted with.
+#define MEMORY_MAGIC 0x4D4Du ///< Defines the mark that the RAM kept through a reset is valid.
+#define MEMORY_HOST_STACK 16384u ///< Defines the bytes of stack painted on the host.
+
+/** MemoryMonitor keeps the memory marks of the whole program, so all
+ * of its members are static.
+ * @class MemoryMonitor */
+class MemoryMonitor
+{
+public:
+	/** Reads the marks left by the run before a reset, then paints the
+	 * free RAM. Called first thing in setup, while the stack is shallow. */
+	static void begin();
+	/** Samples the top of the heap. Called on every pass of the main loop. */
+	static void sample();
+	/** Gets the most stack that has been used, in bytes. Scans the paint. */
+	static size_t getStackUsed();
+	/** Gets the most heap that has been used, in bytes. */
+	static size_t getHeapPeak();
+	/** Gets the RAM between the heap and the stack that neither has touched, in bytes. */
+	static size_t getUntouched();
+	/** Gets the bytes on the free list of the heap, which only allocations that fit a block can reuse. */
+	static size_t getFreeListBytes();
+	/** Gets the largest block on the free list, in bytes. */
+	static size_t getLargestFreeBlock();
+	/** Gets the number of blocks on the free list. */
+	static uint16_t getFreeBlocks();
+	/** Checks whether begin found the marks of the run before a reset. */
+	static boolean hasLastRun();
+	/** Gets the most stack the run before the reset used, in bytes. */
+	static size_t getLastStackUsed();
+	/** Gets the most heap the run before the reset used, in bytes. */
+	static size_t getLastHeapPeak();
+	/** Prints the marks, and those of the run before the reset if there are any.
+	 * @param &out Where to print them, such as Serial. */
+	static void print(Print &out);
+};
+
+#endif // MEMORY_MONITOR_H
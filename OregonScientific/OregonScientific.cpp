@@ -1,15 +1,17 @@
 #include <OregonScientific.h>
 
 OregonScientific::OregonScientific(){
-	data = new uint8_t[DEFAULT_SIZE];
+	data = new uint8_t[OSC_MESSAGE_SIZE];
 	numSensors = 0;
-	messageSize = DEFAULT_SIZE;
+	messageSize = OSC_MESSAGE_SIZE;
+	rssi = UNKNOWN_RSSI;
 	reset();
 }
 
-OregonScientific::OregonScientific(uint8_t messageSize = DEFAULT_SIZE){
+OregonScientific::OregonScientific(uint8_t messageSize = OSC_MESSAGE_SIZE){
 	data = new uint8_t[messageSize];
 	OregonScientific::messageSize = messageSize;
+	rssi = UNKNOWN_RSSI;
 	reset();
 }
 
@@ -32,6 +34,10 @@ OregonScientificSensor* OregonScientific::getCurrentSensor(){
 	return currentSensor;
 }
 
+uint8_t* OregonScientific::getMessage(){
+	return data;
+}
+
 void OregonScientific::printResults(uint8_t protocol){
   Serial.println();
   switch(protocol){
@@ -101,6 +107,7 @@ boolean OregonScientific::parseOregonScientificV2(uint8_t value){
 			case SYNCING:
 				if(data[idx] == 0x0A){
 					state = GET_ID;
+					TRACE_POINT(sync(micros()));
 					subNibbleCount = 0;
 				}
 				break;
@@ -147,6 +154,7 @@ boolean OregonScientific::parseOregonScientificV3(uint8_t value){
 			case SYNCING:
 				if(data[idx] == 0x0A){
 					state = GET_ID;
+					TRACE_POINT(sync(micros()));
 					//idx++;
 					subNibbleCount = 0;
 				}
@@ -186,6 +194,12 @@ void OregonScientific::addSensor(OregonScientificSensor *sen1){
 	numSensors++;
 }
 
+void OregonScientific::removeSensors(){
+	numSensors = 0;
+	currentSensor = NULL;
+	reset();
+}
+
 boolean OregonScientific::findSensor(){
 	id_type temp;
 	// Reverse copy the data into the union to convert
@@ -206,13 +220,34 @@ boolean OregonScientific::findSensor(){
 }
 
 boolean OregonScientific::validate(uint8_t value){
+	if(!checksumMatches(data, value + 3)){
+		return false;
+	}
+	TRACE_POINT(validated(micros()));
+	return true;
+}
+
+boolean OregonScientific::checksumMatches(const uint8_t *message, uint8_t messageSize){
+	uint8_t value = messageSize - 3;
 	// Converts the checksum to a single integer value for comparison
-	uint8_t chksum_dev = (data[value+1] << 4) | data[value];
+	uint8_t chksum_dev = (message[value+1] << 4) | message[value];
 	uint8_t chksum_computed = 0;
 	// Computes the checksum of the message
 	for(uint8_t i = DEV_ID_BEGIN; i < value; i++){
-		chksum_computed += data[i];
+		chksum_computed += message[i];
 	}
+	return chksum_computed == chksum_dev;
+}
+
+boolean OregonScientific::hasFailedMessage(){
+	// A message that validated has already been handed over and the parser reset
+	return state == DONE && !checksumMatches(data, messageSize);
+}
+
+void OregonScientific::setRssi(int16_t rssi){
+	OregonScientific::rssi = rssi;
+}
 
-	return (chksum_computed == chksum_dev);
-}
\ No newline at end of file
+int16_t OregonScientific::getRssi(){
+	return rssi;
+}
@@ -11,11 +11,12 @@
 
 #include <Arduino.h>
 #include <OregonScientificSensor.h>
+#include <LatencyTrace.h>
 
 #define SYNC_NIBBLE 0 ///< Defines the location of the sync nibble in the message.
 #define OSCV_3 0x33	 ///< Defines the version 3.0 protocol.
 #define OSCV_2_1 0x21 ///< Defines the version 2.1 protocol.
-#define DEFAULT_SIZE 32 ///< Defines the size of the message if none is provided.
+#define OSC_MESSAGE_SIZE 32 ///< Defines the size of the message buffer of a parser if none is provided.
 #define MAX_SENSOR_NUM 10 ///< Defines the maximum number of sensors that the parser will listen for.
 #define DEV_ID_BEGIN 0 ///< Defines the location of the start of the device id in the message.
 #define DEV_ID_END 3 ///< Defines the location of the end of the device id in the message.
@@ -24,6 +25,7 @@
 #define ROLLING_CODE_END 6 ///< Defines the end of the rolling code in the message.
 #define FLAGS 7 ///< Defines where the flags are in the message.
 #define MESSAGE_BEGIN 8 ///< Defines the location of the data segment in the message.
+#define UNKNOWN_RSSI -128 ///< Defines the RSSI of a message whose signal strength is not known (in dBm).
 
 /** @enum OregonScientific_ParseStates The states that the parser
  * can be in while parsing the message. */
@@ -70,6 +72,9 @@ public:
 	* device id - channel id combination.
 	* @param *sensor The sensor that will be listened for by the parser.*/
 	void addSensor(OregonScientificSensor *sensor);
+	/** Stops listening for every sensor, as before the sensors are
+	 * generated again. The sensors themselves are not freed. */
+	void removeSensors();
 	/** Prints the results of the two sensors that this code has been tested with*/
 	virtual void printResults(uint8_t protocol);
 	/** Allows the parser to be reset manually. Though it is
@@ -77,6 +82,27 @@ public:
 	virtual void reset();
 	/** Returns the sensor that sent the message. */
 	OregonScientificSensor* getCurrentSensor();
+	/** Returns the nibbles of the message that was parsed.
+	 * The message is only valid until the parser is reset. */
+	uint8_t* getMessage();
+	/** Checks whether the parser holds a whole message from one of its
+	 * sensors that failed its checksum, which would be thrown away by
+	 * the next reset. The message and sensor are still available.
+	 * @return True if the message was received but did not validate. */
+	boolean hasFailedMessage();
+	/** Computes the checksum of a message, the sum of the nibbles
+	 * before it, and compares it with the one that was sent.
+	 * @param *message The nibbles of the message.
+	 * @param messageSize The size of the message as given by its sensor.
+	 * @return True if the checksums matched, false otherwise. */
+	static boolean checksumMatches(const uint8_t *message, uint8_t messageSize);
+	/** Sets the strength of the signal the current message was received with,
+	 * which stays until another is set.
+	 * @param rssi The strongest RSSI of the burst (in dBm). */
+	void setRssi(int16_t rssi);
+	/** Returns the strength of the signal the current message was received with
+	 * (in dBm), or UNKNOWN_RSSI if none was set. */
+	int16_t getRssi();
 private:
 	/** Validates the message by computing the checksum and
 	* checking to see if it matches the checksum that was sent
@@ -112,6 +138,8 @@ private:
 	OregonScientific_ParseState state;
 	/** The array that holds the message. */
 	uint8_t *data;	
+	/** The RSSI of the burst that held the message. */
+	int16_t rssi;
 };
 
 #endif // OREGON_SCIENTIFIC_H
\ No newline at end of file
@@ -0,0 +1,224 @@
+/** Contains the functions that summarize the readings of the sensors
+ * over a window so that one summary per sensor is uploaded to the
+ * server in place of every message that is received. A summary is
+ * only uploaded when the reporting policy of the sensor allows it.
+ * @file Aggregation.ino */
+
+/** The titles of the fields that are aggregated, in the order that they are kept. */
+const char* const AGGREGATED_TITLES[AGGREGATOR_MAX_FIELDS] = {"Temp", "Humidity"};
+
+/** @struct aggregated_sensor Pairs a sensor with the summary of its readings. */
+struct aggregated_sensor{
+  OregonScientificSensor *sensor; ///< The sensor whose readings are summarized.
+  SensorAggregator *aggregate; ///< The summary of the current window.
+  int8_t fields[AGGREGATOR_MAX_FIELDS]; ///< The index of each aggregated field in the format of the sensor.
+  const char *titles[AGGREGATOR_MAX_FIELDS]; ///< The title of each aggregated field.
+  ReportingPolicy *policy; ///< Decides whether the summary is uploaded.
+  boolean battery_low; ///< The battery flag of the latest message.
+  boolean report_due; ///< Whether the summary is reported by the next sendCompleteWindows before its window ends.
+};
+
+aggregated_sensor aggregated_sensors[MAX_AGGREGATED_SENSORS]; ///< The sensors whose readings are summarized
+uint8_t num_aggregated_sensors = 0; ///< The number of sensors whose readings are summarized
+
+SensorAggregator dht22_aggregate(2, AGGREGATION_WINDOW_MS); ///< The summary of the DHT22 readings
+ReportingPolicy dht22_policy(2, MAX_SILENCE_MS); ///< Decides whether the DHT22 summary is uploaded
+
+/** Sets the deadbands of the DHT22, which are those of the Oregon Scientific sensors. */
+void setupDHT22Policy(){
+  dht22_policy.setDeadband(0, TEMP_DEADBAND);
+  dht22_policy.setDeadband(1, HUMIDITY_DEADBAND);
+}
+
+/** Registers a sensor so that its readings are summarized.
+ * @param *sensor The sensor that will be summarized.
+ * @param *deadbands The deadband of each of AGGREGATED_TITLES, in the units of the field.
+ * @param maxSilence The longest time the sensor goes unreported (in milliseconds).
+ * @return The sensor so that the call can be passed straight to addSensor. */
+OregonScientificSensor* addAggregatedSensor(OregonScientificSensor *sensor, const int16_t *deadbands, uint32_t maxSilence){
+  if(num_aggregated_sensors >= MAX_AGGREGATED_SENSORS){
+    return sensor;
+  }
+  aggregated_sensor *entry = &aggregated_sensors[num_aggregated_sensors];
+  int16_t field_deadbands[AGGREGATOR_MAX_FIELDS];
+  uint8_t num_fields = 0;
+  for(uint8_t i = 0; i < AGGREGATOR_MAX_FIELDS; i++){
+    int8_t field = sensor->getFieldIndex(AGGREGATED_TITLES[i]);
+    if(field >= 0){
+      entry->fields[num_fields] = field;
+      entry->titles[num_fields] = AGGREGATED_TITLES[i];
+      field_deadbands[num_fields] = deadbands[i];
+      num_fields++;
+    }
+  }
+  entry->sensor = sensor;
+  entry->aggregate = new SensorAggregator(num_fields, AGGREGATION_WINDOW_MS);
+  entry->policy = new ReportingPolicy(num_fields, maxSilence);
+  for(uint8_t i = 0; i < num_fields; i++){
+    entry->policy->setDeadband(i, field_deadbands[i]);
+  }
+  entry->battery_low = false;
+  entry->report_due = false;
+  num_aggregated_sensors++;
+  return sensor;
+}
+
+/** Removes every sensor along with its summary, whose current window
+ * is dropped, and frees them. */
+void clearAggregatedSensors(){
+  for(uint8_t i = 0; i < num_aggregated_sensors; i++){
+    aggregated_sensor *entry = &aggregated_sensors[i];
+    delete entry->policy;
+    delete entry->aggregate;
+    delete entry->sensor;
+  }
+  num_aggregated_sensors = 0;
+}
+
+/** Adds the reading in a validated message to the summary of the sensor that sent it.
+ * A change of the battery flag is reported by the next sendCompleteWindows,
+ * which only runs once the device is activated, rather than from here,
+ * where messages are also decoded while the server is being reached.
+ * @param *sensor The sensor that sent the message.
+ * @param *message The nibbles of the message. */
+void aggregateMessage(OregonScientificSensor *sensor, uint8_t *message){
+  for(uint8_t i = 0; i < num_aggregated_sensors; i++){
+    aggregated_sensor *entry = &aggregated_sensors[i];
+    if(entry->sensor == sensor){
+      TRACE_POINT(tagFrame(i));
+      int16_t values[AGGREGATOR_MAX_FIELDS];
+      for(uint8_t j = 0; j < entry->aggregate->getNumFields(); j++){
+        values[j] = sensor->decodeField(message, entry->fields[j]);
+      }
+      entry->aggregate->addReading(values, millis());
+      entry->battery_low = (message[FLAGS] & 0x04) != 0;
+      if(entry->policy->batteryChanged(entry->battery_low)){
+        entry->report_due = true;
+      }
+      return;
+    }
+  }
+}
+
+/** Adds the latest reading of the DHT22 to its summary. The humidity is
+ * uploaded under the title of the Oregon Scientific sensors, so it is
+ * kept in whole percent like theirs rather than the tenths the DHT22 reads. */
+void aggregateDHT22(){
+  int16_t values[2] = {dht22.temperatureTenths, (int16_t) (dht22.humidityTenths / 10)};
+  dht22_aggregate.addReading(values, millis());
+}
+
+/** Assembles the JSON string that holds the summary of a window.
+ * @param dev_id The device id of the sensor.
+ * @param channel The channel of the sensor.
+ * @param *aggregate The summary of the window.
+ * @param **titles The title of each aggregated field.
+ * @param suppressed The number of readings that were suppressed since the previous summary.
+ * @param *battery The battery state or NULL if the sensor does not report one.
+ * @return The sensor_datum JSON string. */
+String assembleSummaryJSON(String dev_id, String channel, SensorAggregator *aggregate, const char * const *titles, uint16_t suppressed, const char *battery){
+  String js = "\"sensor_datum\":{\"DevID\":\"";
+  js += dev_id;
+  js += "\",\"Channel\":\"";
+  js += channel;
+  js += "\",\"Count\":\"";
+  js += aggregate->getCount();
+  js += "\",\"Suppressed\":\"";
+  js += suppressed;
+  js += "\"";
+  if(battery != NULL){
+    js += ",\"Battery\":\"";
+    js += battery;
+    js += "\"";
+  }
+  for(uint8_t i = 0; i < aggregate->getNumFields(); i++){
+    js += ",\"";
+    js += titles[i];
+    js += "\":\"";
+    js += aggregate->getMean(i);
+    js += "\",\"";
+    js += titles[i];
+    js += "_min\":\"";
+    js += aggregate->getMinimum(i);
+    js += "\",\"";
+    js += titles[i];
+    js += "_max\":\"";
+    js += aggregate->getMaximum(i);
+    js += "\",\"";
+    js += titles[i];
+    js += "_last\":\"";
+    js += aggregate->getLast(i);
+    js += "\"";
+  }
+  js += "}";
+  return js;
+}
+
+/** Converts the device id of a sensor into the form used in its JSON messages.
+ * @param *sensor The sensor.
+ * @return The nibbles of the device id in the order that they are received. */
+String sensorIDString(OregonScientificSensor *sensor){
+  uint32_t id = sensor->getSensorID();
+  String dev_id = "";
+  for(uint8_t i = 0; i < 4; i++){
+    dev_id += to_hex(id >> (8 * i));
+  }
+  return dev_id;
+}
+
+/** Gets the mean of every field of a window.
+ * @param *aggregate The summary of the window.
+ * @param *means The buffer that receives the mean of every field. */
+void windowMeans(SensorAggregator *aggregate, int16_t *means){
+  for(uint8_t i = 0; i < aggregate->getNumFields(); i++){
+    means[i] = aggregate->getMean(i);
+  }
+}
+
+/** Uploads the summary of the current window of a sensor if its policy allows it
+ * and starts the next window.
+ * @param idx The index of the sensor in aggregated_sensors. */
+void reportWindow(uint8_t idx){
+  aggregated_sensor *entry = &aggregated_sensors[idx];
+  int16_t means[AGGREGATOR_MAX_FIELDS];
+  windowMeans(entry->aggregate, means);
+  if(entry->policy->shouldReport(means, entry->battery_low, entry->aggregate->getCount(), millis())){
+    String channel = "";
+    channel += to_hex(entry->sensor->getSensorChannel());
+    String json = generateDeviceJSON(assembleSummaryJSON(sensorIDString(entry->sensor), channel, entry->aggregate, entry->titles,
+                                                         entry->policy->getSuppressedBeforeReport(), entry->battery_low ? "Low" : "Ok"));
+    TRACE_POINT(mark(TRACE_JSON, micros(), idx));
+    assemblePacket(json);
+  }
+  else{
+    TRACE_POINT(discard(idx));
+#ifdef DEVELOPMENT
+    Serial.print(F("Suppressed "));
+    Serial.print(entry->policy->getSuppressed());
+    Serial.print(F(" readings, reported "));
+    Serial.println(entry->policy->getReported());
+#endif
+  }
+  entry->aggregate->reset();
+  entry->report_due = false;
+}
+
+/** Reports the summary of every window that has ended or whose battery flag
+ * changed, and starts the next window. */
+void sendCompleteWindows(){
+  uint32_t now = millis();
+  for(uint8_t i = 0; i < num_aggregated_sensors; i++){
+    if(aggregated_sensors[i].report_due || aggregated_sensors[i].aggregate->windowComplete(now)){
+      reportWindow(i);
+    }
+  }
+  if(dht22_aggregate.windowComplete(now)){
+    int16_t means[2];
+    windowMeans(&dht22_aggregate, means);
+    if(dht22_policy.shouldReport(means, false, dht22_aggregate.getCount(), now)){
+      assemblePacket(generateDeviceJSON(assembleSummaryJSON("DHT", "22", &dht22_aggregate, AGGREGATED_TITLES,
+                                                            dht22_policy.getSuppressedBeforeReport(), NULL)));
+    }
+    dht22_aggregate.reset();
+  }
+}
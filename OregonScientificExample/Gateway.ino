@@ -0,0 +1,26 @@
+/** Contains the gateway environment, in which every validated frame
+ * goes out of the Serial port as a framed binary record for a computer
+ * next to the receiver, in place of the summaries sent to the server.
+ * The records are laid out in SerialGateway.h.
+ * @file Gateway.ino */
+
+#ifdef GATEWAY
+SerialGateway gateway(Serial); ///< Writes the records to the Serial port
+uint32_t gateway_dropped = 0; ///< The pulses the decoder had dropped when the last record was sent
+
+/** Sends the message a parser holds as one record.
+ * @param &parser The parser that holds the message.
+ * @param protocol The protocol of the parser, OSCV_2_1 or OSCV_3.
+ * @param repaired Whether the message was repaired from its repeat. */
+void sendFrame(OregonScientific &parser, uint8_t protocol, boolean repaired){
+  OregonScientificSensor *sensor = parser.getCurrentSensor();
+  uint8_t flags = repaired ? GATEWAY_FLAG_REPAIRED : 0;
+  uint32_t dropped = md.getDroppedPulses();
+  if(dropped != gateway_dropped){
+    flags |= GATEWAY_FLAG_DROPPED;
+    gateway_dropped = dropped;
+  }
+  gateway.sendFrame(millis(), sensor->getSensorID(), sensor->getSensorChannel(), protocol,
+    flags, parser.getRssi(), parser.getMessage(), sensor->getMessageSize());
+}
+#endif
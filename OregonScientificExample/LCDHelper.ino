@@ -1,54 +1,184 @@
 /** Contains the helper functions for the LCD.
+ * The helpers only write to a shadow framebuffer; lcd_flush sends
+ * the cells that changed to the LCD, at most once every
+ * LCD_FLUSH_INTERVAL_MS, so status updates never block the path
+ * from the radio to the server. A status that replaces the screen waits
+ * until the one before it has been shown for LCD_MIN_STATUS_MS, so a short
+ * lived status such as "Querying Server" is still seen.
  * @file LCDHelper.ino */
 
+char lcd_frame[LCD_ROWS][LCD_COLS]; ///< The text that should be on the LCD
+char lcd_shown[LCD_ROWS][LCD_COLS]; ///< The text that is on the LCD
+char lcd_pending[LCD_STATUS_QUEUE][LCD_ROWS][LCD_COLS]; ///< The statuses that wait to be shown before lcd_frame, oldest first
+uint8_t lcd_pending_count = 0; ///< The number of statuses in lcd_pending
+boolean lcd_frame_new = false; ///< Whether lcd_frame holds a status that has not been shown yet
+uint32_t lcd_last_flush = 0; ///< The time at which the LCD was last flushed
+uint32_t lcd_status_since = 0; ///< The time at which the status on the LCD was first shown
+boolean lcd_immediate = true; ///< Whether every update is flushed right away, used during setup when the main loop is not running
+
+/** Initializes the LCD and the framebuffers. */
+void lcd_begin(){
+  lcd.begin(LCD_COLS, LCD_ROWS);
+  lcd.clear();
+  for(uint8_t row = 0; row < LCD_ROWS; row++){
+    for(uint8_t col = 0; col < LCD_COLS; col++){
+      lcd_frame[row][col] = ' ';
+      lcd_shown[row][col] = ' ';
+    }
+  }
+}
+
+/** Sends the cells of the next status that differ from the LCD.
+ * The next status is the oldest pending one, or the framebuffer once none
+ * are pending. A new status is held back until the one on the LCD has been
+ * shown for LCD_MIN_STATUS_MS; changes to the status on the LCD are not.
+ * Each run of changed cells costs one cursor move plus one write per cell.
+ * @param force Whether to flush the framebuffer even if LCD_FLUSH_INTERVAL_MS
+ * or LCD_MIN_STATUS_MS has not passed, which drops the pending statuses. */
+void lcd_flush(boolean force){
+  if(force){
+    lcd_pending_count = 0;
+    lcd_frame_new = true;
+  }
+  else{
+    if(millis() - lcd_last_flush < LCD_FLUSH_INTERVAL_MS){
+      return;
+    }
+    if((lcd_pending_count > 0 || lcd_frame_new) && millis() - lcd_status_since < LCD_MIN_STATUS_MS){
+      return;
+    }
+  }
+  lcd_last_flush = millis();
+  char (*next)[LCD_COLS] = lcd_pending_count > 0 ? lcd_pending[0] : lcd_frame;
+  if(lcd_pending_count > 0 || lcd_frame_new){
+    lcd_status_since = millis();
+  }
+  for(uint8_t row = 0; row < LCD_ROWS; row++){
+    boolean in_run = false;
+    for(uint8_t col = 0; col < LCD_COLS; col++){
+      if(next[row][col] == lcd_shown[row][col]){
+        in_run = false;
+        continue;
+      }
+      if(!in_run){
+        lcd.setCursor(col, row);
+        in_run = true;
+      }
+      lcd.write(next[row][col]);
+      lcd_shown[row][col] = next[row][col];
+    }
+  }
+  if(lcd_pending_count > 0){
+    lcd_pending_count--;
+    memmove(lcd_pending[0], lcd_pending[1], lcd_pending_count * sizeof(lcd_pending[0]));
+  }
+  else{
+    lcd_frame_new = false;
+  }
+}
+
+/** Starts a status that replaces the screen.
+ * If the status in the framebuffer has not been shown yet it is queued
+ * behind the other pending ones, unless LCD_STATUS_QUEUE are already
+ * pending, in which case the new status overwrites it. */
+void lcd_new_status(){
+  if(lcd_frame_new && lcd_pending_count < LCD_STATUS_QUEUE){
+    memcpy(lcd_pending[lcd_pending_count++], lcd_frame, sizeof(lcd_frame));
+  }
+  lcd_frame_new = true;
+}
+
+/** Flushes the framebuffer right away while the device is being set up. */
+void lcd_update(){
+  if(lcd_immediate){
+    lcd_flush(true);
+  }
+}
+
+/** Sets whether every update is flushed right away or left for the main loop.
+ * @param immediate True to flush on every update. */
+void lcd_set_immediate(boolean immediate){
+  lcd_immediate = immediate;
+  lcd_update();
+}
+
+/** Writes text into the framebuffer.
+ * @param col The column of the first character.
+ * @param row The row of the text.
+ * @param *message The text, which is cut off at the edge of the screen.
+ * @return The column after the last character. */
+uint8_t lcd_write(uint8_t col, uint8_t row, const char *message){
+  while(*message != '\0' && col < LCD_COLS){
+    lcd_frame[row][col++] = *message++;
+  }
+  return col;
+}
+
+/** Fills part of a row of the framebuffer with spaces.
+ * @param col The first column to clear.
+ * @param row The row to clear.
+ * @param len The number of columns to clear. */
+void lcd_clear_cells(uint8_t col, uint8_t row, uint8_t len){
+  while(len-- > 0 && col < LCD_COLS){
+    lcd_frame[row][col++] = ' ';
+  }
+}
 
 /** Clears the entire screen then prints the specified string on the top line.
  * @param message The message to be displayed on the top line of the screen. */
 void lcd_print_top(char* message) {
-  lcd.clear();
-  lcd.print(message);
+  lcd_new_status();
+  lcd_clear_cells(0, 0, LCD_COLS);
+  lcd_clear_cells(0, 1, LCD_COLS);
+  lcd_write(0, 0, message);
+  lcd_update();
 }
 
 /** Clears the bottom line of the LCD screen before printing the desired message there.
  * @param message The message to be printed on the bottom line of the LCD. */
 void lcd_print_bottom(char* message) {
-  // Clears the bottom row of the lcd
-  lcd.setCursor(0,1);
-  lcd.print("                ");
-  // Prints the message
-  lcd.setCursor(0,1);
-  lcd.print(message);
+  lcd_clear_cells(0, 1, LCD_COLS);
+  lcd_write(0, 1, message);
+  lcd_update();
 }
 
 /** Prints a countdown in the bottom left corner of the LCD display.
  * @param val The value to be displayed in the bottom left corner. */
 void lcd_print_countdown(uint16_t val){
-  uint8_t cursor_pos;
-  if(val > 9){
-    cursor_pos = 14;
-  }
-  else if(val > 100){
-    cursor_pos = 13;
-  }
-  else{
-    cursor_pos = 15;
-  }
-  lcd.setCursor(12, 1);
-  lcd.print("    ");
-  lcd.setCursor(cursor_pos, 1);
-  lcd.print(val);
+  char buffer[6];
+  itoa(val, buffer, 10);
+  lcd_clear_cells(12, 1, 4);
+  lcd_write(LCD_COLS - strlen(buffer), 1, buffer);
+  lcd_update();
 }
 
 /** A helper function that will print the DHT22 temperature and humidity to the LCD.
- * @param temp The temperature provided by the DHT22.
- * @param humid The humidity provided by the DHT22.*/
-void lcd_print_dht22(double temp, double humid){
-  lcd.clear();
-  lcd.setCursor(0,0);
-  lcd.print("Temp: ");
-  lcd.print(temp);
-  lcd.setCursor(0,1);
-  lcd.print("Humid: ");
-  lcd.print(humid);
+ * @param temp The temperature provided by the DHT22 in tenths of a degree.
+ * @param humid The humidity provided by the DHT22 in tenths of a percent.*/
+void lcd_print_dht22(int16_t temp, int16_t humid){
+  lcd_new_status();
+  lcd_clear_cells(0, 0, LCD_COLS);
+  lcd_clear_cells(0, 1, LCD_COLS);
+  lcd_write_tenths(lcd_write(0, 0, "Temp: "), 0, temp);
+  lcd_write_tenths(lcd_write(0, 1, "Humid: "), 1, humid);
+  lcd_update();
 }
 
+/** Writes a fixed point value with one decimal place into the framebuffer.
+ * @param col The column of the first character.
+ * @param row The row of the value.
+ * @param val The value in tenths. */
+void lcd_write_tenths(uint8_t col, uint8_t row, int16_t val){
+  char buffer[9];
+  uint8_t len = 0;
+  if(val < 0){
+    buffer[len++] = '-';
+    val = -val;
+  }
+  itoa(val / 10, buffer + len, 10);
+  len = strlen(buffer);
+  buffer[len++] = '.';
+  buffer[len++] = '0' + val % 10;
+  buffer[len] = '\0';
+  lcd_write(col, row, buffer);
+}
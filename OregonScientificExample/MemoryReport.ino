@@ -0,0 +1,70 @@
+/** Contains the list of the buffers of the program and the RAM that
+ * each takes, worked out when compiling from the sizes in header.h and
+ * in the libraries. The build fails if together they exceed
+ * RAM_BUFFER_BUDGET, and the development environment prints the list
+ * next to the stack and heap marks of the MemoryMonitor.
+ * @file MemoryReport.ino */
+
+#if QUANTIZED_PULSES
+#define RAM_PULSES (DECODER_PULSE_SYMBOLS + 1) ///< The pulses queued by the ISR (in bytes)
+#else
+#define RAM_PULSES (DECODER_BUFFER_SIZE * sizeof(word)) ///< The pulses queued by the ISR (in bytes)
+#endif
+#define RAM_BITS (DECODER_BUFFER_SIZE * sizeof(word)) ///< The bits decoded from the pulses (in bytes)
+#define RAM_MESSAGES (2 * OSC_MESSAGE_SIZE) ///< The messages of the two parsers (in bytes)
+#define RAM_REPAIR (sizeof(FrameRepair)) ///< The failed messages held for repair (in bytes)
+#define RAM_SUMMARIES ((MAX_AGGREGATED_SENSORS + 1) * (sizeof(SensorAggregator) + sizeof(ReportingPolicy)) \
+  + MAX_AGGREGATED_SENSORS * sizeof(aggregated_sensor)) ///< The summaries and policies of the sensors and the DHT22 (in bytes)
+#define RAM_SENSORS (sizeof(SensorConfig)) ///< The configuration of the sensors that is listened for (in bytes)
+#define RAM_REPLIES (UPLOAD_REPLY_SIZE + BUILDING_REPLY_SIZE + 2) ///< The replies kept from the server (in bytes)
+#define RAM_LCD (2 * LCD_ROWS * LCD_COLS) ///< The framebuffers of the LCD (in bytes)
+#define RAM_TX_CHUNK (TX_CHUNK_SIZE) ///< The chunk of the body staged on the stack while sending (in bytes)
+#ifdef LATENCY_TRACE
+#define RAM_TRACE (LATENCY_TRACE_RECORDS * sizeof(TraceRecord) + LATENCY_TRACE_STARTS * sizeof(uint32_t) \
+  + TRACE_STAGES * (LATENCY_TRACE_BUCKETS * sizeof(uint16_t) + sizeof(uint16_t) + sizeof(uint32_t))) ///< The records and histograms of the latency trace (in bytes)
+#else
+#define RAM_TRACE 0 ///< The latency trace takes no RAM when it is compiled out
+#endif
+
+#define RAM_BUFFERS (RAM_PULSES + RAM_BITS + RAM_MESSAGES + RAM_REPAIR + RAM_SUMMARIES + RAM_SENSORS \
+  + RAM_REPLIES + RAM_LCD + RAM_TX_CHUNK + RAM_TRACE) ///< The RAM of every buffer listed (in bytes)
+
+/** Fails to compile, with an array of negative size, when the buffers exceed their budget. */
+typedef char buffers_exceed_RAM_BUFFER_BUDGET[RAM_BUFFERS <= RAM_BUFFER_BUDGET ? 1 : -1];
+
+/** @struct buffer_size A buffer and the RAM it takes. */
+struct buffer_size{
+  char name[10]; ///< The name that is printed.
+  uint16_t bytes; ///< The RAM it takes (in bytes).
+};
+
+/** The buffers of the program, kept in flash. */
+const buffer_size buffer_sizes[] PROGMEM = {
+  {"pulses", RAM_PULSES},
+  {"bits", RAM_BITS},
+  {"messages", RAM_MESSAGES},
+  {"repair", RAM_REPAIR},
+  {"summaries", RAM_SUMMARIES},
+  {"sensors", RAM_SENSORS},
+  {"replies", RAM_REPLIES},
+  {"lcd", RAM_LCD},
+  {"tx chunk", RAM_TX_CHUNK},
+  {"trace", RAM_TRACE}
+};
+
+/** Prints the RAM of every buffer against the budget, then the stack
+ * and heap marks of the MemoryMonitor. */
+void reportMemory(){
+  char name[sizeof(buffer_sizes[0].name)];
+  for(uint8_t i = 0; i < sizeof(buffer_sizes) / sizeof(buffer_sizes[0]); i++){
+    strcpy_P(name, buffer_sizes[i].name);
+    Serial.print(name);
+    Serial.print('\t');
+    Serial.println(pgm_read_word(&buffer_sizes[i].bytes));
+  }
+  Serial.print(F("Buffers: "));
+  Serial.print((uint16_t) RAM_BUFFERS);
+  Serial.print(F(" of "));
+  Serial.println(RAM_BUFFER_BUDGET);
+  MemoryMonitor::print(Serial);
+}
@@ -1,36 +1,53 @@
 /** Oregon Scientific Example is the main program
  * that handles the configuration and the main loop
  * of the program.
- * @todo Add the ability to dynamicall add and remove sensors.
  * @file OregonScientificExample.ino */
 
 #include <WildFire.h>
 #include <WildFire_CC3000.h>
 #include <WordBuffer.h>
+#include <ByteBuffer.h>
+#include <LatencyTrace.h>
+#include <MemoryMonitor.h>
 #include <ManchesterDecoder.h>
+#include <RFM69OOK.h>
 #include <OregonScientific.h>
 #include <OregonScientificSensor.h>
+#include <FrameRepair.h>
+#include <SerialGateway.h>
+#include <SensorConfig.h>
+#include <HTTPResponseParser.h>
+#include <SensorAggregator.h>
+#include <ReportingPolicy.h>
 #include <LiquidCrystal.h>
 #include <dht.h>
 #include <SPI.h>
 #include <TinyWatchdog.h>
 #include "header.h"
 
+#if defined(GATEWAY) && (defined(DEVELOPMENT) || defined(CONFIG))
+#error "GATEWAY sends binary records over Serial, so it cannot be combined with DEVELOPMENT or CONFIG"
+#endif
+
 
 WildFire wf; ///< The instantiation of the WildFire
 WildFire_CC3000 cc3000; ///< The instantiation of the CC3000 radio
 TinyWatchdog tinyWDT; ///< The Watchdog Timer
 ManchesterDecoder md; ///< The Manchester Decoder
+RFM69OOK radio(RFM69_SS_PIN); ///< The RFM69 that receives the sensors
+uint32_t last_message_pass = 0; ///< The time processMessages last read the queued pulses
 OregonScientific oscv3; ///< The Oregon Scientific Version 3.0 Parser
 OregonScientific oscv2; ///< Oregon Scientific Version 2.1 parser
-
-char packet_buffer[MAX_PACKET_LENGTH]; ///< The packet buffer used to hold the packet
+FrameRepair frameRepair(FRAME_REPAIR_WINDOW_MS, FRAME_REPAIR_MAX_DIFFS); ///< Recovers messages that failed their checksum from their repeats
 
 char address[13] = {
   '0','8','0','0','2','8','5','7','5','A','0','E'}; ///< The hard-coded device address: This really should not be this way, however there is an issue with reading the MAC address from the CC3000 which when run keeps it from connecting to the server via TCP. 
 
 int building_id = -1; ///< The variable holding the id of the building that the device is currently in
 
+SensorConfig sensor_config; ///< The sensors the device listens for, kept in the EEPROM
+boolean sensor_config_changed = false; ///< Set when the server sent a configuration that the sensors have not been generated from yet
+
 LiquidCrystal lcd(LCD_RS, LCD_E, LCD_D4, LCD_D5, LCD_D6, LCD_D7); ///< The instantiation of the LCD
 
 dht dht22; ///<  The instantiation of the DHT22 object
@@ -71,30 +88,51 @@ void stringToByteArr(String msg, char *data){
 }
 
 
-/** Reads the DHT22 until it returns a valid reading
- * then prints out that reading.                  */
+#ifdef __AVR__
+/** Hands the pin changes of the port that holds the DHT22 pin to the
+ * library, which leaves the vector to the sketch. */
+ISR(DHTLIB_PCINT_vect){
+  dht::_edgeISR();
+}
+#endif
+
+/** Starts a reading of the DHT22 in the background.
+ * The reading is finished by serviceDHT22. */
 void readDHT22(){
+  dht22.startRead22(DHT22_PIN, DHT22_RETRIES);
+}
+
+/** Advances the background reading of the DHT22 and
+ * prints out the reading once it is available.
+ * @return Whether a new reading is available. */
+boolean serviceDHT22(){
+  int rv = dht22.update();
+  if(rv != DHTLIB_OK){
 #ifdef DEVELOPMENT
-  Serial.print("DHT22, \t");
+    if(rv != DHTLIB_BUSY && rv != DHTLIB_IDLE){
+      Serial.println("DHT22 failed");
+    }
 #endif
-  while(dht22.read22(DHT22_PIN) != DHTLIB_OK);
+    return false;
+  }
 #ifdef DEVELOPMENT
-  Serial.print(dht22.humidity, 1);
+  Serial.print("DHT22, \t");
+  Serial.print(dht22.humidityTenths);
   Serial.print(",\t");
-  Serial.println(dht22.temperature, 1);
+  Serial.println(dht22.temperatureTenths);
 #endif
-  lcd_print_dht22(dht22.temperature, dht22.humidity);
+  lcd_print_dht22(dht22.temperatureTenths, dht22.humidityTenths);
+  aggregateDHT22();
+  return true;
 }
 
 /** Assembles the necessary information to create the JSON string that contains the data from the DHT22. */
 String assembleDHT22JSON(){
-  char msg[DATA_MAX_LENGTH] = {
-    '\0'      };
   String temp = "\"sensor_datum\":{\"Temp\":\"";
-  temp += (int)dht22.temperature * 10;
+  temp += dht22.temperatureTenths;
   temp += "\", \"Channel\":\"22\", \"DevID\":\"DHT\",";
   temp += "\"humidity\":\"";
-  temp += (int)dht22.humidity;
+  temp += dht22.humidityTenths / 10;
   temp += "\"}";
   return temp;
 }
@@ -103,7 +141,8 @@ String assembleDHT22JSON(){
  * and pets it if enough time has elapsed.    */
 void checkNPet(){
   current_time = millis();
-  if(current_time - time_last_pet >= 2000){
+  // The cast keeps the difference correct when millis() wraps the 16 bits
+  if((uint16_t)(current_time - time_last_pet) >= 2000){
 #ifdef DEVELOPMENT 
     Serial.print(".");
 #endif
@@ -111,9 +150,10 @@ void checkNPet(){
     time_last_pet = current_time;
   }
 }
-/** Generates the JSON object that contains the data as well as the building id and the device address. */
-
-void generateDeviceJSON(String sensor_msg, char *msg){
+/** Generates the JSON object that contains the data as well as the building id and the device address.
+ * @param sensor_msg The JSON message produced by the sensor.
+ * @return The JSON object that forms the payload of the packet. */
+String generateDeviceJSON(String sensor_msg){
   String js = "{";
   js += sensor_msg;
   js += ",\"building_id\":\"";
@@ -122,36 +162,108 @@ void generateDeviceJSON(String sensor_msg, char *msg){
   js += address;
   js += "\"}";
   lcd_print_bottom("Got Message");
-  js.toCharArray(msg, js.length()+1);
+  return js;
+}
+
+/** Hands a message that failed its checksum to the frame repair
+ * before the parser is reset, and hands it on like any other
+ * message if it was repaired.
+ * @param &parser The parser that may hold a failed message.
+ * @param protocol The protocol of the parser, OSCV_2_1 or OSCV_3. */
+void repairMessage(OregonScientific &parser, uint8_t protocol){
+  if(parser.hasFailedMessage()){
+    if(frameRepair.repair(parser.getCurrentSensor(), parser.getMessage(), millis())){
+      lcd_print_top("Fixed Message");
+      handleMessage(parser, protocol, true);
+    }
+  }
+}
+
+/** Hands the strongest RSSI of the burst to the parser that
+ * holds a message from it.
+ * @param &parser The parser that holds the message. */
+void noteRssi(OregonScientific &parser){
+  parser.setRssi(radio.getBurstRssi());
+#ifdef DEVELOPMENT
+  Serial.print(F("RSSI: "));
+  Serial.println(parser.getRssi());
+#endif
+}
+
+/** Hands a validated message on: to the summary of its sensor, or in
+ * the gateway environment straight out of the Serial port.
+ * @param &parser The parser that holds the message.
+ * @param protocol The protocol of the parser, OSCV_2_1 or OSCV_3.
+ * @param repaired Whether the message was repaired from its repeat. */
+void handleMessage(OregonScientific &parser, uint8_t protocol, boolean repaired){
+  noteRssi(parser);
+#ifdef GATEWAY
+  sendFrame(parser, protocol, repaired);
+#else
+  (void) protocol;
+  (void) repaired;
+  aggregateMessage(parser.getCurrentSensor(), parser.getMessage());
+#endif
+}
+
+/** Prints how many pulses the preamble gate kept from the decoder
+ * for every pulse it let through, which shows how much of the
+ * radio noise never reaches the decoder. */
+void reportDecoderLoad(){
+  uint32_t gated = md.getGatedPulses();
+  uint32_t decoded = md.getDecodedPulses();
+  Serial.print(F("Pulses gated: "));
+  Serial.print(gated);
+  Serial.print(F(" decoded: "));
+  Serial.print(decoded);
+  if(decoded > 0){
+    Serial.print(F(" ratio: "));
+    Serial.print(gated / decoded);
+  }
+  Serial.println();
 }
 
 /** Processes the data as it comes from the Manchester Decoder
- * and passes it to the parser to be interpreted. */
+ * and passes it to the parser to be interpreted. Validated
+ * messages are added to the summary of the sensor that sent them,
+ * and version 2.1 messages that failed are given a chance to be
+ * repaired first. The RSSI is read while the pulses are drained,
+ * so after a stall of the loop, such as a blocking upload, the
+ * queued bursts may have ended and the RSSI would read the noise
+ * floor. No RSSI is read on such a pass, which leaves the bursts
+ * drained by it at what was read before the stall, or unknown. */
 void processMessages(){
+  uint32_t now = millis();
+  boolean stalled = now - last_message_pass > RSSI_STALE_MS;
+  last_message_pass = now;
+  boolean sampled = stalled;
   while(md.hasNextPulse()){
     uint8_t data = md.getNextPulse();
     //Serial.print(data, HEX);
     // If value indicates timeout then resetParser
     if(data == RESET){
+      // Only version 2.1 sensors repeat their messages, so a failed
+      // version 3 message is never held where it could push one out
+      repairMessage(oscv2, OSCV_2_1);
       resetParser();
+      radio.clearBurstRssi();
+      sampled = stalled;
     } // Otherwise put the data in both parsers
     else{
-      char payload[DATA_MAX_LENGTH] = {
-        '\0'            };
+      // The burst is still on the air, so its RSSI is read once per pass
+      if(!sampled){
+        radio.sampleRssi();
+        sampled = true;
+      }
       if(oscv3.parseOregonScientificV3(data)){
         // Gets the sensor that broad-casted the message and print it.
         lcd_print_top("Got Message");
-        generateDeviceJSON(oscv3.getCurrentSensor()->getJSONMessage(), payload);
-        assemblePacket(payload);
-        lcd_print_top("Sent Message");
+        handleMessage(oscv3, OSCV_3, false);
         resetParser();
-        //readDHT22();
-        //generateDeviceJSON(assembleDHT22JSON(), payload);
-        //assemblePacket(payload);
       }
       else if(oscv2.parseOregonScientificV2(data)){
-        generateDeviceJSON(oscv2.getCurrentSensor()->getJSONMessage(), payload);
-        assemblePacket(payload);
+        lcd_print_top("Got Message");
+        handleMessage(oscv2, OSCV_2_1, false);
         resetParser();
       }
     }
@@ -161,13 +273,14 @@ void processMessages(){
 
 /** Performs all of the initializations along with all of the necessary configurations. */
 void setup(){
+  // Paints the free RAM before the stack grows
+  MemoryMonitor::begin();
   // Initializes the WildFire
   wf.begin();
   // Configures the WDT and check method
   time_last_pet = 0;
   tinyWDT.begin(1000, 60000);
-  lcd.begin(16,2);
-  lcd.clear();
+  lcd_begin();
   lcd_print_top("Welcome to");
   lcd_print_bottom("Home Monitor");
   delay(1000);
@@ -178,9 +291,22 @@ void setup(){
   Serial.println(F("Compiled on " __DATE__ ", " __TIME__));
   Serial.println(F("Server is " HOST));
 #endif
-  for(uint16_t i = 0; i < MAX_PACKET_LENGTH; i++){
-    packet_buffer[i] = '\0';
+#ifdef GATEWAY
+  Serial.begin(GATEWAY_BAUD);
+#endif
+#ifdef DEVELOPMENT
+  reportMemory();
+#endif
+  // Tunes the RFM69 before the CC3000 shares the bus with it
+  if(!radio.begin(RFM69_FREQUENCY_HZ, RFM69_RSSI_THRESHOLD_DBM, RFM69_OOK_FLOOR_DB)){
+#ifdef DEVELOPMENT
+    Serial.println(F("No RFM69 found"));
+#endif
   }
+  // Listens for the sensors kept in the EEPROM before the network is reached
+  setupDHT22Policy();
+  loadSensors();
+#ifndef GATEWAY
   // IF the connection attempts to the network fail sleep
   if(!connectToNetwork()){
     // TODO put the wildfire to sleep
@@ -199,35 +325,70 @@ void setup(){
 #endif
     }
     delay(500);
+    processMessages();
   }
   checkNPet();
 #ifdef DEVELOPMENT
   Serial.println("Resolved the server");
 #endif
-  // Adds sensors with the appropriate message formats
-  oscv2.addSensor(new OregonScientificSensor(THGR122NX, V2_CHANNEL_1, 7, OregonScientificSensor::THGR122NX_FORMAT, OregonScientificSensor::THGR122NX_TITLES));
-  oscv2.addSensor(new OregonScientificSensor(THGR122NX, V2_CHANNEL_3, 7, OregonScientificSensor::THGR122NX_FORMAT, OregonScientificSensor::THGR122NX_TITLES));
-  oscv3.addSensor(new OregonScientificSensor(THWR800, V2_CHANNEL_1, 6, OregonScientificSensor::THWR800_FORMAT, OregonScientificSensor::THWR800_TITLES));
-
+#endif // GATEWAY
   lcd_print_top("Listening 492Mhz");
+  // From here on the main loop flushes the LCD
+  lcd_set_immediate(false);
 }
 
-/** The main loop that controls the operation of the device by using a state machine. */
+/** The main loop that controls the operation of the device by using a state machine.
+ * Nothing in the loop waits on the server; replies are read by serviceServer. */
 void loop(){
   device_states state = PING_SERVER;
+  uint32_t last_query = millis() - QUERY_INTERVAL_MS;
+  uint32_t last_dht22_read = millis() - DHT22_INTERVAL_MS;
+#ifdef LATENCY_TRACE
+  uint32_t last_trace_report = millis();
+#endif
 #ifdef DEVELOPMENT
+  uint32_t last_decoder_report = millis();
+  uint32_t last_memory_report = millis();
   Serial.println("Listening on 433.92Mhz");
 #endif
   while(1){
+    MemoryMonitor::sample();
     checkNPet();
-    switch(state){
-    case PING_SERVER:
-      lcd_print_top("Querying Server");
-      building_id = getBuilding();
+    serviceServer();
+    serviceDHT22();
+    lcd_flush(false);
+#ifdef GATEWAY
+    // The computer on the other end of Serial does the rest
+    processMessages();
+    continue;
+#endif
+#ifdef LATENCY_TRACE
+    if(millis() - last_trace_report >= LATENCY_REPORT_INTERVAL_MS){
+      LatencyTrace::print(Serial);
+      last_trace_report = millis();
+    }
+#endif
 #ifdef DEVELOPMENT
-      Serial.print("B_ID");
-      Serial.println(building_id);
+    if(millis() - last_decoder_report >= DECODER_REPORT_INTERVAL_MS){
+      reportDecoderLoad();
+      last_decoder_report = millis();
+    }
+    if(millis() - last_memory_report >= MEMORY_REPORT_INTERVAL_MS){
+      reportMemory();
+      last_memory_report = millis();
+    }
 #endif
+    switch(state){
+    case PING_SERVER:
+      // The sensors are known from boot, so their messages are decoded while the server is reached
+      processMessages();
+      if(sensor_config_changed){
+        state = GEN_SENSOR;
+        break;
+      }
+      if(buildingQueryPending()){
+        break;
+      }
       if(building_id > 0){
 #ifdef DEVELOPMENT
         Serial.println("Activated");
@@ -235,27 +396,40 @@ void loop(){
         lcd_print_top("Activated");
         state = ACTIVATED;
       }
-      else{
-        lcd_print_top("Not In Building");
-        lcd_print_bottom("Add to Building");
-        delay(10000);
+      else if(millis() - last_query >= QUERY_INTERVAL_MS){
+        lcd_print_top("Querying Server");
+        requestBuilding();
+        last_query = millis();
       }
       break;
     case ACTIVATED:
-      building_id = getBuilding();
       if(building_id < 0){
         state = PING_SERVER;
         lcd_print_top("Deactivated");
       }
+      else if(sensor_config_changed){
+        state = GEN_SENSOR;
+      }
       else{
         processMessages();
-        delay(10000);
+        if(millis() - last_dht22_read >= DHT22_INTERVAL_MS){
+          readDHT22();
+          last_dht22_read = millis();
+        }
+        sendCompleteWindows();
+        if(!buildingQueryPending() && millis() - last_query >= QUERY_INTERVAL_MS){
+          requestBuilding();
+          last_query = millis();
+        }
       }
       break;
     case GEN_SENSOR:
-    break;
+      generateSensors();
+#ifdef DEVELOPMENT
+      Serial.println(F("Sensors generated"));
+#endif
+      state = building_id > 0 ? ACTIVATED : PING_SERVER;
+      break;
     }
   }
 }
-
-
@@ -0,0 +1,70 @@
+/** Contains the configuration of the sensors the device listens for.
+ * It is kept in the EEPROM so that the sensors are generated at boot,
+ * before the network is reached, and the server can replace it in the
+ * reply to the building query, in which case the sensors are generated
+ * again in the GEN_SENSOR state. Devices that have never been sent a
+ * configuration listen for the default sensors.
+ * @file SensorConfiguration.ino */
+
+#if SENSOR_CONFIG_MAX_RECORDS > MAX_AGGREGATED_SENSORS
+#error "Every configured sensor is summarized, so MAX_AGGREGATED_SENSORS must be at least SENSOR_CONFIG_MAX_RECORDS"
+#endif
+
+/** Sets the sensors that are listened for until the server sends others.
+ * @param &config Receives the configuration. */
+void defaultSensorConfig(SensorConfig &config){
+  config.clear();
+  config.add(SENSOR_MODEL_THGR122NX, V2_CHANNEL_1, TEMP_DEADBAND, HUMIDITY_DEADBAND, 0);
+  config.add(SENSOR_MODEL_THGR122NX, V2_CHANNEL_3, TEMP_DEADBAND, HUMIDITY_DEADBAND, 0);
+  config.add(SENSOR_MODEL_THWR800, V2_CHANNEL_1, TEMP_DEADBAND, HUMIDITY_DEADBAND, 0);
+}
+
+/** Loads the configuration kept in the EEPROM, or the default one, and generates its sensors. */
+void loadSensors(){
+  if(!loadSensorConfig(sensor_config)){
+    defaultSensorConfig(sensor_config);
+  }
+  generateSensors();
+}
+
+/** Replaces the sensors of the parsers and their summaries with those of the configuration. */
+void generateSensors(){
+  resetParser();
+  oscv2.removeSensors();
+  oscv3.removeSensors();
+  frameRepair.clear();
+  clearAggregatedSensors();
+  const SensorConfigRecord *records = sensor_config.getRecords();
+  for(uint8_t i = 0; i < sensor_config.getCount(); i++){
+    int16_t deadbands[AGGREGATOR_MAX_FIELDS] = {records[i].tempDeadband, records[i].humidityDeadband};
+    uint32_t max_silence = records[i].silenceMinutes > 0 ? records[i].silenceMinutes * 60000UL : MAX_SILENCE_MS;
+    switch(records[i].model){
+    case SENSOR_MODEL_THGR122NX:
+      oscv2.addSensor(addAggregatedSensor(new OregonScientificSensor(THGR122NX, records[i].channel, 7, OregonScientificSensor::THGR122NX_FORMAT, OregonScientificSensor::THGR122NX_TITLES), deadbands, max_silence));
+      break;
+    case SENSOR_MODEL_THWR800:
+      oscv3.addSensor(addAggregatedSensor(new OregonScientificSensor(THWR800, records[i].channel, 6, OregonScientificSensor::THWR800_FORMAT, OregonScientificSensor::THWR800_TITLES), deadbands, max_silence));
+      break;
+    }
+  }
+  sensor_config_changed = false;
+}
+
+/** Keeps a configuration sent by the server if it differs from the current one.
+ * The sensors are generated from it by the GEN_SENSOR state.
+ * @param *hex The records in hex, as they follow the word "sensors" in the reply. */
+void receiveSensorConfig(const char *hex){
+  SensorConfig pushed;
+  if(!pushed.parseHex(hex)){
+#ifdef DEVELOPMENT
+    Serial.println(F("Bad sensor config"));
+#endif
+    return;
+  }
+  if(pushed.equals(sensor_config)){
+    return;
+  }
+  saveSensorConfig(pushed);
+  sensor_config = pushed;
+  sensor_config_changed = true;
+}
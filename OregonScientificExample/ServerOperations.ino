@@ -7,241 +7,252 @@
 #include <string.h>
 #include <stdlib.h>
 
+WildFire_CC3000_Client upload_client; ///< The connection on which the last packet was sent
+HTTPResponseParser upload_response(UPLOAD_REPLY_SIZE); ///< The parser for the reply to the last packet
+uint32_t upload_sent_at; ///< The time at which the last packet was sent
+boolean upload_pending = false; ///< Whether the reply to the last packet is still being read
+
+WildFire_CC3000_Client building_client; ///< The connection on which the building was queried
+HTTPResponseParser building_response(BUILDING_REPLY_SIZE); ///< The parser for the reply to the building query
+uint32_t building_sent_at; ///< The time at which the building was queried
+boolean building_pending = false; ///< Whether the reply to the building query is still being read
+
 /** Assembles the HTTP packet that will be sent to the server.
- * @param *data The sensor data that will form the payload of the packet.*/
-void assemblePacket(char *data){
+ * The packet is never staged in RAM; the length of the encrypted and
+ * escaped body is computed first so the header can be written, then the
+ * body is encrypted and streamed to the server in TX_CHUNK_SIZE pieces.
+ * @param &data The sensor data that will form the payload of the packet.*/
+void assemblePacket(const String &data){
   lcd_print_top("Assembling Packet");
-  // Clears the packet buffer to make sure that it is not dirty
-  clearPacketBuffer();
 
   // Gets the encryption key 
   char vignere_key[32] = ""; 
   getEncryptionKey(vignere_key);
 
-  // Encrypts the data using the encryption key
-  encrypt(data, vignere_key, data);
+  // The brackets, :, and "s plus the escaped encrypted text
+  uint16_t content_length = 17 + streamEncryptedBody(NULL, data, vignere_key);
+  TRACE_POINT(mark(TRACE_ASSEMBLE, micros()));
 
-  // Begins creating parts of the header
-  char putstr_buffer[64] = "POST /sensor_data/batch_create/";
-  strcat(putstr_buffer,address);
-  strcat_P(putstr_buffer, PSTR(".json HTTP/1.1"));
-
-  int additionalCharacters = 17; // the brackets, :, and "s
-  //Account for characters that will be escaped
-  uint8_t len = strlen(data);
-  for(int i=0; i<len; i++) {
-    if(data[i] == '\\' || data[i]=='"')
-      additionalCharacters++;
-  }
-
-  // Completes the header
-  makePacketHeader(putstr_buffer, "application/json", len + additionalCharacters);
-  strcat_P(packet_buffer, PSTR("\n{\"encrypted\":\""));
+  sendPacket(data, vignere_key, content_length);
+}
 
-  //Copy encrypted text and escape " and \s
-  int packetSize = strlen(packet_buffer);
-  for(int i=0; i<len; i++) {
-    if(data[i] == '"' || data[i] == '\\') {
-      packet_buffer[packetSize] = '\\';
-      packetSize++;
+/** Encrypts the data and escapes " and \s one character at a time.
+ * When a client is given the result is written to it in chunks of
+ * TX_CHUNK_SIZE bytes, otherwise the characters are only counted.
+ * @param *client The client to write the body to or NULL to only count it.
+ * @param &data The plaintext data to encrypt.
+ * @param *key The key used by the cipher.
+ * @return The number of characters in the encrypted and escaped body. */
+uint16_t streamEncryptedBody(WildFire_CC3000_Client *client, const String &data, char *key){
+  char chunk[TX_CHUNK_SIZE];
+  uint8_t chunk_len = 0;
+  uint16_t body_len = 0;
+  uint16_t len = data.length();
+  uint8_t key_len = strlen(key);
+
+  for(uint16_t i = 0; i < len; i++){
+    char c = encryptChar(data.charAt(i), key[i % key_len]);
+    if(c == '"' || c == '\\'){
+      chunk[chunk_len++] = '\\';
+    }
+    chunk[chunk_len++] = c;
+    // Leaves room for an escaped character in the next iteration
+    if(chunk_len >= TX_CHUNK_SIZE - 1){
+      if(client != NULL){
+        client->write(chunk, chunk_len);
+      }
+      body_len += chunk_len;
+      chunk_len = 0;
     }
-    packet_buffer[packetSize] = data[i];
-    packetSize++;
   }
-  packet_buffer[packetSize] = '\0';
-
-  strcat_P(packet_buffer, PSTR("\"}"));
-
-  Serial.println(packet_buffer);
-  sendPacket();
+  if(chunk_len > 0 && client != NULL){
+    client->write(chunk, chunk_len);
+  }
+  return body_len + chunk_len;
 }
 
-/** Generates the packet header given the necessary information.
+/** Writes the packet header to the client given the necessary information.
+ * @param &client The client that the header is written to.
  * @param *request_type_and_location Specifies the HTTP method as well as the URI.
  * @param *mime_type Specifies the type of data that the  packet will be carrying (application-json) etc.
- * @param datalength The length of the data that will be encapsulated in the content section of the packet.
- * @return The packet buffer containing the header.*/
-char *makePacketHeader(char *request_type_and_location, char *mime_type, int datalength) {
-  char len_buffer[32] = "";
+ * @param datalength The length of the data that will be encapsulated in the content section of the packet.*/
+void makePacketHeader(WildFire_CC3000_Client &client, char *request_type_and_location, char *mime_type, int datalength) {
+  char len_buffer[8] = "";
   itoa(datalength, len_buffer, 10);
-  //packet_buffer[0] = '\0';
-  strcat(packet_buffer, request_type_and_location);
-  strcat_P(packet_buffer, PSTR("\nHost: " HOST "\nContent-Type: "));
-  strcat(packet_buffer, mime_type);  
-  strcat_P(packet_buffer, PSTR("; charset=UTF-8\nContent-Length: "));  
-  strcat(packet_buffer, len_buffer);
-  strcat_P(packet_buffer, PSTR("\nConnection: close\n")); 
-
-  return packet_buffer;
-
+  client.fastrprint(request_type_and_location);
+  client.fastrprint(F("\nHost: " HOST "\nContent-Type: "));
+  client.fastrprint(mime_type);
+  client.fastrprint(F("; charset=UTF-8\nContent-Length: "));
+  client.fastrprint(len_buffer);
+  client.fastrprint(F("\nConnection: close\n"));
 }
 
-/** Establishes the TCP connection between the device and the server then sends the packet and reads the servers response.
+/** Establishes the TCP connection between the device and the server then streams the packet.
+ * The reply is read in the background by serviceServer.
+ * @param &data The plaintext sensor data that forms the payload of the packet.
+ * @param *key The encryption key used to encrypt the payload.
+ * @param content_length The length of the content as computed by assemblePacket.
  * @return The whether or not the packet was successfully sent. */
-boolean sendPacket() {
+boolean sendPacket(const String &data, char *key, uint16_t content_length) {
+  // Only one upload reply is tracked at a time
+  if(upload_pending){
+    Serial.println(F("Upload reply dropped"));
+    TRACE_POINT(abandon(TRACE_CONNECT));
+    upload_client.close();
+    upload_pending = false;
+  }
   //Creates and sends a packet of data to the server containing CO2 results and timestamps
   Serial.println(F("Sending data..."));
   lcd_print_top("Sending Data");
-  WildFire_CC3000_Client client = cc3000.connectTCP(ip, LISTEN_PORT);
+  upload_client = cc3000.connectTCP(ip, LISTEN_PORT);
   Serial.println("Established TCP Connection");
+
+  if (!upload_client.connected()) {
+    Serial.println(F("Upload failed"));
+    TRACE_POINT(abandon(TRACE_ASSEMBLE));
+    lcd_print_top("Listening 492Mhz");
+    return false;
+  }
+  TRACE_POINT(mark(TRACE_CONNECT, micros()));
   Serial.println(F("Connected"));
   lcd_print_bottom("Connected");
-#ifdef DEVELOPMENT
-
-#endif
 
-  if (client.connected()) {
-    //Send packet
-    checkNPet();      
-    while(client.available()) { //flushing input buffer, just in case
-      Serial.println(client.read());
-    }
+  //Send packet
+  checkNPet();      
+  while(upload_client.available()) { //flushing input buffer, just in case
+    Serial.println(upload_client.read());
+  }
 
-    client.fastrprintln(packet_buffer);
-    Serial.println(F("Printed"));
-    //#ifdef DEVELOPMENT
+  // Begins creating parts of the header
+  char putstr_buffer[64] = "POST /sensor_data/batch_create/";
+  strcat(putstr_buffer,address);
+  strcat_P(putstr_buffer, PSTR(".json HTTP/1.1"));
+  makePacketHeader(upload_client, putstr_buffer, "application/json", content_length);
 
-    Serial.println("Outgoing request: ");
-    Serial.println(packet_buffer);
-    Serial.println();
-  }
-  //#endif
+  upload_client.fastrprint(F("\n{\"encrypted\":\""));
+  streamEncryptedBody(&upload_client, data, key);
+  upload_client.fastrprintln(F("\"}"));
+  TRACE_POINT(mark(TRACE_SEND, micros()));
   Serial.println(F("Packet sent.\nWaiting for response."));
-  checkNPet();
 
-  int timeLeft = 6000;
-  char headerBuffer[7] = {
-    0,0,0,0,0,0,0                  };
-  while(timeLeft) {
-    if(!strcmp("start\n", headerBuffer) && client.available()) {
-      //When the header is over, and there is one character from the actual body
-      break;
-    }
-
-    if(client.available()) {
-      //Add the new character to the end of headerBuffer
-      for(int i=0; i<5; i++) {
-        headerBuffer[i] = headerBuffer[i+1];
-      }
-      headerBuffer[5] = client.read();
-      Serial.print(headerBuffer[5]);
-    } 
-    else {
-      delay(50);
-      timeLeft -= 50;
-    }
-  } //End ignoring header
+  upload_response.reset();
+  upload_sent_at = millis();
+  upload_pending = true;
   lcd_print_top("Listening 492Mhz");
-  checkNPet();
-  if(client.read() != 'S') {
-    Serial.println(F("Upload failed"));
-    //if uploading succeeded, the server will display a page that says "Success uploading data".
-    // otherwise, it will show "Failed to upload"
-    //On a timeout, client.read() gives -1.
-    return false;
-  } 
-  else {
-    Serial.println(F("Upload succeeded"));
-  }
-
-
-  client.close();
-  Serial.println("client closed");
-  return false;
+  return true;
 }
 
-/** Checks whether the device is activated inside a building and if so what building and what sensors does it have. 
- * @return The building id if the device is currently active in a building otherwise it will return -1.*/
-int getBuilding() {
-  clearPacketBuffer();
+/** Sends the request that checks whether the device is activated inside a building.
+ * The reply is read in the background by serviceServer which updates building_id.
+ * @return Whether the request was sent. */
+boolean requestBuilding() {
   Serial.println(F("Connecting to server...\nIf this is the first time, it may take a while"));
   checkNPet();
   Serial.println("Radio Connected");
-  WildFire_CC3000_Client client = cc3000.connectTCP(ip, LISTEN_PORT);
+  building_client = cc3000.connectTCP(ip, LISTEN_PORT);
   Serial.println(F("Established TCP Connection"));
-  int datalength = 0;
-  char data[1] = "";
-
 
   //Sending request
-  char putstr_buffer[128] = "GET /first_contact/";
+  char putstr_buffer[64] = "GET /first_contact/";
   strcat(putstr_buffer, address);
   Serial.print("Address is:");
   Serial.println(address);
 
   strcat_P(putstr_buffer, PSTR(".html HTTP/1.1"));
-  makePacketHeader(putstr_buffer, "application/json", datalength);
 
-  strcat(packet_buffer, data);
   Serial.println(F("Sending request"));
   checkNPet();
-  Serial.println(packet_buffer);
-  if(client.connected()){
-    client.fastrprintln(packet_buffer);
+  building_response.reset();
+  building_sent_at = millis();
+  building_pending = true;
+  if(building_client.connected()){
+    makePacketHeader(building_client, putstr_buffer, "application/json", 0);
+    building_client.fastrprintln("");
   }
   else{
+    // The empty reply is handled like any other failed query
     Serial.println("Error");
   }
-  Serial.print("Address is: ");
-  Serial.println(address);
-  ///Receiving reply
-  checkNPet();
-
-  char serverReply[512] = "";
-
-  Serial.println(F("Getting Server reply"));
-
-  //Ignoring the header:
-  int i = 0;
-  while(client.connected() && i < 511) {
-    while(client.available()) {
-      Serial.print('*');
-      checkNPet();
-      serverReply[i] = (char)client.read();
-      i++;
-      serverReply[i] = '\0';
-      if(i >= 5 && !strcmp("start", serverReply+i-5)) {
-        break;
-      }
-    }
+  return building_pending;
+}
 
+/** Checks whether the reply to the building query is still being read.
+ * @return True while the query is outstanding. */
+boolean buildingQueryPending(){
+  return building_pending;
+}
 
-    if(i >= 5 && !strcmp("start", serverReply+i-5)) {
+/** Feeds the bytes that the client has available to the response parser without waiting for more.
+ * The response is finished when the connection closes or RESPONSE_TIMEOUT_MS elapses.
+ * @param &client The connection on which the request was sent.
+ * @param &response The parser for the reply.
+ * @param sent_at The time at which the request was sent.
+ * @return Whether the response is complete, in which case the connection has been closed. */
+boolean pollResponse(WildFire_CC3000_Client &client, HTTPResponseParser &response, uint32_t sent_at){
+  while(client.available()){
+    if(response.parse(client.read())){
       break;
     }
   }
+  if(!response.isComplete() && (!client.connected() || millis() - sent_at >= RESPONSE_TIMEOUT_MS)){
+    response.finish();
+  }
+  if(response.isComplete()){
+    client.close();
+    return true;
+  }
+  return false;
+}
 
-
-  //Reading the body
-  i=0;
-  while(client.connected() && i < 511){
-    Serial.print('.');
-    if(client.available()) {
-      checkNPet();
-      serverReply[i] = (char)client.read();
-      i = (i == 0 && ( serverReply[0] == ' ' || serverReply[0] == '\n') ) ?  i : i+1;
+/** Reads the replies from the server as they arrive. This never blocks
+ * so it is called on every pass through the main loop. */
+void serviceServer(){
+  if(upload_pending && pollResponse(upload_client, upload_response, upload_sent_at)){
+    upload_pending = false;
+    //if uploading succeeded, the server will display a page that says "Success uploading data".
+    // otherwise, it will show "Failed to upload"
+    if(upload_response.getBody()[0] != 'S') {
+      Serial.println(F("Upload failed"));
+      TRACE_POINT(abandon(TRACE_CONNECT));
     } 
     else {
-      //delay(50);
-    }
-
-    if(i >= 3 && !strcmp("end", serverReply+i-3)) {
-      i -= 3;
-      break;
+      Serial.println(F("Upload succeeded"));
+      TRACE_POINT(mark(TRACE_RESPONSE, micros()));
     }
+    Serial.println("client closed");
   }
-  serverReply[i] = '\0';
-
+  if(building_pending && pollResponse(building_client, building_response, building_sent_at)){
+    building_pending = false;
+    // A reply that was cut short could hold part of the sensors, so it is discarded
+    if(building_response.hasOverflowed()){
+      Serial.println(F("Reply too long"));
+      return;
+    }
+    building_id = parseBuildingReply(building_response.getBody());
+    if(building_id <= 0){
+      lcd_print_top("Not In Building");
+      lcd_print_bottom("Add to Building");
+    }
 #ifdef DEVELOPMENT
-  /* Serial.println("\nPacket to server:");
-   Serial.println(packet_buffer);
-   Serial.println("ServerReply:");
-   Serial.println(serverReply);*/
+    Serial.print("B_ID");
+    Serial.println(building_id);
 #endif
+  }
+}
 
+/** Decrypts and interprets the reply to the building query.
+ * @param *serverReply The body of the reply, which is decrypted in place.
+ * @return The building id if the device is currently active in a building otherwise it will return -1.*/
+int parseBuildingReply(char *serverReply) {
   //Decoding server reply
   char vignere_key[32] = ""; 
   getEncryptionKey(vignere_key);
+  // The space between the cipher text and the end marker was never encrypted,
+  // and decrypted it becomes a character that depends on the key
+  uint16_t length = strlen(serverReply);
+  if(length > 0 && serverReply[length - 1] == ' '){
+    serverReply[length - 1] = '\0';
+  }
   decrypt(serverReply, vignere_key, serverReply);
   Serial.println();
   Serial.println(serverReply);
@@ -249,8 +260,11 @@ int getBuilding() {
   long int time;
   int experiment_id_tmp, CO2_cutoff_tmp;
   int varsRead = sscanf(serverReply, "%ld %*s %d %*s %d", &time, &experiment_id_tmp, &CO2_cutoff_tmp);
-
-  client.close();
+  // The server may follow the reply with the sensors to listen for
+  char *sensors = strstr(serverReply, " sensors ");
+  if(sensors != NULL){
+    receiveSensorConfig(sensors + 9);
+  }
 
   switch(varsRead){
   case 1:
@@ -264,10 +278,3 @@ int getBuilding() {
     return -1;
   } 
 }
-
-/** The helper function used to clear the packet buffer to ensure that there is no chance of buffer overflow.*/
-void clearPacketBuffer(){
-  for(int i = 0; i < strlen(packet_buffer); i++){
-    packet_buffer[i] = '\0';
-  }
-}
@@ -12,11 +12,22 @@ void encrypt(char * plaintext, char * key, char *encrypted) {
   int textLength = strlen(plaintext);
   int keyLength =  strlen(key);
   for(int i=0; i < textLength; i++) {
-    encrypted[i] = plaintext[i] + key[i % keyLength] - 32;
-    if((unsigned) encrypted[i] >= 127) {
-      encrypted[i] -= (unsigned) (127-32);
-    }
+    encrypted[i] = encryptChar(plaintext[i], key[i % keyLength]);
+  }
+}
+
+/**
+ * Encrypts a single character with the Vignere cipher so that data can be
+ * encrypted as it is streamed rather than in a buffer.
+ * @param plain The plaintext character.
+ * @param key The character of the key that corresponds to the plaintext character.
+ * @return The encrypted character. */
+char encryptChar(char plain, char key) {
+  char encrypted = plain + key - 32;
+  if((unsigned) encrypted >= 127) {
+    encrypted -= (unsigned) (127-32);
   }
+  return encrypted;
 }
 
 /**
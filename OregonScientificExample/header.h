@@ -7,18 +7,45 @@
 //#define DEVELOPMENT 	///< Defined for the development environment
 #define PRODUCTION 		///< Defined for the production environment
 //#define CONFIG			///< Defined for the initial configuration
+//#define GATEWAY		///< Defined for the gateway environment, which sends frames over Serial to a computer instead of to the server
 
-#define PACKET_SIZE 50 ///< The size of the individual packets                    //Number of datapoints in a packet
-// Don't make this too big or the Wildfire won't have space for it
-// This shouldn't cause packets to exceed TX_BUFFER_SIZE for the CC3000
-
-#define DATA_MAX_LENGTH (PACKET_SIZE * 35 + 150) ///< The maximum length of the data
-#define MAX_PACKET_LENGTH (160 + DATA_MAX_LENGTH + 64) ///< The maximum packet length - used when allocating the packet buffer
+#define TX_CHUNK_SIZE 32 ///< The number of bytes of the body staged before each write to the CC3000
+// Packets are streamed to the CC3000 so this only bounds the stack used while sending.
+// This shouldn't exceed TX_BUFFER_SIZE for the CC3000
 
 #define SERIAL_BAUD 115200 ///< The Baud Rate of the Serial port 
+#define GATEWAY_BAUD 1000000 ///< The Baud Rate of the Serial port in the gateway environment, exact from a 16 MHz clock
 #define LISTEN_PORT 3000  ///< The port on which the server listens
 #define IDLE_TIMEOUT_MS  3000 ///< The HTTP timeout (in milliseconds)
+#define RESPONSE_TIMEOUT_MS 6000 ///< The time to wait for the server to finish replying (in milliseconds)
+#define QUERY_INTERVAL_MS 10000 ///< The time between checks of the building the device is in (in milliseconds)
+#define UPLOAD_REPLY_SIZE 8 ///< The number of characters kept from the reply to an upload
+#define BUILDING_REPLY_SIZE 128 ///< The number of characters kept from the reply to the building query, which is at most 91 with four sensors; a longer reply is discarded
 #define DHT22_PIN A0	///< The input from the DHT22
+#define DHT22_RETRIES 3	///< The number of times a failed DHT22 reading is retried
+#define DHT22_INTERVAL_MS 30000 ///< The time between readings of the DHT22 (in milliseconds)
+
+#define AGGREGATION_WINDOW_MS 300000 ///< The length of the window each sensor is summarized over (in milliseconds)
+#define MAX_AGGREGATED_SENSORS 4 ///< The maximum number of sensors that are summarized
+
+#define TEMP_DEADBAND 2 ///< The change in temperature that is not reported (in tenths of a degree)
+#define HUMIDITY_DEADBAND 1 ///< The change in humidity that is not reported (in percent)
+#define MAX_SILENCE_MS 3600000 ///< The longest time a sensor goes unreported (in milliseconds)
+
+#define RFM69_SS_PIN 7 ///< The chip select of the RFM69, whose DIO2 drives the pin of interrupt 1
+#define RFM69_FREQUENCY_HZ 433920000UL ///< The carrier frequency the RFM69 listens on (in Hz)
+#define RFM69_RSSI_THRESHOLD_DBM -95 ///< The RSSI below which the RFM69 holds its data output low (in dBm)
+#define RFM69_OOK_FLOOR_DB 12 ///< The floor of the OOK peak threshold above the sensitivity of the RFM69 (in dB)
+#define RSSI_STALE_MS 20 ///< The longest time between passes of processMessages after which the RSSI of the queued pulses is still read (in milliseconds)
+
+#define FRAME_REPAIR_WINDOW_MS 1000 ///< The longest time between a failed message and the repeat it is repaired with (in milliseconds)
+#define FRAME_REPAIR_MAX_DIFFS 2 ///< The most nibbles in which the two copies of a message may differ to be repaired, at most FRAME_REPAIR_DIFF_LIMIT
+
+#define DECODER_REPORT_INTERVAL_MS 600000 ///< The time between prints of the pulses gated and decoded in the development environment (in milliseconds)
+#define LATENCY_REPORT_INTERVAL_MS 600000 ///< The time between prints of the latency histograms when LATENCY_TRACE is defined (in milliseconds)
+#define MEMORY_REPORT_INTERVAL_MS 600000 ///< The time between prints of the memory marks in the development environment (in milliseconds)
+
+#define RAM_BUFFER_BUDGET 4096 ///< The most RAM that the buffers listed in MemoryReport.ino may take, checked when compiling (in bytes)
 
 
 #define HOST      "192.168.1.16" ///< The Ruby on Rails host.
@@ -38,5 +65,10 @@
 #define LCD_D5  5 	///< The pin used for the data bus line 5
 #define LCD_D6  6 	///< The pin used for the data bus line 6
 #define LCD_D7  8 	///< The pin used for the data bus line 7
+#define LCD_COLS 16	///< The number of columns of the LCD
+#define LCD_ROWS 2	///< The number of rows of the LCD
+#define LCD_FLUSH_INTERVAL_MS 250	///< The shortest time between two updates of the LCD (in milliseconds)
+#define LCD_MIN_STATUS_MS 1000	///< The shortest time a status is shown before a newer one replaces it (in milliseconds)
+#define LCD_STATUS_QUEUE 3	///< The number of statuses that can wait to be shown, past which the newest replaces the last of them
 /******************************/
 //#define CONFIG
@@ -218,3 +218,51 @@ void setEncryptionKey(char *key) {
     invalidMemory = true;
    }
 }
+
+// The sensor configuration sits at the top of the EEPROM, out of the way of the saved data:
+//    [magic][count][#####records#####][checksum]
+#define SENSOR_CONFIG_SIZE (3 + SENSOR_CONFIG_MAX_RECORDS * SENSOR_CONFIG_RECORD_SIZE)
+#define SENSOR_CONFIG_LOC ((byte *) (E2END + 1 - SENSOR_CONFIG_SIZE))
+#define SENSOR_CONFIG_COUNT_LOC (SENSOR_CONFIG_LOC + 1)
+#define SENSOR_CONFIG_RECORDS_PTR (SENSOR_CONFIG_LOC + 2)
+#define SENSOR_CONFIG_MAGIC 'S'
+
+/** Reads the sensor configuration kept in the devices EEPROM.
+ * @param &config Receives the configuration.
+ * @return Whether a valid configuration was found, otherwise config is left as it was. */
+boolean loadSensorConfig(SensorConfig &config) {
+  if(eeprom_read_byte(SENSOR_CONFIG_LOC) != SENSOR_CONFIG_MAGIC) {
+    return false;
+  }
+  uint8_t count = eeprom_read_byte(SENSOR_CONFIG_COUNT_LOC);
+  if(count == 0 || count > SENSOR_CONFIG_MAX_RECORDS) {
+    return false;
+  }
+  SensorConfigRecord records[SENSOR_CONFIG_MAX_RECORDS];
+  eeprom_read_block(records, SENSOR_CONFIG_RECORDS_PTR, count * sizeof(SensorConfigRecord));
+  SensorConfig stored;
+  if(!stored.setRecords(records, count)
+   || eeprom_read_byte(SENSOR_CONFIG_RECORDS_PTR + count * sizeof(SensorConfigRecord)) != stored.checksum()) {
+    return false;
+  }
+  config = stored;
+  return true;
+}
+
+/** Writes the sensor configuration to the devices EEPROM.
+ * The magic number is written last so a configuration cut off by a reset is not loaded.
+ * @param &config The configuration. */
+void saveSensorConfig(const SensorConfig &config) {
+  uint8_t count = config.getCount();
+  eeprom_write_byte(SENSOR_CONFIG_LOC, 0);
+  eeprom_write_byte(SENSOR_CONFIG_COUNT_LOC, count);
+  eeprom_write_block(config.getRecords(), SENSOR_CONFIG_RECORDS_PTR, count * sizeof(SensorConfigRecord));
+  eeprom_write_byte(SENSOR_CONFIG_RECORDS_PTR + count * sizeof(SensorConfigRecord), config.checksum());
+  eeprom_write_byte(SENSOR_CONFIG_LOC, SENSOR_CONFIG_MAGIC);
+
+  //Verify newly written memory
+  SensorConfig stored;
+  if(!loadSensorConfig(stored) || !stored.equals(config)) {
+    invalidMemory = true;
+  }
+}
@@ -27,6 +27,31 @@ uint8_t OregonScientificSensor::getMessageSize(){
 	return format[1];
 }
 
+int8_t OregonScientificSensor::getFieldIndex(const char *title){
+	for(int8_t i = 1; i < msg_size; i++){
+		if(titles[i] == title){
+			return i;
+		}
+	}
+	return -1;
+}
+
+int16_t OregonScientificSensor::decodeField(uint8_t *message, int8_t field){
+	int8_t begin = format[field * 2];
+	int8_t end = format[field * 2 + 1];
+	boolean negative = false;
+	// The temperatures carry their sign in the last nibble
+	if(titles[field] == "Temp"){
+		negative = message[end] != 0;
+		end--;
+	}
+	int16_t value = 0;
+	for(int8_t i = end; i >= begin; i--){
+		value = value * 10 + message[i];
+	}
+	return negative ? -value : value;
+}
+
 String OregonScientificSensor::getJSONMessage(){
 	return json_msg;
 }
@@ -95,6 +95,18 @@ public:
 	/** Gets the char array representation of the JSON formated message. 
 	 * @param The buffer to place the JSON formatted message into. */
 	void getCharMessage(char &msg);
+	/** Finds the field with the given title.
+	 * @param *title The title of the field, such as "Temp" or "Humidity".
+	 * @return The index of the field in the format or -1 if the sensor does not have it. */
+	int8_t getFieldIndex(const char *title);
+	/** Decodes the value of a field of the message as a number.
+	 * @param *message The standard Oregon Scientific message.
+	 * @param field The index of the field as returned by getFieldIndex.
+	 * @return The value of the field in the units sent by the sensor (tenths of a degree for "Temp").
+	 * @details The nibbles of the field are binary coded decimal with the
+	 * least significant digit first. The most significant nibble of a
+	 * temperature is its sign. */
+	int16_t decodeField(uint8_t *message, int8_t field);
 	/** Gets the expected size of the message.
 	 * @return The integer containing the expected size of the message. 
 	 * @details Generally used by the parser to determine when to stop
@@ -0,0 +1,96 @@
+#include <RFM69OOK.h>
+
+RFM69OOK::RFM69OOK(uint8_t ssPin){
+	RFM69OOK::ssPin = ssPin;
+	present = false;
+	burstRssi = RFM69_NO_RSSI;
+}
+
+boolean RFM69OOK::begin(uint32_t frequency, int16_t rssiThreshold, uint8_t ookFloor){
+	// Deselects the RFM69 before the bus is used
+	pinMode(ssPin, OUTPUT);
+	digitalWrite(ssPin, HIGH);
+	SPI.begin();
+	if(readRegister(RFM69_REG_VERSION) != RFM69_VERSION){
+		return false;
+	}
+	// The configuration is written in standby so the receiver starts with all of it
+	if(!setMode(RFM69_MODE_STANDBY)){
+		return false;
+	}
+	writeRegister(RFM69_REG_DATAMODUL, RFM69_CONTINUOUS_OOK);
+	uint16_t bitrate = RFM69_FXOSC / RFM69_CHIP_RATE;
+	writeRegister(RFM69_REG_BITRATEMSB, bitrate >> 8);
+	writeRegister(RFM69_REG_BITRATELSB, bitrate & 0xFF);
+	// Frf = frequency * 2^19 / FXOSC, and 2^19 / 32 MHz is 256 / 15625
+	uint32_t frf = (frequency / 15625) * 256 + (frequency % 15625) * 256 / 15625;
+	writeRegister(RFM69_REG_FRFMSB, frf >> 16);
+	writeRegister(RFM69_REG_FRFMID, (frf >> 8) & 0xFF);
+	writeRegister(RFM69_REG_FRFLSB, frf & 0xFF);
+	writeRegister(RFM69_REG_LNA, RFM69_LNA_AGC);
+	writeRegister(RFM69_REG_RXBW, RFM69_RXBW_125KHZ);
+	writeRegister(RFM69_REG_OOKPEAK, RFM69_OOKPEAK_SLOW);
+	writeRegister(RFM69_REG_OOKFIX, ookFloor);
+	writeRegister(RFM69_REG_RSSITHRESH, -2 * rssiThreshold);
+	if(!setMode(RFM69_MODE_RX)){
+		return false;
+	}
+	present = true;
+	return true;
+}
+
+boolean RFM69OOK::isPresent(){
+	return present;
+}
+
+int16_t RFM69OOK::readRssi(){
+	if(!present){
+		return RFM69_NO_RSSI;
+	}
+	return -(int16_t) (readRegister(RFM69_REG_RSSIVALUE) / 2);
+}
+
+void RFM69OOK::sampleRssi(){
+	int16_t rssi = readRssi();
+	if(rssi > burstRssi){
+		burstRssi = rssi;
+	}
+}
+
+int16_t RFM69OOK::getBurstRssi(){
+	return burstRssi;
+}
+
+void RFM69OOK::clearBurstRssi(){
+	burstRssi = RFM69_NO_RSSI;
+}
+
+uint8_t RFM69OOK::readRegister(uint8_t address){
+	SPI.beginTransaction(SPISettings(RFM69_SPI_HZ, MSBFIRST, SPI_MODE0));
+	digitalWrite(ssPin, LOW);
+	SPI.transfer(address & 0x7F);
+	uint8_t value = SPI.transfer(0);
+	digitalWrite(ssPin, HIGH);
+	SPI.endTransaction();
+	return value;
+}
+
+void RFM69OOK::writeRegister(uint8_t address, uint8_t value){
+	SPI.beginTransaction(SPISettings(RFM69_SPI_HZ, MSBFIRST, SPI_MODE0));
+	digitalWrite(ssPin, LOW);
+	SPI.transfer(address | 0x80);
+	SPI.transfer(value);
+	digitalWrite(ssPin, HIGH);
+	SPI.endTransaction();
+}
+
+boolean RFM69OOK::setMode(uint8_t mode){
+	writeRegister(RFM69_REG_OPMODE, (readRegister(RFM69_REG_OPMODE) & ~RFM69_MODE_MASK) | mode);
+	uint32_t start = millis();
+	while(!(readRegister(RFM69_REG_IRQFLAGS1) & RFM69_IRQ_MODEREADY)){
+		if(millis() - start >= RFM69_MODE_TIMEOUT_MS){
+			return false;
+		}
+	}
+	return true;
+}
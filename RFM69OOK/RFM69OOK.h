@@ -0,0 +1,107 @@
+// File: RFM69OOK.h
+// Description: Defines the driver that runs the RFM69 as a continuous OOK
+// receiver whose demodulated data drives the pin of the ManchesterDecoder.
+
+/**
+ * The RFM69 OOK driver puts the module into continuous receive
+ * without the bit synchronizer, so DIO2 carries the output of its
+ * OOK data slicer straight to the interrupt pin that the
+ * ManchesterDecoder listens on. The slicer runs in peak mode: its
+ * threshold sits 6 dB below the last peak of the carrier and decays
+ * once per chip, with the chip set to half an Oregon Scientific bit,
+ * but never below a floor. Raising the floor and the RSSI threshold
+ * above the noise of the band keeps DIO2 quiet between transmissions,
+ * so noise no longer interrupts the decoder, at the cost of the
+ * weakest sensors.
+ *
+ * The RSSI is read over SPI from the main loop while a burst is being
+ * decoded, and the strongest reading of the burst is kept for the
+ * parser. The reading is only that of the burst while it is still on
+ * the air, so a loop that drains its pulses late does not sample them. If no RFM69 answers, begin leaves the pin to whatever
+ * receiver drives it and no RSSI is known.
+ * @file RFM69OOK.h */
+
+#ifndef RFM69_OOK_H
+#define RFM69_OOK_H
+
+#include <Arduino.h>
+#include <SPI.h>
+
+#define RFM69_REG_OPMODE 0x01 ///< Defines the register of the operating mode.
+#define RFM69_REG_DATAMODUL 0x02 ///< Defines the register of the data mode and the modulation.
+#define RFM69_REG_BITRATEMSB 0x03 ///< Defines the register of the high byte of the bit rate.
+#define RFM69_REG_BITRATELSB 0x04 ///< Defines the register of the low byte of the bit rate.
+#define RFM69_REG_FRFMSB 0x07 ///< Defines the register of the high byte of the carrier frequency.
+#define RFM69_REG_FRFMID 0x08 ///< Defines the register of the middle byte of the carrier frequency.
+#define RFM69_REG_FRFLSB 0x09 ///< Defines the register of the low byte of the carrier frequency.
+#define RFM69_REG_VERSION 0x10 ///< Defines the register of the silicon version.
+#define RFM69_REG_LNA 0x18 ///< Defines the register of the LNA settings.
+#define RFM69_REG_RXBW 0x19 ///< Defines the register of the channel filter bandwidth.
+#define RFM69_REG_OOKPEAK 0x1B ///< Defines the register of the OOK threshold type and peak decay.
+#define RFM69_REG_OOKFIX 0x1D ///< Defines the register of the fixed OOK threshold, the floor of the peak threshold.
+#define RFM69_REG_RSSIVALUE 0x24 ///< Defines the register of the RSSI, in -0.5 dBm steps.
+#define RFM69_REG_IRQFLAGS1 0x27 ///< Defines the register of the mode flags.
+#define RFM69_REG_RSSITHRESH 0x29 ///< Defines the register of the RSSI threshold, in -0.5 dBm steps.
+
+#define RFM69_MODE_STANDBY 0x04 ///< Defines the standby mode of RegOpMode.
+#define RFM69_MODE_RX 0x10 ///< Defines the receive mode of RegOpMode.
+#define RFM69_MODE_MASK 0x1C ///< Defines the bits of the mode in RegOpMode.
+#define RFM69_CONTINUOUS_OOK 0x68 ///< Defines continuous mode without bit synchronizer and OOK without shaping.
+#define RFM69_LNA_AGC 0x88 ///< Defines the 200 ohm input with the gain set by the AGC.
+#define RFM69_RXBW_125KHZ 0x41 ///< Defines a 125 kHz channel filter in OOK, wide enough for the drift of cheap sensors.
+#define RFM69_OOKPEAK_SLOW 0x40 ///< Defines the peak threshold, decaying 0.5 dB once per chip.
+#define RFM69_IRQ_MODEREADY 0x80 ///< Defines the flag set once a new mode is entered.
+#define RFM69_VERSION 0x24 ///< Defines the silicon version of the RFM69.
+
+#define RFM69_FXOSC 32000000UL ///< Defines the crystal of the RFM69 (in Hz).
+#define RFM69_CHIP_RATE 2048u ///< Defines the chip rate, which times the decay of the peak threshold, as half an Oregon Scientific bit (in chips per second).
+#define RFM69_SPI_HZ 4000000UL ///< Defines the SPI clock used with the RFM69 (in Hz).
+#define RFM69_MODE_TIMEOUT_MS 10 ///< Defines the longest wait for a mode to be entered (in milliseconds).
+#define RFM69_NO_RSSI -128 ///< Defines the RSSI reported when none is known (in dBm).
+
+/** RFM69OOK configures the RFM69 as an OOK receiver and reads its RSSI.
+ * @class RFM69OOK */
+class RFM69OOK
+{
+public:
+	/** The constructor.
+	 * @param ssPin The chip select of the RFM69. */
+	RFM69OOK(uint8_t ssPin);
+	/** Checks that an RFM69 answers, then puts it into continuous OOK receive.
+	 * @param frequency The carrier frequency (in Hz).
+	 * @param rssiThreshold The RSSI below which the carrier is not detected (in dBm).
+	 * @param ookFloor The fixed threshold, which the peak threshold never decays below (in dB).
+	 * @return False if no RFM69 answered, in which case it was left alone. */
+	boolean begin(uint32_t frequency, int16_t rssiThreshold, uint8_t ookFloor);
+	/** Checks whether begin found the RFM69. */
+	boolean isPresent();
+	/** Reads the current RSSI.
+	 * @return The RSSI (in dBm), or RFM69_NO_RSSI if there is no RFM69. */
+	int16_t readRssi();
+	/** Reads the RSSI and keeps it if it is the strongest of the burst. Called
+	 * from the main loop while the pulses of a burst are being decoded. */
+	void sampleRssi();
+	/** Gets the strongest RSSI of the burst.
+	 * @return The RSSI (in dBm), or RFM69_NO_RSSI if none was sampled. */
+	int16_t getBurstRssi();
+	/** Forgets the RSSI of the burst, at the gap that ends it. */
+	void clearBurstRssi();
+	/** Reads a register.
+	 * @param address The address of the register.
+	 * @return Its value. */
+	uint8_t readRegister(uint8_t address);
+	/** Writes a register.
+	 * @param address The address of the register.
+	 * @param value The value to write. */
+	void writeRegister(uint8_t address, uint8_t value);
+private:
+	/** Enters a mode and waits until the RFM69 reports that it is ready.
+	 * @return False if it did not become ready in time. */
+	boolean setMode(uint8_t mode);
+
+	uint8_t ssPin;
+	boolean present;
+	int16_t burstRssi;
+};
+
+#endif // RFM69_OOK_H
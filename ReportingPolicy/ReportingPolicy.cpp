@@ -0,0 +1,69 @@
+#include <ReportingPolicy.h>
+
+ReportingPolicy::ReportingPolicy(uint8_t numFields, uint32_t maxSilence){
+	if(numFields > REPORTING_MAX_FIELDS){
+		numFields = REPORTING_MAX_FIELDS;
+	}
+	ReportingPolicy::numFields = numFields;
+	ReportingPolicy::maxSilence = maxSilence;
+	for(uint8_t i = 0; i < REPORTING_MAX_FIELDS; i++){
+		lastValues[i] = 0;
+		deadbands[i] = 0;
+	}
+	lastReport = 0;
+	suppressed = 0;
+	reported = 0;
+	suppressedSinceReport = 0;
+	suppressedBeforeReport = 0;
+	lastBatteryLow = false;
+	hasReported = false;
+}
+
+ReportingPolicy::~ReportingPolicy(){}
+
+void ReportingPolicy::setDeadband(uint8_t field, int16_t deadband){
+	if(field < numFields){
+		deadbands[field] = deadband;
+	}
+}
+
+boolean ReportingPolicy::shouldReport(const int16_t *values, boolean batteryLow, uint16_t readings, uint32_t now){
+	boolean report = !hasReported || batteryLow != lastBatteryLow || now - lastReport >= maxSilence;
+	for(uint8_t i = 0; i < numFields && !report; i++){
+		int16_t change = values[i] - lastValues[i];
+		if(change > deadbands[i] || change < -deadbands[i]){
+			report = true;
+		}
+	}
+	if(!report){
+		suppressed += readings;
+		suppressedSinceReport = (suppressedSinceReport > 0xFFFF - readings) ? 0xFFFF : suppressedSinceReport + readings;
+		return false;
+	}
+	for(uint8_t i = 0; i < numFields; i++){
+		lastValues[i] = values[i];
+	}
+	suppressedBeforeReport = suppressedSinceReport;
+	suppressedSinceReport = 0;
+	lastBatteryLow = batteryLow;
+	lastReport = now;
+	hasReported = true;
+	reported++;
+	return true;
+}
+
+boolean ReportingPolicy::batteryChanged(boolean batteryLow){
+	return hasReported && batteryLow != lastBatteryLow;
+}
+
+uint16_t ReportingPolicy::getSuppressedBeforeReport(){
+	return suppressedBeforeReport;
+}
+
+uint32_t ReportingPolicy::getSuppressed(){
+	return suppressed;
+}
+
+uint32_t ReportingPolicy::getReported(){
+	return reported;
+}
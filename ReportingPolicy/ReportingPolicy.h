@@ -0,0 +1,82 @@
+// File: ReportingPolicy.h
+// Description: Defines a policy that decides whether the readings of a
+// sensor have changed enough to be worth uploading to the server.
+
+/**
+ * The Reporting Policy suppresses readings that fall within a
+ * deadband of the last reported reading. A reading is always
+ * reported when the sensor has been silent for longer than the
+ * maximum silence interval, so the server still receives a
+ * heartbeat, and when the battery flag of the sensor changes.
+ * The number of reports and of suppressed readings is kept
+ * so that the savings can be checked.
+ * @file ReportingPolicy.h */
+
+#ifndef REPORTING_POLICY_H
+#define REPORTING_POLICY_H
+
+#include <Arduino.h>
+
+#define REPORTING_MAX_FIELDS 2 ///< Defines the maximum number of fields that the policy compares.
+
+/** ReportingPolicy decides whether a reading of a sensor is reported.
+ * @class ReportingPolicy
+ * @details The deadband of every field defaults to 0, which reports
+ * any change. The first reading is always reported. */
+class ReportingPolicy
+{
+public:
+	/** The constructor which takes the shape of the readings.
+	 * @param numFields The number of fields in every reading (at most REPORTING_MAX_FIELDS).
+	 * @param maxSilence The longest time in milliseconds between two reports. */
+	ReportingPolicy(uint8_t numFields, uint32_t maxSilence);
+	/** The destructor. */
+	~ReportingPolicy();
+	/** Sets the deadband of a field.
+	 * @param field The index of the field.
+	 * @param deadband The largest change from the last report that is suppressed, in the units of the field. */
+	void setDeadband(uint8_t field, int16_t deadband);
+	/** Decides whether a reading is reported and records the decision.
+	 * @param *values The value of every field of the reading.
+	 * @param batteryLow The battery flag sent with the reading.
+	 * @param readings The number of raw readings that the values stand for, which are counted if suppressed.
+	 * @param now The current time in milliseconds.
+	 * @return True if the reading should be uploaded, false if it was suppressed. */
+	boolean shouldReport(const int16_t *values, boolean batteryLow, uint16_t readings, uint32_t now);
+	/** Checks whether the battery flag differs from the one last reported.
+	 * @param batteryLow The battery flag sent with the latest reading.
+	 * @return True if the change should be reported right away. */
+	boolean batteryChanged(boolean batteryLow);
+	/** Gets the number of readings that were suppressed before the last report.
+	 * @return The number of readings suppressed between the last two reports. */
+	uint16_t getSuppressedBeforeReport();
+	/** Gets the number of readings suppressed since the policy was created. */
+	uint32_t getSuppressed();
+	/** Gets the number of reports made since the policy was created. */
+	uint32_t getReported();
+private:
+	/** The values of the last report. */
+	int16_t lastValues[REPORTING_MAX_FIELDS];
+	/** The deadband of every field. */
+	int16_t deadbands[REPORTING_MAX_FIELDS];
+	/** The longest time between two reports. */
+	uint32_t maxSilence;
+	/** The time of the last report. */
+	uint32_t lastReport;
+	/** The number of readings suppressed since the policy was created. */
+	uint32_t suppressed;
+	/** The number of reports since the policy was created. */
+	uint32_t reported;
+	/** The number of readings suppressed since the last report. */
+	uint16_t suppressedSinceReport;
+	/** The number of readings suppressed between the last two reports. */
+	uint16_t suppressedBeforeReport;
+	/** The number of fields in every reading. */
+	uint8_t numFields;
+	/** The battery flag of the last report. */
+	boolean lastBatteryLow;
+	/** Whether anything has been reported yet. */
+	boolean hasReported;
+};
+
+#endif // REPORTING_POLICY_H
@@ -0,0 +1,83 @@
+#include <SensorAggregator.h>
+
+SensorAggregator::SensorAggregator(uint8_t numFields, uint32_t windowLength){
+	if(numFields > AGGREGATOR_MAX_FIELDS){
+		numFields = AGGREGATOR_MAX_FIELDS;
+	}
+	SensorAggregator::numFields = numFields;
+	SensorAggregator::windowLength = windowLength;
+	reset();
+}
+
+SensorAggregator::~SensorAggregator(){}
+
+void SensorAggregator::reset(){
+	count = 0;
+	windowStart = 0;
+	for(uint8_t i = 0; i < AGGREGATOR_MAX_FIELDS; i++){
+		fields[i].minimum = 0;
+		fields[i].maximum = 0;
+		fields[i].last = 0;
+		fields[i].sum = 0;
+	}
+}
+
+void SensorAggregator::addReading(const int16_t *values, uint32_t now){
+	// The first reading opens the window
+	if(count == 0){
+		windowStart = now;
+		for(uint8_t i = 0; i < numFields; i++){
+			fields[i].minimum = values[i];
+			fields[i].maximum = values[i];
+		}
+	}
+	// Saturates rather than wrapping the sums
+	if(count == 0xFFFF){
+		return;
+	}
+	count++;
+	for(uint8_t i = 0; i < numFields; i++){
+		if(values[i] < fields[i].minimum){
+			fields[i].minimum = values[i];
+		}
+		if(values[i] > fields[i].maximum){
+			fields[i].maximum = values[i];
+		}
+		fields[i].last = values[i];
+		fields[i].sum += values[i];
+	}
+}
+
+boolean SensorAggregator::windowComplete(uint32_t now){
+	return count > 0 && now - windowStart >= windowLength;
+}
+
+uint8_t SensorAggregator::getNumFields(){
+	return numFields;
+}
+
+uint16_t SensorAggregator::getCount(){
+	return count;
+}
+
+int16_t SensorAggregator::getMinimum(uint8_t field){
+	return fields[field].minimum;
+}
+
+int16_t SensorAggregator::getMaximum(uint8_t field){
+	return fields[field].maximum;
+}
+
+int16_t SensorAggregator::getLast(uint8_t field){
+	return fields[field].last;
+}
+
+int16_t SensorAggregator::getMean(uint8_t field){
+	if(count == 0){
+		return 0;
+	}
+	// Rounds half away from zero
+	int32_t sum = fields[field].sum;
+	int32_t half = count / 2;
+	return (sum >= 0 ? sum + half : sum - half) / (int32_t) count;
+}
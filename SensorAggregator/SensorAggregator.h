@@ -0,0 +1,85 @@
+// File: SensorAggregator.h
+// Description: Defines an aggregator that summarizes the readings of a
+// sensor over a tumbling window so that one summary can be uploaded in
+// place of every reading.
+
+/**
+ * The Sensor Aggregator keeps the running minimum, maximum,
+ * sum, and last value of each field of a sensor along with the
+ * number of readings received in the current window. Each
+ * reading is folded in with a constant amount of work and the
+ * values are kept in the fixed point units of the sensor
+ * (tenths of a degree, percent, etc.) so no floating point
+ * is needed.
+ * @file SensorAggregator.h */
+
+#ifndef SENSOR_AGGREGATOR_H
+#define SENSOR_AGGREGATOR_H
+
+#include <Arduino.h>
+
+#define AGGREGATOR_MAX_FIELDS 2 ///< Defines the maximum number of fields that are aggregated per sensor.
+
+/** The running summary of a single field.
+ * @struct FieldAggregate */
+struct FieldAggregate{
+	int16_t minimum; ///< The smallest value in the window.
+	int16_t maximum; ///< The largest value in the window.
+	int16_t last; ///< The most recent value in the window.
+	int32_t sum; ///< The sum of the values in the window.
+};
+
+/** SensorAggregator summarizes the readings of one sensor
+ * over a tumbling window.
+ * @class SensorAggregator
+ * @details A window begins with the first reading after the
+ * aggregator is reset and is complete once windowLength
+ * milliseconds have passed. The owner is expected to send
+ * the summary of a complete window and then reset the
+ * aggregator, which starts the next window. */
+class SensorAggregator
+{
+public:
+	/** The constructor which takes the shape of the readings.
+	 * @param numFields The number of fields in every reading (at most AGGREGATOR_MAX_FIELDS).
+	 * @param windowLength The length of the window in milliseconds. */
+	SensorAggregator(uint8_t numFields, uint32_t windowLength);
+	/** The destructor. */
+	~SensorAggregator();
+	/** Adds a reading to the current window.
+	 * @param *values The value of every field of the reading.
+	 * @param now The time of the reading in milliseconds. */
+	void addReading(const int16_t *values, uint32_t now);
+	/** Checks if the current window holds readings and has ended.
+	 * @param now The current time in milliseconds.
+	 * @return True if the summary should be sent, false otherwise. */
+	boolean windowComplete(uint32_t now);
+	/** Discards the current window so that the next reading starts a new one. */
+	void reset();
+	/** Gets the number of fields in every reading. */
+	uint8_t getNumFields();
+	/** Gets the number of readings in the current window. */
+	uint16_t getCount();
+	/** Gets the smallest value of a field in the current window. */
+	int16_t getMinimum(uint8_t field);
+	/** Gets the largest value of a field in the current window. */
+	int16_t getMaximum(uint8_t field);
+	/** Gets the most recent value of a field in the current window. */
+	int16_t getLast(uint8_t field);
+	/** Gets the mean of a field in the current window rounded to the nearest unit.
+	 * @return The mean in the units of the readings or 0 if the window is empty. */
+	int16_t getMean(uint8_t field);
+private:
+	/** The running summaries of the fields. */
+	FieldAggregate fields[AGGREGATOR_MAX_FIELDS];
+	/** The length of the window in milliseconds. */
+	uint32_t windowLength;
+	/** The time of the first reading in the window. */
+	uint32_t windowStart;
+	/** The number of readings in the window. */
+	uint16_t count;
+	/** The number of fields in every reading. */
+	uint8_t numFields;
+};
+
+#endif // SENSOR_AGGREGATOR_H
@@ -0,0 +1,104 @@
+#include <SensorConfig.h>
+
+SensorConfig::SensorConfig(){
+	count = 0;
+}
+
+void SensorConfig::clear(){
+	count = 0;
+}
+
+boolean SensorConfig::add(uint8_t model, uint8_t channel, uint8_t tempDeadband, uint8_t humidityDeadband, uint8_t silenceMinutes){
+	if(count >= SENSOR_CONFIG_MAX_RECORDS || !isKnownModel(model)){
+		return false;
+	}
+	SensorConfigRecord *record = &records[count++];
+	record->model = model;
+	record->channel = channel;
+	record->tempDeadband = tempDeadband;
+	record->humidityDeadband = humidityDeadband;
+	record->silenceMinutes = silenceMinutes;
+	return true;
+}
+
+boolean SensorConfig::setRecords(const SensorConfigRecord *records, uint8_t count){
+	if(count > SENSOR_CONFIG_MAX_RECORDS){
+		return false;
+	}
+	for(uint8_t i = 0; i < count; i++){
+		if(!isKnownModel(records[i].model)){
+			return false;
+		}
+	}
+	memcpy(SensorConfig::records, records, count * sizeof(SensorConfigRecord));
+	SensorConfig::count = count;
+	return true;
+}
+
+const SensorConfigRecord *SensorConfig::getRecords() const{
+	return records;
+}
+
+uint8_t SensorConfig::getCount() const{
+	return count;
+}
+
+static int8_t hexValue(char c){
+	if(c >= '0' && c <= '9'){
+		return c - '0';
+	}
+	if(c >= 'A' && c <= 'F'){
+		return c - 'A' + 10;
+	}
+	if(c >= 'a' && c <= 'f'){
+		return c - 'a' + 10;
+	}
+	return -1;
+}
+
+boolean SensorConfig::parseHex(const char *hex){
+	SensorConfigRecord parsed[SENSOR_CONFIG_MAX_RECORDS];
+	uint8_t *bytes = (uint8_t *) parsed;
+	uint8_t length = 0;
+	while(hexValue(*hex) >= 0){
+		int8_t high = hexValue(hex[0]);
+		int8_t low = high < 0 ? -1 : hexValue(hex[1]);
+		if(low < 0 || length >= sizeof(parsed)){
+			return false;
+		}
+		bytes[length++] = (high << 4) | low;
+		hex += 2;
+	}
+	// A configuration without sensors would stop all decoding
+	if(length == 0 || length % SENSOR_CONFIG_RECORD_SIZE != 0){
+		return false;
+	}
+	return setRecords(parsed, length / SENSOR_CONFIG_RECORD_SIZE);
+}
+
+void SensorConfig::toHex(char *buffer) const{
+	static const char digits[] = "0123456789ABCDEF";
+	const uint8_t *bytes = (const uint8_t *) records;
+	for(uint8_t i = 0; i < count * SENSOR_CONFIG_RECORD_SIZE; i++){
+		*buffer++ = digits[bytes[i] >> 4];
+		*buffer++ = digits[bytes[i] & 0x0F];
+	}
+	*buffer = '\0';
+}
+
+uint8_t SensorConfig::checksum() const{
+	uint8_t sum = count;
+	const uint8_t *bytes = (const uint8_t *) records;
+	for(uint8_t i = 0; i < count * SENSOR_CONFIG_RECORD_SIZE; i++){
+		sum += bytes[i];
+	}
+	return ~sum;
+}
+
+boolean SensorConfig::equals(const SensorConfig &other) const{
+	return count == other.count && memcmp(records, other.records, count * sizeof(SensorConfigRecord)) == 0;
+}
+
+boolean SensorConfig::isKnownModel(uint8_t model){
+	return model == SENSOR_MODEL_THGR122NX || model == SENSOR_MODEL_THWR800;
+}
@@ -0,0 +1,85 @@
+// File: SensorConfig.h
+// Description: Defines the compact record of the sensors a device listens
+// for, which the server pushes in its reply and the EEPROM keeps.
+
+/**
+ * The Sensor Config lists the sensors a device listens for, each as
+ * a record of five bytes: its model, its channel, and the reporting
+ * policy of its summaries, the deadband of the temperature in tenths
+ * of a degree, the deadband of the humidity in percent, and the
+ * longest silence in minutes, where 0 keeps the default of the
+ * device. The server sends the records as hex digits after the word
+ * "sensors" in the reply to the building query, ten digits to a
+ * record, and the device keeps them in its EEPROM so that the next
+ * boot can listen for the sensors before it reaches the network.
+ * A record for a model the device does not know makes the whole
+ * configuration invalid, so that a server ahead of the firmware
+ * cannot leave it listening for only some of the sensors.
+ * @file SensorConfig.h */
+
+#ifndef SENSOR_CONFIG_H
+#define SENSOR_CONFIG_H
+
+#include <Arduino.h>
+
+#define SENSOR_CONFIG_MAX_RECORDS 4 ///< Defines the most sensors in a configuration.
+#define SENSOR_CONFIG_RECORD_SIZE 5 ///< Defines the bytes of a record.
+#define SENSOR_CONFIG_HEX_SIZE (SENSOR_CONFIG_MAX_RECORDS * SENSOR_CONFIG_RECORD_SIZE * 2 + 1) ///< Defines the longest configuration in hex, with its terminator.
+#define SENSOR_MODEL_THGR122NX 0x01 ///< Defines the model of the THGR122NX.
+#define SENSOR_MODEL_THWR800 0x02 ///< Defines the model of the THWR800.
+
+/** The configuration of one sensor.
+ * @struct SensorConfigRecord */
+struct SensorConfigRecord{
+	uint8_t model; ///< The SENSOR_MODEL of the sensor.
+	uint8_t channel; ///< The channel nibble, such as V2_CHANNEL_1.
+	uint8_t tempDeadband; ///< The change in temperature that is not reported, in tenths of a degree.
+	uint8_t humidityDeadband; ///< The change in humidity that is not reported, in percent.
+	uint8_t silenceMinutes; ///< The longest time the sensor goes unreported in minutes, or 0 for the default.
+};
+
+/** SensorConfig holds the records of the sensors a device listens for.
+ * @class SensorConfig */
+class SensorConfig
+{
+public:
+	/** The constructor, which starts with no sensors. */
+	SensorConfig();
+	/** Removes every record. */
+	void clear();
+	/** Adds a record.
+	 * @param model The SENSOR_MODEL of the sensor.
+	 * @param channel The channel nibble.
+	 * @param tempDeadband The deadband of the temperature (in tenths of a degree).
+	 * @param humidityDeadband The deadband of the humidity (in percent).
+	 * @param silenceMinutes The longest silence (in minutes), 0 for the default.
+	 * @return False if the configuration is full or the model is not known. */
+	boolean add(uint8_t model, uint8_t channel, uint8_t tempDeadband, uint8_t humidityDeadband, uint8_t silenceMinutes);
+	/** Replaces the records, as when they are read back from the EEPROM.
+	 * @param *records The records.
+	 * @param count The number of records.
+	 * @return False, with the configuration left as it was, if they are not valid. */
+	boolean setRecords(const SensorConfigRecord *records, uint8_t count);
+	/** Gets the records. */
+	const SensorConfigRecord *getRecords() const;
+	/** Gets the number of records. */
+	uint8_t getCount() const;
+	/** Reads the records from hex digits, up to the first character that is not one.
+	 * @param *hex The digits.
+	 * @return False, with the configuration left as it was, if they are not valid or hold no record. */
+	boolean parseHex(const char *hex);
+	/** Writes the records as hex digits.
+	 * @param *buffer The buffer that receives them, of SENSOR_CONFIG_HEX_SIZE characters. */
+	void toHex(char *buffer) const;
+	/** Computes the checksum the EEPROM keeps with the records, the complement of their sum with the count. */
+	uint8_t checksum() const;
+	/** Compares two configurations, record by record. */
+	boolean equals(const SensorConfig &other) const;
+	/** Checks whether a model is known to the firmware. */
+	static boolean isKnownModel(uint8_t model);
+private:
+	SensorConfigRecord records[SENSOR_CONFIG_MAX_RECORDS];
+	uint8_t count;
+};
+
+#endif // SENSOR_CONFIG_H
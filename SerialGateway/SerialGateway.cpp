@@ -0,0 +1,124 @@
+#include <SerialGateway.h>
+
+SerialGateway::SerialGateway(Print &out) : out(out){
+	records = 0;
+}
+
+void SerialGateway::sendFrame(uint32_t time, uint32_t sensorId, uint8_t channel, uint8_t protocol,
+	uint8_t flags, int16_t rssi, const uint8_t *nibbles, uint8_t size){
+	uint8_t record[GATEWAY_MAX_RECORD];
+	uint8_t encoded[GATEWAY_MAX_ENCODED];
+	uint8_t length = packFrame(time, sensorId, channel, protocol, flags, rssi, nibbles, size, record);
+	// The record goes out in one write so the Serial buffer takes it whole
+	out.write(encoded, cobsEncode(record, length, encoded));
+	records++;
+}
+
+uint32_t SerialGateway::getRecords(){
+	return records;
+}
+
+static void putLong(uint8_t *p, uint32_t value){
+	for(uint8_t i = 0; i < 4; i++){
+		p[i] = value >> (8 * i);
+	}
+}
+
+static uint32_t getLong(const uint8_t *p){
+	return p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+uint8_t SerialGateway::packFrame(uint32_t time, uint32_t sensorId, uint8_t channel, uint8_t protocol,
+	uint8_t flags, int16_t rssi, const uint8_t *nibbles, uint8_t size, uint8_t *record){
+	if(size > GATEWAY_MAX_NIBBLES){
+		size = GATEWAY_MAX_NIBBLES;
+	}
+	record[0] = GATEWAY_RECORD_FRAME;
+	putLong(record + 1, time);
+	putLong(record + 5, sensorId);
+	record[9] = channel;
+	record[10] = protocol;
+	record[11] = flags;
+	record[12] = rssi < -128 ? -128 : (rssi > 127 ? 127 : rssi);
+	record[13] = size;
+	uint8_t length = GATEWAY_HEADER_SIZE;
+	for(uint8_t i = 0; i < size; i += 2){
+		record[length++] = (nibbles[i] << 4) | (i + 1 < size ? nibbles[i + 1] & 0x0F : 0);
+	}
+	uint16_t crc = crc16(record, length);
+	record[length++] = crc & 0xFF;
+	record[length++] = crc >> 8;
+	return length;
+}
+
+boolean SerialGateway::parseRecord(const uint8_t *record, size_t length, GatewayFrame &frame){
+	if(length < GATEWAY_HEADER_SIZE + GATEWAY_CRC_SIZE || record[0] != GATEWAY_RECORD_FRAME){
+		return false;
+	}
+	uint8_t size = record[13];
+	if(size > GATEWAY_MAX_NIBBLES || length != (size_t) (GATEWAY_HEADER_SIZE + (size + 1) / 2 + GATEWAY_CRC_SIZE)){
+		return false;
+	}
+	uint16_t crc = record[length - 2] | (record[length - 1] << 8);
+	if(crc16(record, length - GATEWAY_CRC_SIZE) != crc){
+		return false;
+	}
+	frame.time = getLong(record + 1);
+	frame.sensorId = getLong(record + 5);
+	frame.channel = record[9];
+	frame.protocol = record[10];
+	frame.flags = record[11];
+	frame.rssi = (int8_t) record[12];
+	frame.size = size;
+	frame.packed = record + GATEWAY_HEADER_SIZE;
+	return true;
+}
+
+uint16_t SerialGateway::crc16(const uint8_t *data, size_t length){
+	uint16_t crc = 0xFFFF;
+	for(size_t i = 0; i < length; i++){
+		crc ^= (uint16_t) data[i] << 8;
+		for(uint8_t bit = 0; bit < 8; bit++){
+			crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+		}
+	}
+	return crc;
+}
+
+size_t SerialGateway::cobsEncode(const uint8_t *data, size_t length, uint8_t *out){
+	// Every zero is replaced by the distance to the next one, starting with the code byte
+	size_t code = 0;
+	size_t o = 1;
+	for(size_t i = 0; i < length; i++){
+		if(data[i] == 0){
+			out[code] = o - code;
+			code = o++;
+		}else{
+			out[o++] = data[i];
+		}
+	}
+	out[code] = o - code;
+	out[o++] = 0;
+	return o;
+}
+
+size_t SerialGateway::cobsDecode(uint8_t *data, size_t length){
+	size_t o = 0;
+	size_t i = 0;
+	while(i < length){
+		uint8_t code = data[i];
+		if(code == 0 || i + code > length){
+			return 0;
+		}
+		// The output never passes the input, so the bytes can be moved down in place
+		for(uint8_t j = 1; j < code; j++){
+			data[o++] = data[i + j];
+		}
+		i += code;
+		// A full group of 254 bytes ends without a zero
+		if(i < length && code != 0xFF){
+			data[o++] = 0;
+		}
+	}
+	return o;
+}
@@ -0,0 +1,113 @@
+// File: SerialGateway.h
+// Description: Defines the binary records that the gateway environment
+// sends over Serial for every frame, and how they are framed and checked.
+
+/**
+ * The Serial Gateway hands every validated frame to a computer on the
+ * other end of the Serial port instead of the server. A frame becomes
+ * one record, with all of its fields little endian:
+ *
+ *   offset  size  field
+ *   0       1     GATEWAY_RECORD_FRAME
+ *   1       4     the time it was decoded, in milliseconds since boot
+ *   5       4     the device id of the sensor
+ *   9       1     the channel of the sensor
+ *   10      1     the protocol, OSCV_2_1 or OSCV_3
+ *   11      1     the GATEWAY_FLAG bits, how well it was decoded
+ *   12      1     the RSSI of its burst in dBm, -128 if not known
+ *   13      1     the number of nibbles
+ *   14      n/2   the nibbles, two to a byte with the first in the high half
+ *   ...     2     the CRC-16/CCITT-FALSE of all of the above
+ *
+ * Records are COBS encoded, which leaves no zero byte in them, and
+ * each is followed by a zero. A reader that starts in the middle of
+ * the stream, or loses bytes, finds the start of the next record at
+ * the next zero, and the CRC catches records that were damaged.
+ * @file SerialGateway.h */
+
+#ifndef SERIAL_GATEWAY_H
+#define SERIAL_GATEWAY_H
+
+#include <Arduino.h>
+
+#define GATEWAY_RECORD_FRAME 0x01 ///< Defines the type of a record that holds a frame.
+#define GATEWAY_FLAG_REPAIRED 0x01 ///< Defines the flag of a frame that failed its checksum and was repaired from its repeat.
+#define GATEWAY_FLAG_DROPPED 0x02 ///< Defines the flag of a frame decoded after the pulse buffer dropped pulses.
+#define GATEWAY_MAX_NIBBLES 32 ///< Defines the most nibbles a record can hold.
+#define GATEWAY_HEADER_SIZE 14 ///< Defines the bytes of a record before its nibbles.
+#define GATEWAY_CRC_SIZE 2 ///< Defines the bytes of the CRC.
+#define GATEWAY_MAX_RECORD (GATEWAY_HEADER_SIZE + GATEWAY_MAX_NIBBLES / 2 + GATEWAY_CRC_SIZE) ///< Defines the longest record before it is encoded.
+#define GATEWAY_MAX_ENCODED (GATEWAY_MAX_RECORD + 2) ///< Defines the longest record once encoded, with its COBS code and the zero that ends it.
+
+/** A record that was read back. The nibbles are not copied out of it.
+ * @struct GatewayFrame */
+struct GatewayFrame{
+	uint32_t time; ///< The time the frame was decoded, in milliseconds since boot.
+	uint32_t sensorId; ///< The device id of the sensor.
+	uint8_t channel; ///< The channel of the sensor.
+	uint8_t protocol; ///< OSCV_2_1 or OSCV_3.
+	uint8_t flags; ///< The GATEWAY_FLAG bits.
+	int8_t rssi; ///< The RSSI of the burst in dBm, -128 if not known.
+	uint8_t size; ///< The number of nibbles.
+	const uint8_t *packed; ///< The nibbles, two to a byte, inside the record.
+	/** Gets a nibble.
+	 * @param i The index of the nibble.
+	 * @return Its value. */
+	uint8_t nibble(uint8_t i) const{ return i & 1 ? packed[i >> 1] & 0x0F : packed[i >> 1] >> 4; }
+};
+
+/** SerialGateway writes frames to a stream as framed binary records.
+ * @class SerialGateway */
+class SerialGateway
+{
+public:
+	/** The constructor.
+	 * @param &out Where the records are written, such as Serial. */
+	SerialGateway(Print &out);
+	/** Writes a frame as one record.
+	 * @param time The time the frame was decoded, in milliseconds.
+	 * @param sensorId The device id of the sensor.
+	 * @param channel The channel of the sensor.
+	 * @param protocol OSCV_2_1 or OSCV_3.
+	 * @param flags The GATEWAY_FLAG bits.
+	 * @param rssi The RSSI of the burst (in dBm).
+	 * @param *nibbles The nibbles of the frame, one to a byte.
+	 * @param size The number of nibbles, at most GATEWAY_MAX_NIBBLES. */
+	void sendFrame(uint32_t time, uint32_t sensorId, uint8_t channel, uint8_t protocol,
+		uint8_t flags, int16_t rssi, const uint8_t *nibbles, uint8_t size);
+	/** Gets the number of records written. */
+	uint32_t getRecords();
+	/** Packs a frame into a record, with its CRC.
+	 * The parameters are those of sendFrame.
+	 * @param *record The buffer that receives it, of GATEWAY_MAX_RECORD bytes.
+	 * @return The length of the record. */
+	static uint8_t packFrame(uint32_t time, uint32_t sensorId, uint8_t channel, uint8_t protocol,
+		uint8_t flags, int16_t rssi, const uint8_t *nibbles, uint8_t size, uint8_t *record);
+	/** Reads a record back and checks its length and CRC.
+	 * @param *record The decoded record.
+	 * @param length Its length.
+	 * @param &frame Receives the fields, which point into the record.
+	 * @return False if the record is not a whole frame or its CRC is wrong. */
+	static boolean parseRecord(const uint8_t *record, size_t length, GatewayFrame &frame);
+	/** Computes the CRC-16/CCITT-FALSE of some bytes.
+	 * @param *data The bytes.
+	 * @param length The number of bytes.
+	 * @return The CRC. */
+	static uint16_t crc16(const uint8_t *data, size_t length);
+	/** COBS encodes bytes and ends them with a zero.
+	 * @param *data The bytes, at most 254 of them.
+	 * @param length The number of bytes.
+	 * @param *out The buffer that receives them, two bytes longer than the input.
+	 * @return The length written, with the zero. */
+	static size_t cobsEncode(const uint8_t *data, size_t length, uint8_t *out);
+	/** Decodes COBS in place, which only ever shortens it.
+	 * @param *data The encoded bytes, without the zero that ended them.
+	 * @param length The number of bytes.
+	 * @return The decoded length, or 0 if the bytes were not valid COBS. */
+	static size_t cobsDecode(uint8_t *data, size_t length);
+private:
+	Print &out;
+	uint32_t records;
+};
+
+#endif // SERIAL_GATEWAY_H
@@ -23,8 +23,9 @@ boolean WordBuffer::insert(word val){
     insertIdx %= max_size;
     arr[insertIdx++] = val;
     numItems++;
+    return true;
   }else{
-    return -1;
+    return false;
   }
 }
 